@@ -683,6 +683,23 @@ ErrorCorrectPostProcess::ErrorCorrectPostProcess(std::ostream* pCorrectedWriter,
 std::ostream* pDiscardWriter,
 bool bCollectMetrics) :
 m_pCorrectedWriter(pCorrectedWriter),
+m_pCorrectedTable(NULL),
+m_pDiscardWriter(pDiscardWriter),
+m_bCollectMetrics(bCollectMetrics),
+m_totalBases(0), m_totalErrors(0),
+m_readsKept(0), m_readsDiscarded(0),
+m_kmerQCPassed(0), m_overlapQCPassed(0),
+m_qcFail(0)
+{
+
+}
+
+//
+ErrorCorrectPostProcess::ErrorCorrectPostProcess(PackedReadTable* pCorrectedTable,
+std::ostream* pDiscardWriter,
+bool bCollectMetrics) :
+m_pCorrectedWriter(NULL),
+m_pCorrectedTable(pCorrectedTable),
 m_pDiscardWriter(pDiscardWriter),
 m_bCollectMetrics(bCollectMetrics),
 m_totalBases(0), m_totalErrors(0),
@@ -715,6 +732,17 @@ void ErrorCorrectPostProcess::writeMetrics(std::ostream* pWriter)
 	" reads (" << (double)m_readsDiscarded / (m_readsKept + m_readsDiscarded)<< ")\n";
 }
 
+//
+void ErrorCorrectPostProcess::registerCheckpoint(Checkpoint* pCheckpoint)
+{
+	pCheckpoint->addCounter("totalBases", &m_totalBases);
+	pCheckpoint->addCounter("totalErrors", &m_totalErrors);
+	pCheckpoint->addCounter("readsKept", &m_readsKept);
+	pCheckpoint->addCounter("readsDiscarded", &m_readsDiscarded);
+	pCheckpoint->addCounter("kmerQCPassed", &m_kmerQCPassed);
+	pCheckpoint->addCounter("overlapQCPassed", &m_overlapQCPassed);
+	pCheckpoint->addCounter("qcFail", &m_qcFail);
+}
 
 //
 void ErrorCorrectPostProcess::process(const SequenceWorkItem& item, const ErrorCorrectResult& result)
@@ -753,7 +781,10 @@ void ErrorCorrectPostProcess::process(const SequenceWorkItem& item, const ErrorC
 
 	else if  (readQCPass || m_pDiscardWriter == NULL)
 	{
-		record.write(*m_pCorrectedWriter);
+		if(m_pCorrectedTable != NULL)
+			m_pCorrectedTable->addRead(record);
+		else
+			record.write(*m_pCorrectedWriter);
 		++m_readsKept;
 	}
 	else
@@ -20,6 +20,7 @@
 #include "BWTIndexSet.h"
 #include "SampledSuffixArray.h"
 #include "multiple_alignment.h"
+#include "PackedReadTable.h"
 
 enum ErrorCorrectAlgorithm
 {
@@ -137,11 +138,19 @@ class ErrorCorrectPostProcess
         ErrorCorrectPostProcess(std::ostream* pCorrectedWriter,
                                 std::ostream* pDiscardWriter, bool bCollectMetrics);
 
+        // Add the corrected reads to pCorrectedTable instead of writing them out
+        ErrorCorrectPostProcess(PackedReadTable* pCorrectedTable,
+                                std::ostream* pDiscardWriter, bool bCollectMetrics);
+
         ~ErrorCorrectPostProcess();
 
         void process(const SequenceWorkItem& item, const ErrorCorrectResult& result);
         void writeMetrics(std::ostream* pWriter);
 
+        // Save the read and base counters with each checkpoint of the run.
+        // The per-position metrics are not saved.
+        void registerCheckpoint(Checkpoint* pCheckpoint);
+
 		/**********************************************************************************************/
 		void process(const SequenceWorkItemPair& itemPair, const ErrorCorrectResult& result);
 
@@ -151,6 +160,7 @@ class ErrorCorrectPostProcess
                             const std::string& correctedSeq, const std::string& qualityStr);
 
         std::ostream* m_pCorrectedWriter;
+        PackedReadTable* m_pCorrectedTable;
         std::ostream* m_pDiscardWriter;
         bool m_bCollectMetrics;
 
@@ -11,7 +11,7 @@
 #include "SGVisitors.h"
 
 //
-FMMergeProcess::FMMergeProcess(const OverlapAlgorithm* pOverlapper, int minOverlap, BitVector* pMarkedReads) : 
+FMMergeProcess::FMMergeProcess(const OverlapAlgorithm* pOverlapper, int minOverlap, AtomicBitVector* pMarkedReads) : 
                                      m_pOverlapper(pOverlapper), 
                                      m_minOverlap(minOverlap), 
                                      m_pMarkedReads(pMarkedReads)
@@ -154,14 +154,13 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
         // Check if the bit in the vector has already been set for the lowest read index
         // If it has some other thread has already output this set so we do nothing
         int64_t lowestIndex = result.usedIntervals.front().lower;
-        bool currentValue = m_pMarkedReads->test(lowestIndex);
         bool updateSuccess = false;
 
-        if(currentValue == false)
+        if(!m_pMarkedReads->test(lowestIndex))
         {
-            // Attempt to update the bit vector with an atomic CAS. If this returns false
+            // Attempt to set the bit atomically. If this returns false
             // the bit was set by some other thread
-            updateSuccess = m_pMarkedReads->updateCAS(lowestIndex, currentValue, true);
+            updateSuccess = m_pMarkedReads->testAndSet(lowestIndex);
         }
 
         if(updateSuccess)
@@ -177,16 +176,11 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
                     if(i == lowestIndex) //already set
                         continue;
 
-                    currentValue = m_pMarkedReads->test(i);
-                    if(currentValue)
+                    if(!m_pMarkedReads->testAndSet(i))
                     {
                         // This value should not be true, emit a warning
                         std::cout << "Warning: Bit " << i << " was set outside of critical section\n";
                     }
-                    else
-                    {
-                        m_pMarkedReads->updateCAS(i, currentValue, true);
-                    }
                 }
             }
         }
@@ -287,11 +281,11 @@ void FMMergeProcess::addCandidates(StringGraph* pGraph, const Vertex* pX, const
 }
 
 //
-FMMergePostProcess::FMMergePostProcess(std::ostream* pWriter, BitVector* pMarkedReads) : m_numMerged(0), 
-                                                                                          m_numTotal(0), 
-                                                                                          m_totalLength(0), 
-                                                                                          m_pWriter(pWriter), 
-                                                                                          m_pMarkedReads(pMarkedReads)
+FMMergePostProcess::FMMergePostProcess(std::ostream* pWriter, AtomicBitVector* pMarkedReads) : m_numMerged(0), 
+                                                                                                m_numTotal(0), 
+                                                                                                m_totalLength(0), 
+                                                                                                m_pWriter(pWriter), 
+                                                                                                m_pMarkedReads(pMarkedReads)
 {
 
 }
@@ -12,7 +12,7 @@
 #include "Util.h"
 #include "OverlapAlgorithm.h"
 #include "SequenceProcessFramework.h"
-#include "BitVector.h"
+#include "AtomicBitVector.h"
 #include "Bigraph.h"
 #include "SGUtil.h"
 
@@ -43,7 +43,7 @@ class FMMergeProcess
 {
     public:
         FMMergeProcess(const OverlapAlgorithm* pOverlapper, 
-                       int minOverlap, BitVector* pMarkedReads);
+                       int minOverlap, AtomicBitVector* pMarkedReads);
 
         ~FMMergeProcess();
 
@@ -67,14 +67,14 @@ class FMMergeProcess
 
         const OverlapAlgorithm* m_pOverlapper;
         const int m_minOverlap;
-        BitVector* m_pMarkedReads;
+        AtomicBitVector* m_pMarkedReads;
 };
 
 // Write the results from the overlap step to an ASQG file
 class FMMergePostProcess
 {
     public:
-        FMMergePostProcess(std::ostream* pWriter, BitVector* pMarkedReads);
+        FMMergePostProcess(std::ostream* pWriter, AtomicBitVector* pMarkedReads);
         ~FMMergePostProcess();
         
         void process(const SequenceWorkItem& item, const FMMergeResult& result);
@@ -85,7 +85,7 @@ class FMMergePostProcess
         size_t m_totalLength;
 
         std::ostream* m_pWriter;
-        BitVector* m_pMarkedReads;
+        AtomicBitVector* m_pMarkedReads;
 };
 
 #endif
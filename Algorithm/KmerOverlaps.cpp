@@ -65,6 +65,84 @@ struct KmerMatchKey
 typedef std::set<KmerMatch> KmerMatchSet;
 typedef HashMap<KmerMatch, bool, KmerMatchKey> KmerMatchMap;
 
+// Candidates whose overlap region is shorter than this are always aligned
+static const int MIN_FILTER_LENGTH = 16;
+
+// Seeded candidates are collected in batches of this size so the edit distance
+// filters of a batch run together, in the lanes of Overlapper::searchEditDistances
+static const size_t CANDIDATE_BATCH_SIZE = 32;
+
+// A read found by the kmer seeds of the query
+struct KmerCandidate
+{
+    std::string sequence;
+    size_t pos_0;
+    size_t pos_1;
+    bool is_reverse;
+
+    // The kmer occurs more than once in one of the reads, so the slow overlapper is used
+    bool bSecondaryOccurrence;
+
+    // Index of the edit distance filter of the candidate in the batch, -1 if it is not filtered
+    int filterIdx;
+};
+
+// Add the edit distance filter of the overlap implied by the seed at pos_0 and pos_1
+// to the batch, to check whether it can pass the identity threshold before running
+// the banded alignment. The query overlap less half a band at each end is always
+// aligned within half a band of the seed diagonal, so its distance to that window of
+// the match is a lower bound on the edits of the alignment. The alignment covers at
+// most the query bases the band reaches, and each of its columns past those bases is
+// an edit, so it passes the identity threshold only if its edits are within
+// (1 - min_identity) / min_identity of that span. The candidate is rejected if the
+// window alone has more edits. Returns false if the window is too short to filter.
+static bool addEditDistanceFilter(const std::string& query, const std::string& match,
+                                  int pos_0, int pos_1, int bandwidth, double min_identity,
+                                  StringVector& patterns, StringVector& texts, std::vector<int>& maxDists)
+{
+    if(min_identity <= 0)
+        return false;
+
+    int query_length = query.length();
+    int match_length = match.length();
+    int half_width = bandwidth / 2;
+    int margin = half_width + 1;
+
+    // Query base q lies on the seed diagonal with match base q - diagonal
+    int diagonal = pos_0 - pos_1;
+    int query_start = std::max(0, diagonal) + margin;
+    int query_end = std::min(query_length, diagonal + match_length) - margin;
+    if(query_end - query_start < MIN_FILTER_LENGTH)
+        return false;
+
+    int match_start = std::max(0, query_start - diagonal - margin);
+    int match_end = std::min(match_length, query_end - diagonal + margin);
+    if(match_start >= match_end)
+        return false;
+
+    // The query bases within the band of Overlapper::extendMatch
+    int band_span = std::min(query_length, diagonal + match_length + half_width) - std::max(0, diagonal - half_width);
+
+    patterns.push_back(query.substr(query_start, query_end - query_start));
+    texts.push_back(match.substr(match_start, match_end - match_start));
+    maxDists.push_back((int)((1 - min_identity) * band_span / min_identity + 1e-6));
+    return true;
+}
+
+// Check the edit distance filter of a single candidate
+static bool passesEditDistanceFilter(const std::string& query, const std::string& match,
+                                     int pos_0, int pos_1, int bandwidth, double min_identity)
+{
+    StringVector patterns;
+    StringVector texts;
+    std::vector<int> maxDists;
+    std::vector<int> distances;
+    if(!addEditDistanceFilter(query, match, pos_0, pos_1, bandwidth, min_identity, patterns, texts, maxDists))
+        return true;
+    Overlapper::searchEditDistances(patterns, texts, maxDists, distances);
+    return distances[0] <= maxDists[0];
+}
+
 //
 SequenceOverlapPairVector KmerOverlaps::retrieveMatches(const std::string& query,
                                                         size_t k,
@@ -180,58 +258,95 @@ SequenceOverlapPairVector KmerOverlaps::retrieveMatches(const std::string& query
     // Refine the matches by computing proper overlaps between the sequences
     // Use the overlaps that meet the thresholds to build a multiple alignment
     int64_t maxAlignSeq=0;
-    for(KmerMatchSet::iterator iter = matches.begin(); iter != matches.end()
-        && maxAlignSeq<= max_interval_size; ++iter)
+    KmerMatchSet::iterator iter = matches.begin();
+    std::vector<KmerCandidate> candidates;
+    StringVector patterns;
+    StringVector texts;
+    std::vector<int> maxDists;
+    std::vector<int> distances;
+    while(iter != matches.end() && maxAlignSeq <= max_interval_size)
     {
-        std::string match_sequence = BWTAlgorithms::extractString(indices.pBWT, iter->index);
-        if(iter->is_reverse)
-            match_sequence = reverseComplement(match_sequence);
+        candidates.clear();
+        patterns.clear();
+        texts.clear();
+        maxDists.clear();
+        for(; iter != matches.end() && candidates.size() < CANDIDATE_BATCH_SIZE; ++iter)
+        {
+            KmerCandidate candidate;
+            candidate.sequence = BWTAlgorithms::extractString(indices.pBWT, iter->index);
+            if(iter->is_reverse)
+                candidate.sequence = reverseComplement(candidate.sequence);
 
-        // Ignore identical matches
-        if(match_sequence == query)
-            continue;
+            // Ignore identical matches
+            if(candidate.sequence == query)
+                continue;
 
-
-        // Compute the overlap. If the kmer match occurs a single time in each sequence we use
-        // the banded extension overlap strategy. Otherwise we use the slow O(M*N) overlapper.
-        SequenceOverlap overlap;
-        std::string match_kmer = query.substr(iter->position, k);
-        //size_t pos_0 = query.find(match_kmer);
-		size_t pos_0 = iter->position;
-        size_t pos_1 = match_sequence.find(match_kmer);
-        assert(pos_0 != std::string::npos && pos_1 != std::string::npos);
-
-		//assume gaps occupy at most half of the misaligned positions 
-        size_t bandwidth=query.length()*(1-min_identity);
-
-        //The pos of two kmers shouldn't differ more than the min_overlap allowed
-        size_t maxshift = query.length()-min_overlap+bandwidth/2;
-        if(abs(pos_0-pos_1) > maxshift)
-            continue;
-
-        // Check for secondary occurrences
-        if(query.find(match_kmer, pos_0 + 1) != std::string::npos ||
-           match_sequence.find(match_kmer, pos_1 + 1) != std::string::npos) {
-            // One of the reads has a second occurrence of the kmer. Use the slow overlapper.
-            overlap = Overlapper::computeOverlap(query, match_sequence);
-        } else {
-            overlap = Overlapper::extendMatch(query, match_sequence, pos_0, pos_1, bandwidth);
+            std::string match_kmer = query.substr(iter->position, k);
+            //size_t pos_0 = query.find(match_kmer);
+            size_t pos_0 = iter->position;
+            size_t pos_1 = candidate.sequence.find(match_kmer);
+            assert(pos_0 != std::string::npos && pos_1 != std::string::npos);
+
+            //assume gaps occupy at most half of the misaligned positions 
+            size_t bandwidth=query.length()*(1-min_identity);
+
+            //The pos of two kmers shouldn't differ more than the min_overlap allowed
+            size_t maxshift = query.length()-min_overlap+bandwidth/2;
+            if(abs(pos_0-pos_1) > maxshift)
+                continue;
+
+            candidate.pos_0 = pos_0;
+            candidate.pos_1 = pos_1;
+            candidate.is_reverse = iter->is_reverse;
+
+            // Check for secondary occurrences
+            candidate.bSecondaryOccurrence = query.find(match_kmer, pos_0 + 1) != std::string::npos ||
+                                             candidate.sequence.find(match_kmer, pos_1 + 1) != std::string::npos;
+            candidate.filterIdx = -1;
+            if(!candidate.bSecondaryOccurrence &&
+               addEditDistanceFilter(query, candidate.sequence, pos_0, pos_1, bandwidth, min_identity, patterns, texts, maxDists))
+                candidate.filterIdx = patterns.size() - 1;
+            candidates.push_back(candidate);
         }
 
-        n_candidates += 1;
-        bool bPassedOverlap = overlap.getOverlapLength() >= min_overlap;
-        bool bPassedIdentity = overlap.getPercentIdentity() / 100 >= min_identity;
+        Overlapper::searchEditDistances(patterns, texts, maxDists, distances);
 
-        if(bPassedOverlap && bPassedIdentity)
+        // Refine the matches by computing proper overlaps between the sequences
+        // Use the overlaps that meet the thresholds to build a multiple alignment
+        for(size_t i = 0; i < candidates.size() && maxAlignSeq <= max_interval_size; ++i)
         {
-            SequenceOverlapPair op;
-            //op.sequence[0] = query;
-            op.sequence[1] = match_sequence;
-            op.overlap = overlap;
-            op.is_reversed = iter->is_reverse;
-            overlap_vector.push_back(op);
-            n_output += 1;
-            maxAlignSeq++;
+            const KmerCandidate& candidate = candidates[i];
+            if(candidate.filterIdx >= 0 && distances[candidate.filterIdx] > maxDists[candidate.filterIdx])
+                continue;
+
+            // Compute the overlap. If the kmer match occurs a single time in each sequence we use
+            // the banded extension overlap strategy. Otherwise we use the slow O(M*N) overlapper.
+            SequenceOverlap overlap;
+            if(candidate.bSecondaryOccurrence)
+            {
+                overlap = Overlapper::computeOverlap(query, candidate.sequence);
+            }
+            else
+            {
+                size_t bandwidth=query.length()*(1-min_identity);
+                overlap = Overlapper::extendMatch(query, candidate.sequence, candidate.pos_0, candidate.pos_1, bandwidth);
+            }
+
+            n_candidates += 1;
+            bool bPassedOverlap = overlap.getOverlapLength() >= min_overlap;
+            bool bPassedIdentity = overlap.getPercentIdentity() / 100 >= min_identity;
+
+            if(bPassedOverlap && bPassedIdentity)
+            {
+                SequenceOverlapPair op;
+                //op.sequence[0] = query;
+                op.sequence[1] = candidate.sequence;
+                op.overlap = overlap;
+                op.is_reversed = candidate.is_reverse;
+                overlap_vector.push_back(op);
+                n_output += 1;
+                maxAlignSeq++;
+            }
         }
     }
     //std::cout << maxAlignSeq << std::endl;
@@ -453,6 +568,8 @@ void _approximateSeededMatch(const std::string& in_query,
                 // the slow overlapper.
                 overlap = Overlapper::computeOverlap(in_query, match_sequence);
             } else {
+                if(!passesEditDistanceFilter(in_query, match_sequence, pos_0, pos_1, bandwidth, min_identity))
+                    continue;
                 overlap = Overlapper::extendMatch(in_query, match_sequence, pos_0, pos_1, bandwidth);
             }
 
@@ -0,0 +1,244 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// MinimizerIndex - Sketch of the reads by their (w,k)
+// minimizers, used to propose the reads that a query
+// may overlap before the FM-index search
+//
+#include <assert.h>
+#include <algorithm>
+#include "MinimizerIndex.h"
+#include "SeqReader.h"
+
+static const uint64_t INVALID_HASH = (uint64_t)-1;
+
+// Invertible integer hash so the minimizers are not biased towards poly-A k-mers
+static inline uint64_t hashKmer(uint64_t key, uint64_t mask)
+{
+    key = (~key + (key << 21)) & mask;
+    key = key ^ (key >> 24);
+    key = ((key + (key << 3)) + (key << 8)) & mask;
+    key = key ^ (key >> 14);
+    key = ((key + (key << 2)) + (key << 4)) & mask;
+    key = key ^ (key >> 28);
+    key = (key + (key << 31)) & mask;
+    return key;
+}
+
+// A shared minimizer between the query and a read of the index
+struct MinimizerVote
+{
+    uint32_t readIdx;
+    bool isReverse;
+    int diag;
+    int start;
+    int end;
+
+    bool operator<(const MinimizerVote& other) const
+    {
+        if(readIdx != other.readIdx)
+            return readIdx < other.readIdx;
+        if(isReverse != other.isReverse)
+            return isReverse < other.isReverse;
+        return diag < other.diag;
+    }
+};
+
+//
+MinimizerIndex::MinimizerIndex(const std::string& readsFile, int k, int w) : m_k(k),
+                                                                             m_w(w),
+                                                                             m_minShared(DEFAULT_MIN_SHARED),
+                                                                             m_maxOccurrences(DEFAULT_MAX_OCCURRENCES),
+                                                                             m_bSkipSelf(false)
+{
+    assert(m_k > 0 && m_k <= 31 && m_w > 0);
+
+    SeqReader reader(readsFile, SRF_NO_VALIDATION);
+    SeqRecord record;
+    MinimizerVector minimizers;
+    while(reader.get(record))
+    {
+        std::string seq = record.seq.toString();
+        uint32_t readIdx = m_lengths.size();
+        m_lengths.push_back(seq.length());
+
+        computeMinimizers(seq, minimizers);
+        for(MinimizerVector::const_iterator iter = minimizers.begin(); iter != minimizers.end(); ++iter)
+        {
+            Entry entry;
+            entry.hash = iter->hash;
+            entry.readIdx = readIdx;
+            entry.pos = (iter->pos << 1) | (iter->isReverse ? 1 : 0);
+            m_entries.push_back(entry);
+        }
+    }
+
+    std::sort(m_entries.begin(), m_entries.end());
+
+    // Release the unused capacity
+    EntryVector(m_entries).swap(m_entries);
+    std::vector<uint32_t>(m_lengths).swap(m_lengths);
+}
+
+//
+void MinimizerIndex::computeMinimizers(const std::string& seq, MinimizerVector& out) const
+{
+    out.clear();
+    int len = seq.length();
+    if(len < m_k)
+        return;
+
+    // Hash the canonical strand of every k-mer
+    uint64_t mask = ((uint64_t)1 << (2 * m_k)) - 1;
+    int shift = 2 * (m_k - 1);
+    uint64_t fwd = 0;
+    uint64_t rev = 0;
+    int numValid = 0;
+    MinimizerVector kmers(len - m_k + 1);
+    for(int i = 0; i < len; ++i)
+    {
+        uint64_t code;
+        switch(seq[i])
+        {
+            case 'A': code = 0; break;
+            case 'C': code = 1; break;
+            case 'G': code = 2; break;
+            case 'T': code = 3; break;
+            default: code = 4; break;
+        }
+
+        if(code > 3)
+        {
+            fwd = rev = 0;
+            numValid = 0;
+        }
+        else
+        {
+            fwd = ((fwd << 2) | code) & mask;
+            rev = (rev >> 2) | ((3 - code) << shift);
+            ++numValid;
+        }
+
+        if(i < m_k - 1)
+            continue;
+
+        // Palindromic k-mers have no strand and are skipped
+        Minimizer& kmer = kmers[i - m_k + 1];
+        kmer.pos = i - m_k + 1;
+        kmer.hash = INVALID_HASH;
+        kmer.isReverse = false;
+        if(numValid >= m_k && fwd != rev)
+        {
+            uint64_t fwdHash = hashKmer(fwd, mask);
+            uint64_t revHash = hashKmer(rev, mask);
+            kmer.isReverse = revHash < fwdHash;
+            kmer.hash = kmer.isReverse ? revHash : fwdHash;
+        }
+    }
+
+    // Keep the smallest hash of every window of w k-mers. The chosen positions
+    // never decrease so a repeated choice is the same as the previous one.
+    size_t numKmers = kmers.size();
+    size_t numWindows = numKmers >= (size_t)m_w ? numKmers - m_w + 1 : 1;
+    int lastPos = -1;
+    for(size_t i = 0; i < numWindows; ++i)
+    {
+        size_t best = i;
+        size_t windowEnd = std::min(i + m_w, numKmers);
+        for(size_t j = i + 1; j < windowEnd; ++j)
+        {
+            if(kmers[j].hash < kmers[best].hash)
+                best = j;
+        }
+
+        if(kmers[best].hash != INVALID_HASH && kmers[best].pos != lastPos)
+        {
+            out.push_back(kmers[best]);
+            lastPos = kmers[best].pos;
+        }
+    }
+}
+
+//
+void MinimizerIndex::findCandidates(const std::string& seq, int band, CandidateRegionVector& out) const
+{
+    out.clear();
+    int queryLength = seq.length();
+    MinimizerVector minimizers;
+    computeMinimizers(seq, minimizers);
+
+    // Each occurrence of a query minimizer votes for the read and the diagonal
+    // it implies, along with the region of the query the read would cover
+    std::vector<MinimizerVote> votes;
+    int numLookups = 0;
+    for(MinimizerVector::const_iterator iter = minimizers.begin(); iter != minimizers.end(); ++iter)
+    {
+        Entry key;
+        key.hash = iter->hash;
+        std::pair<EntryVector::const_iterator, EntryVector::const_iterator> range = std::equal_range(m_entries.begin(), m_entries.end(), key);
+        if((size_t)(range.second - range.first) > m_maxOccurrences)
+            continue;
+        ++numLookups;
+
+        for(EntryVector::const_iterator entryIter = range.first; entryIter != range.second; ++entryIter)
+        {
+            int targetPos = entryIter->pos >> 1;
+            int targetLength = m_lengths[entryIter->readIdx];
+
+            MinimizerVote vote;
+            vote.readIdx = entryIter->readIdx;
+            vote.isReverse = iter->isReverse != ((entryIter->pos & 1) != 0);
+            if(!vote.isReverse)
+            {
+                // Query base q aligns to target base q - diag
+                vote.diag = iter->pos - targetPos;
+                vote.start = std::max(0, vote.diag);
+                vote.end = std::min(queryLength, vote.diag + targetLength);
+            }
+            else
+            {
+                // Query base q aligns to the complement of target base diag - q
+                vote.diag = iter->pos + targetPos + m_k - 1;
+                vote.start = std::max(0, vote.diag - targetLength + 1);
+                vote.end = std::min(queryLength, vote.diag + 1);
+            }
+            votes.push_back(vote);
+        }
+    }
+
+    std::sort(votes.begin(), votes.end());
+
+    // The query itself is found once on the main diagonal with every minimizer
+    bool bSkipSelf = m_bSkipSelf;
+    size_t i = 0;
+    while(i < votes.size())
+    {
+        const MinimizerVote& first = votes[i];
+        int start = first.start;
+        int end = first.end;
+        size_t j = i + 1;
+        while(j < votes.size() && votes[j].readIdx == first.readIdx &&
+              votes[j].isReverse == first.isReverse && votes[j].diag - first.diag <= band)
+        {
+            start = std::min(start, votes[j].start);
+            end = std::max(end, votes[j].end);
+            ++j;
+        }
+
+        int numVotes = j - i;
+        bool isSelf = bSkipSelf && !first.isReverse && first.diag == 0 && votes[j - 1].diag == 0 &&
+                      (int)m_lengths[first.readIdx] == queryLength && numVotes == numLookups;
+        if(isSelf)
+        {
+            bSkipSelf = false;
+        }
+        else if(numVotes >= m_minShared && start < end)
+        {
+            CandidateRegion region = { start, end, first.isReverse };
+            out.push_back(region);
+        }
+        i = j;
+    }
+}
@@ -0,0 +1,90 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// MinimizerIndex - Sketch of the reads by their (w,k)
+// minimizers, used to propose the reads that a query
+// may overlap before the FM-index search. Each shared
+// minimizer votes for a read and the diagonal of the
+// alignment, and a read supported by enough votes on
+// one diagonal gives a candidate region of the query.
+//
+#ifndef MINIMIZERINDEX_H
+#define MINIMIZERINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// A region of the query, in query coordinates, that may
+// overlap another read. The end coordinate is exclusive.
+struct CandidateRegion
+{
+    int start;
+    int end;
+    bool isReverse;
+};
+typedef std::vector<CandidateRegion> CandidateRegionVector;
+
+class MinimizerIndex
+{
+    public:
+
+        static const int DEFAULT_K = 15;
+        static const int DEFAULT_W = 10;
+        static const int DEFAULT_MIN_SHARED = 2;
+
+        // Minimizers found in more reads than this are repeats and do not vote
+        static const size_t DEFAULT_MAX_OCCURRENCES = 256;
+
+        // Sketch the reads of the file. The k-mer length must be at most 31.
+        MinimizerIndex(const std::string& readsFile, int k = DEFAULT_K, int w = DEFAULT_W);
+
+        // The query reads are in the index, so skip the read matching itself
+        void setSkipSelf(bool b) { m_bSkipSelf = b; }
+        void setMinShared(int n) { m_minShared = n; }
+
+        // Find the regions of seq that are supported by at least minShared minimizers
+        // of some read on one diagonal, allowing the diagonal to drift by band bases
+        void findCandidates(const std::string& seq, int band, CandidateRegionVector& out) const;
+
+        size_t getNumReads() const { return m_lengths.size(); }
+        size_t getNumEntries() const { return m_entries.size(); }
+
+    private:
+
+        struct Entry
+        {
+            uint64_t hash;
+            uint32_t readIdx;
+            uint32_t pos; // position of the k-mer << 1 | 1 if the reverse complement is the minimizer
+
+            bool operator<(const Entry& other) const { return hash < other.hash; }
+        };
+        typedef std::vector<Entry> EntryVector;
+
+        // A minimizer of a query read
+        struct Minimizer
+        {
+            uint64_t hash;
+            int pos;
+            bool isReverse;
+        };
+        typedef std::vector<Minimizer> MinimizerVector;
+
+        // Compute the minimizers of seq, k-mers containing a non-ACGT base are skipped
+        void computeMinimizers(const std::string& seq, MinimizerVector& out) const;
+
+        int m_k;
+        int m_w;
+        int m_minShared;
+        size_t m_maxOccurrences;
+        bool m_bSkipSelf;
+
+        // Sorted by hash
+        EntryVector m_entries;
+        std::vector<uint32_t> m_lengths;
+};
+
+#endif
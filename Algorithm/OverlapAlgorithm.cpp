@@ -37,6 +37,26 @@ OverlapResult OverlapAlgorithm::overlapReadInexact(const SeqRecord& read, int mi
     OverlapBlockList obWorkingList;
     std::string seq = read.seq.toString();
 
+    // The four searches share the exact intervals of the seeds they have in common
+    SeedIntervalCache seedCache(seq.length());
+
+    // Find the regions of the read that share minimizers with other reads. Each search
+    // only extends the seeds in the regions of the overlaps it can find.
+    CandidateRegionVector candidates;
+    std::vector<bool> seedMasks[4];
+    const std::vector<bool>* pSeedMasks[4] = { NULL, NULL, NULL, NULL };
+    if(m_pMinimizerIndex != NULL)
+    {
+        int len = seq.length();
+        m_pMinimizerIndex->findCandidates(seq, static_cast<int>(m_errorRate * len) + 1, candidates);
+        buildSeedMask(candidates, len, false, false, seedMasks[0]);
+        buildSeedMask(candidates, len, true, false, seedMasks[1]);
+        buildSeedMask(candidates, len, true, true, seedMasks[2]);
+        buildSeedMask(candidates, len, false, true, seedMasks[3]);
+        for(int i = 0; i < 4; ++i)
+            pSeedMasks[i] = &seedMasks[i];
+    }
+
 #ifdef DEBUGOVERLAP
     std::cout << "\n\n***Overlapping read " << read.id << " suffix\n";
 #endif
@@ -47,14 +67,15 @@ OverlapResult OverlapAlgorithm::overlapReadInexact(const SeqRecord& read, int mi
     // case we dont run any of the subsequent commands and return no overlaps.
     bool valid = true;
     valid = findOverlapBlocksInexact(seq, m_pBWT, m_pRevBWT, sufPreAF, 
-                                     minOverlap, &obWorkingList, pOBOut, result);
+                                     minOverlap, &obWorkingList, pOBOut, result, pSeedMasks[0], &seedCache);
 
     if(valid)
         valid = findOverlapBlocksInexact(complement(seq), m_pRevBWT, m_pBWT, prePreAF, 
-                                         minOverlap, &obWorkingList, pOBOut, result);
+                                         minOverlap, &obWorkingList, pOBOut, result, pSeedMasks[1], &seedCache);
 
     if(valid)
     {
+        result.isSuperRepeat |= hasSuperRepeatBlocks(&obWorkingList, seq.length());
         if(m_bIrreducible)
         {
             computeIrreducibleBlocks(m_pBWT, m_pRevBWT, &obWorkingList, pOBOut);
@@ -73,13 +94,14 @@ OverlapResult OverlapAlgorithm::overlapReadInexact(const SeqRecord& read, int mi
 
     // Match the prefix of seq to suffixes
     if(valid)
-        valid = findOverlapBlocksInexact(reverseComplement(seq), m_pBWT, m_pRevBWT, sufSufAF, minOverlap, &obWorkingList, pOBOut, result);
+        valid = findOverlapBlocksInexact(reverseComplement(seq), m_pBWT, m_pRevBWT, sufSufAF, minOverlap, &obWorkingList, pOBOut, result, pSeedMasks[2], &seedCache);
     
     if(valid)
-        valid = findOverlapBlocksInexact(reverse(seq), m_pRevBWT, m_pBWT, preSufAF, minOverlap, &obWorkingList, pOBOut, result);
+        valid = findOverlapBlocksInexact(reverse(seq), m_pRevBWT, m_pBWT, preSufAF, minOverlap, &obWorkingList, pOBOut, result, pSeedMasks[3], &seedCache);
 
     if(valid)
     {
+        result.isSuperRepeat |= hasSuperRepeatBlocks(&obWorkingList, seq.length());
         if(m_bIrreducible)
         {
             computeIrreducibleBlocks(m_pBWT, m_pRevBWT, &obWorkingList, pOBOut);
@@ -111,8 +133,9 @@ OverlapResult OverlapAlgorithm::alignReadDuplicate(const SeqRecord& read, Overla
     std::string seq = read.seq.toString();
     int readLength = seq.length();
 
-    findOverlapBlocksInexact(seq, m_pBWT, m_pRevBWT, sufPreAF, readLength, &obWorkingList, pOBOut, result);
-    findOverlapBlocksInexact(complement(seq), m_pRevBWT, m_pBWT, prePreAF, readLength, &obWorkingList, pOBOut, result);
+    SeedIntervalCache seedCache(readLength);
+    findOverlapBlocksInexact(seq, m_pBWT, m_pRevBWT, sufPreAF, readLength, &obWorkingList, pOBOut, result, NULL, &seedCache);
+    findOverlapBlocksInexact(complement(seq), m_pRevBWT, m_pBWT, prePreAF, readLength, &obWorkingList, pOBOut, result, NULL, &seedCache);
     return result;
 }
 
@@ -146,33 +169,12 @@ OverlapResult OverlapAlgorithm::overlapReadExact(const SeqRecord& read, int minO
     findOverlapBlocksExact(reverseComplement(seq), m_pBWT, m_pRevBWT, sufSufAF, minOverlap, &oblPrefixFwd, &oblFwdContain, result);
     findOverlapBlocksExact(reverse(seq), m_pRevBWT, m_pBWT, preSufAF, minOverlap, &oblPrefixRev, &oblRevContain, result);
 
-	//Trim the OB list
-	TrimOBLInterval(&oblSuffixFwd, seq.length());
-	TrimOBLInterval(&oblSuffixRev, seq.length());
-	TrimOBLInterval(&oblPrefixFwd, seq.length());
-	TrimOBLInterval(&oblPrefixRev, seq.length());
-	
-	//SuperRepeat is sequentically detected, which miss later repeats.
-	// if( TrimOBLInterval(&oblSuffixFwd, seq.length()) )
-		// #pragma omp critical (SuperRepeat)
-		// {
-			// m_SuperRepeat->insert(read.id);
-		// }
-	// if( TrimOBLInterval(&oblSuffixRev, seq.length()) )
-		// #pragma omp critical (SuperRepeat)
-		// {
-			// m_SuperRepeat->insert(read.id);
-		// }
-	// if( TrimOBLInterval(&oblPrefixFwd, seq.length()) )
-		// #pragma omp critical (SuperRepeat)
-		// {
-			// m_SuperRepeat->insert(read.id);
-		// }
-	// if( TrimOBLInterval(&oblPrefixRev, seq.length()) )
-		// #pragma omp critical (SuperRepeat)
-		// {
-			// m_SuperRepeat->insert(read.id);
-		// }
+	//Trim the OB list. The read is a super repeat if any list overlaps too many reads,
+	//the caller records it so the edges are filtered after all reads are processed.
+	result.isSuperRepeat |= TrimOBLInterval(&oblSuffixFwd, seq.length());
+	result.isSuperRepeat |= TrimOBLInterval(&oblSuffixRev, seq.length());
+	result.isSuperRepeat |= TrimOBLInterval(&oblPrefixFwd, seq.length());
+	result.isSuperRepeat |= TrimOBLInterval(&oblPrefixRev, seq.length());
 
   
 	// Remove submaximal blocks for each block list including fully contained blocks
@@ -217,6 +219,53 @@ OverlapResult OverlapAlgorithm::overlapReadExact(const SeqRecord& read, int minO
     return result;
 }
 
+// A read is contained if it is a proper substring of another read on either strand,
+// or if it has the same sequence as a read with a lower id. Of the identical reads
+// only the one with the lowest id is kept, as the assembler does for containments.
+bool OverlapAlgorithm::checkContainedRead(const std::string& seq, size_t readIdx) const
+{
+    assert(m_pQueryRIT == m_pTargetRIT);
+    BWTIntervalPair fwdIntervals = BWTAlgorithms::findIntervalPair(m_pBWT, m_pRevBWT, seq);
+    BWTIntervalPair rcIntervals = BWTAlgorithms::findIntervalPair(m_pBWT, m_pRevBWT, reverseComplement(seq));
+    if(!fwdIntervals.isValid())
+        return false;
+
+    // A substring of another read has a non-$ extension on some side
+    AlphaCount64 fwdECL = BWTAlgorithms::getExtCount(fwdIntervals.interval[0], m_pBWT);
+    AlphaCount64 fwdECR = BWTAlgorithms::getExtCount(fwdIntervals.interval[1], m_pRevBWT);
+    if(fwdECL.hasDNAChar() || fwdECR.hasDNAChar())
+        return true;
+
+    if(rcIntervals.isValid())
+    {
+        AlphaCount64 rcECL = BWTAlgorithms::getExtCount(rcIntervals.interval[0], m_pBWT);
+        AlphaCount64 rcECR = BWTAlgorithms::getExtCount(rcIntervals.interval[1], m_pRevBWT);
+        if(rcECL.hasDNAChar() || rcECR.hasDNAChar())
+            return true;
+    }
+
+    // The remaining occurrences are full-length copies of the read, find their ids
+    // from the lexicographic index of the reads
+    BWTAlgorithms::updateBothL(fwdIntervals, '$', m_pBWT);
+    if(rcIntervals.isValid())
+        BWTAlgorithms::updateBothL(rcIntervals, '$', m_pBWT);
+    std::string readID = m_pQueryRIT->getReadID(readIdx);
+    const BWTInterval* copies[2] = { &fwdIntervals.interval[0], &rcIntervals.interval[0] };
+    for(int i = 0; i < 2; ++i)
+    {
+        if(!copies[i]->isValid())
+            continue;
+
+        for(int64_t j = copies[i]->lower; j <= copies[i]->upper; ++j)
+        {
+            size_t copyIdx = m_pFwdSAI->get(j).getID();
+            if(copyIdx != readIdx && m_pTargetRIT->getReadID(copyIdx) < readID)
+                return true;
+        }
+    }
+    return false;
+}
+
 // Limit OBList interval By Ya: 20141022
 // Only retain edges from longest overlap block to short ones
 bool OverlapAlgorithm::TrimOBLInterval(OverlapBlockList* pOverlapList, int readLength) const
@@ -240,6 +289,7 @@ bool OverlapAlgorithm::TrimOBLInterval(OverlapBlockList* pOverlapList, int readL
         if(Interval >= 64 || (longestOverlap - OB->getOverlapLength()>=readLength*0.5) ) 
         // if(Interval >= 64 || ( (double)(longestOverlap/readLength>=0.8 && (double)OB->getOverlapLength()/readLength<0.8)) ) 
 		{
+			isSuperRepeat = Interval >= 64;
 			// std::cout << readLength <<  "\t" << Interval << "\t" << longestOverlap <<"\n";
             for(;; OB--)
             {
@@ -260,11 +310,31 @@ bool OverlapAlgorithm::TrimOBLInterval(OverlapBlockList* pOverlapList, int readL
 	return isSuperRepeat;
 }
 
+// The blocks of the inexact search are not sorted by overlap length and are not
+// trimmed, as the edges of the inexact overlaps are kept as they are
+bool OverlapAlgorithm::hasSuperRepeatBlocks(const OverlapBlockList* pOverlapList, int readLength) const
+{
+	int longestOverlap = 0;
+	for(OverlapBlockList::const_iterator OB = pOverlapList->begin(); OB != pOverlapList->end(); ++OB)
+		longestOverlap = std::max(longestOverlap, OB->getOverlapLength());
+
+	// Count the reads of the blocks that are not much shorter than the longest overlap
+	int Interval = 0;
+	for(OverlapBlockList::const_iterator OB = pOverlapList->begin(); OB != pOverlapList->end(); ++OB)
+	{
+		if(longestOverlap - OB->getOverlapLength() < readLength*0.5)
+			Interval += OB->ranges.interval[1].size();
+	}
+	return Interval >= 64;
+}
+
 // Write overlap results to an ASQG file
 void OverlapAlgorithm::writeResultASQG(std::ostream& writer, const SeqRecord& read, const OverlapResult& result) const
 {
     ASQG::VertexRecord record(read.id, read.seq.toString());
     record.setSubstringTag(result.isSubstring);
+    if(result.isSuperRepeat)
+        record.setSuperRepeatTag(true);
     record.write(writer);
 }
 
@@ -376,7 +446,8 @@ void OverlapAlgorithm::findOverlapBlocksExact(const std::string& w, const BWT* p
 bool OverlapAlgorithm::findOverlapBlocksInexact(const std::string& w, const BWT* pBWT, 
                                                 const BWT* pRevBWT, const AlignFlags& af, int minOverlap,
                                                 OverlapBlockList* pOverlapList, OverlapBlockList* pContainList, 
-                                                OverlapResult& result) const
+                                                OverlapResult& result, const std::vector<bool>* pSeedMask,
+                                                SeedIntervalCache* pSeedCache) const
 {
     int len = w.length();
     int overlap_region_left = len - minOverlap;
@@ -399,7 +470,29 @@ bool OverlapAlgorithm::findOverlapBlocksInexact(const std::string& w, const BWT*
     assert(actual_seed_stride != 0);
 
     createSearchSeeds(w, pBWT, pRevBWT, actual_seed_length, actual_seed_stride, pCurrVector);
-    extendSeedsExactRight(w, pBWT, pRevBWT, ED_RIGHT, pCurrVector, pNextVector);
+
+    // Drop the seeds outside of the regions supported by the minimizer candidates
+    if(pSeedMask != NULL)
+    {
+        size_t numKept = 0;
+        for(size_t i = 0; i < pCurrVector->size(); ++i)
+        {
+            const SearchSeed& seed = (*pCurrVector)[i];
+            int seedEnd = std::min(seed.left_index + seed.seed_len, len);
+            bool isSupported = false;
+            for(int j = seed.left_index; j < seedEnd && !isSupported; ++j)
+                isSupported = (*pSeedMask)[j];
+
+            if(isSupported)
+                (*pCurrVector)[numKept++] = seed;
+        }
+        pCurrVector->resize(numKept);
+    }
+
+    if(pSeedCache != NULL)
+        extendSeedsExactRightCached(w, pRevBWT, af, pSeedCache, pCurrVector, pNextVector);
+    else
+        extendSeedsExactRight(w, pBWT, pRevBWT, ED_RIGHT, pCurrVector, pNextVector);
     pCurrVector->clear();
     pCurrVector->swap(*pNextVector);
     assert(pNextVector->empty());
@@ -502,6 +595,30 @@ bool OverlapAlgorithm::findOverlapBlocksInexact(const std::string& w, const BWT*
     return !fail;
 }
 
+//
+void OverlapAlgorithm::buildSeedMask(const CandidateRegionVector& candidates, int len, bool isReverse, 
+                                     bool isPrefix, std::vector<bool>& mask) const
+{
+    mask.assign(len, false);
+
+    // The region ends are only known up to the differences allowed in the overlap
+    int slack = static_cast<int>(m_errorRate * len) + 1;
+    for(CandidateRegionVector::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter)
+    {
+        if(iter->isReverse != isReverse)
+            continue;
+
+        // Containments cover the read and are found by every search
+        if(isPrefix ? iter->start > slack : iter->end < len - slack)
+            continue;
+
+        int start = std::max(0, iter->start - slack);
+        int end = std::min(len, iter->end + slack);
+        for(int i = start; i < end; ++i)
+            mask[isPrefix ? len - 1 - i : i] = true;
+    }
+}
+
 // Build forward history for the blocks
 void OverlapAlgorithm::buildForwardHistory(OverlapBlockList* pList) const
 {
@@ -662,6 +779,41 @@ void OverlapAlgorithm::extendSeedsExactRight(const std::string& w, const BWT* /*
     }
 }
 
+// Extend the seeds to the right over the entire seed range, reusing the seeds
+// found by the other searches of the read
+void OverlapAlgorithm::extendSeedsExactRightCached(const std::string& w, const BWT* pRevBWT, const AlignFlags& af,
+                                                   SeedIntervalCache* pSeedCache, const SearchSeedVector* pInVector, 
+                                                   SearchSeedVector* pOutVector) const
+{
+    for(SearchSeedVector::const_iterator iter = pInVector->begin(); iter != pInVector->end(); ++iter)
+    {
+        SearchSeed align = *iter;
+        bool valid = true;
+        if(pSeedCache->lookup(af, align.left_index, align.seed_len, align.ranges, valid))
+        {
+            align.right_index = align.left_index + align.seed_len - 1;
+        }
+        else
+        {
+            while(align.isSeed())
+            {
+                ++align.right_index;
+                char b = w[align.right_index];
+                BWTAlgorithms::updateBothR(align.ranges, b, pRevBWT);
+                if(!align.isIntervalValid(RIGHT_INT_IDX))
+                {
+                    valid = false;
+                    break;
+                }
+            }
+            pSeedCache->insert(af, align.left_index, align.seed_len, align.ranges, valid);
+        }
+
+        if(valid)
+            pOutVector->push_back(align);
+    }
+}
+
 //
 void OverlapAlgorithm::extendSeedInexactRight(SearchSeed& seed, const std::string& w, const BWT* /*pBWT*/, 
                                               const BWT* pRevBWT, SearchSeedVector* pOutVector) const
@@ -849,7 +1001,7 @@ void OverlapAlgorithm::_processIrreducibleBlocksExactIterative(const BWT* pBWT,
             OBLIter blockIter = currList.begin();
             while(blockIter != currList.end() && blockIter->overlapLen == topLen)
             {
-                ext_count += blockIter->getCanonicalExtCount(pBWT, pRevBWT);
+                ext_count += getUncontainedExtCount(*blockIter, pBWT, pRevBWT);
                 ++blockIter;
             }
             
@@ -861,6 +1013,7 @@ void OverlapAlgorithm::_processIrreducibleBlocksExactIterative(const BWT* pBWT,
             // or considered further. 
             // Likewise if multiple distinct strings in the TLB ended, we only output the top one. The rest
             // must have the same sequence as the top one and are hence considered to be contained with the top element.
+            // Reads marked as contained do not end the TLB, the extension continues past them.
             if(ext_count.get('$') > 0)
             {
                 // An irreducible overlap has been found. It is possible that there are two top level blocks
@@ -871,8 +1024,15 @@ void OverlapAlgorithm::_processIrreducibleBlocksExactIterative(const BWT* pBWT,
                 while(tlbIter != currList.end() && tlbIter->overlapLen == topLen)
                 {
                     // Ensure the tlb is actually terminal and not a substring block
-                    AlphaCount64 test_count = tlbIter->getCanonicalExtCount(pBWT, pRevBWT);
-                    if(test_count.get('$') == 0)
+                    AlphaCount64 test_count = getUncontainedExtCount(*tlbIter, pBWT, pRevBWT);
+                    if(test_count.get('$') == 0 && m_pContainedReads != NULL)
+                    {
+                        // Only contained reads end in this block. They have the sequence of the reads
+                        // that end in the other top level blocks, so the block is not output
+                        ++tlbIter;
+                        continue;
+                    }
+                    else if(test_count.get('$') == 0)
                     {
                         std::cerr << "Error: substring read found during overlap computation.\n";
                         std::cerr << "Please run sga rmdup before sga overlap\n";
@@ -913,6 +1073,8 @@ void OverlapAlgorithm::_processIrreducibleBlocksExactIterative(const BWT* pBWT,
                 }
                 else
                 {
+                    // The group is replaced by its branches. It has none if its
+                    // reads only end in reads marked as contained.
                     for(size_t idx = 0; idx < DNA_ALPHABET_SIZE; ++idx)
                     {
                         char b = ALPHABET[idx];
@@ -922,9 +1084,9 @@ void OverlapAlgorithm::_processIrreducibleBlocksExactIterative(const BWT* pBWT,
                             OverlapBlockList branched = currList;
                             updateOverlapBlockRangesRight(pBWT, pRevBWT, branched, b);
                             incomingGroups.push_back(branched);
-                            bEraseGroup = true;
                         }
                     }
+                    bEraseGroup = true;
                 }
             }
 
@@ -1052,12 +1214,14 @@ void OverlapAlgorithm::extendActiveBlocksRight(const BWT* pBWT, const BWT* pRevB
         if(ext_count.get('$') > 0)
         {
             // Only consider this block to be terminal irreducible if it has at least one extension
-            // or else it is a substring block
+            // or else it is a substring block. Contained reads do not end the extension
+            // as they are removed from the graph.
             if(iter->forwardHistory.size() > 0)
             {
                 OverlapBlock branched = *iter;
                 BWTAlgorithms::updateBothR(branched.ranges, '$', branched.getExtensionBWT(pBWT, pRevBWT));
-                terminalList.push_back(branched);
+                if(!isContainedBlock(branched))
+                    terminalList.push_back(branched);
 #ifdef DEBUGOVERLAP_2            
                 std::cout << "Block of length " << iter->overlapLen << " moved to terminal\n";
 #endif
@@ -1117,6 +1281,35 @@ void OverlapAlgorithm::extendActiveBlocksRight(const BWT* pBWT, const BWT* pRevB
     }
 } 
 
+// Return true if all the reads of the terminal block are marked as contained
+bool OverlapAlgorithm::isContainedBlock(const OverlapBlock& terminalBlock) const
+{
+    if(m_pContainedReads == NULL)
+        return false;
+
+    const SuffixArray* pCurrSAI = terminalBlock.flags.isTargetRev() ? m_pRevSAI : m_pFwdSAI;
+    for(int64_t j = terminalBlock.ranges.interval[0].lower; j <= terminalBlock.ranges.interval[0].upper; ++j)
+    {
+        if(!m_pContainedReads->test(pCurrSAI->get(j).getID()))
+            return false;
+    }
+    return true;
+}
+
+// The $ of a block is dropped if every read that ends there is marked as contained
+AlphaCount64 OverlapAlgorithm::getUncontainedExtCount(const OverlapBlock& block, const BWT* pBWT, const BWT* pRevBWT) const
+{
+    AlphaCount64 ext_count = block.getCanonicalExtCount(pBWT, pRevBWT);
+    if(m_pContainedReads != NULL && ext_count.get('$') > 0)
+    {
+        OverlapBlock terminal = block;
+        BWTAlgorithms::updateBothR(terminal.ranges, '$', terminal.getExtensionBWT(pBWT, pRevBWT));
+        if(isContainedBlock(terminal))
+            ext_count.set('$', 0);
+    }
+    return ext_count;
+}
+
 // Return true if the terminalBlock is a substring of any member of blockList
 bool OverlapAlgorithm::isBlockSubstring(OverlapBlock& terminalBlock, const OverlapBlockList& blockList, double maxER) const
 {
@@ -1190,3 +1383,39 @@ void OverlapAlgorithm::updateOverlapBlockRangesRight(const BWT* pBWT, const BWT*
     }
 }
 
+
+//
+uint64_t SeedIntervalCache::makeKey(const AlignFlags& af, int left, int length) const
+{
+    // A search on the reverse of the read runs from the other end of it
+    int start = af.isQueryRev() ? m_readLength - left - length : left;
+    assert(start >= 0 && length > 0);
+    return ((uint64_t)length << 33) | ((uint64_t)start << 1) | (af.isQueryComp() ? 1 : 0);
+}
+
+//
+bool SeedIntervalCache::lookup(const AlignFlags& af, int left, int length, BWTIntervalPair& ranges, bool& isValid) const
+{
+    EntryMap::const_iterator iter = m_entries.find(makeKey(af, left, length));
+    if(iter == m_entries.end())
+        return false;
+
+    isValid = iter->second.isValid;
+    if(isValid)
+    {
+        ranges = iter->second.ranges;
+        if(isSwapped(af))
+            std::swap(ranges.interval[0], ranges.interval[1]);
+    }
+    return true;
+}
+
+//
+void SeedIntervalCache::insert(const AlignFlags& af, int left, int length, const BWTIntervalPair& ranges, bool isValid)
+{
+    Entry& entry = m_entries[makeKey(af, left, length)];
+    entry.isValid = isValid;
+    entry.ranges = ranges;
+    if(isSwapped(af))
+        std::swap(entry.ranges.interval[0], entry.ranges.interval[1]);
+}
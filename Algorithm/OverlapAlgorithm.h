@@ -15,6 +15,10 @@
 #include "SearchSeed.h"
 #include "BWTAlgorithms.h"
 #include "Util.h"
+#include "HashMap.h"
+#include "AtomicBitVector.h"
+#include "MinimizerIndex.h"
+#include <map>
 
 enum OverlapMode
 {
@@ -24,9 +28,45 @@ enum OverlapMode
 
 struct OverlapResult
 {
-    OverlapResult() : isSubstring(false), searchAborted(false) {}
+    OverlapResult() : isSubstring(false), searchAborted(false), isSuperRepeat(false) {}
     bool isSubstring;
     bool searchAborted;
+    bool isSuperRepeat;
+};
+
+// The exact intervals of the seeds of one read, shared by its strand searches.
+// The search of a string on one index mirrors the search of its reverse on the
+// other index, so a seed of the reverse search has the swapped interval pair of
+// the same seed of the read. Seeds are keyed by their strand, start and length
+// on the read and the pair is stored as found by the search of the read itself.
+class SeedIntervalCache
+{
+    public:
+        SeedIntervalCache(int readLength) : m_readLength(readLength) {}
+
+        // Find the seed w[left, left + length) where w is the read transformed as in af.
+        // Returns false if the seed has not been extended yet.
+        bool lookup(const AlignFlags& af, int left, int length, BWTIntervalPair& ranges, bool& isValid) const;
+
+        // Record the ranges of the seed, isValid is false if the seed does not occur
+        void insert(const AlignFlags& af, int left, int length, const BWTIntervalPair& ranges, bool isValid);
+
+    private:
+
+        struct Entry
+        {
+            BWTIntervalPair ranges;
+            bool isValid;
+        };
+        typedef std::map<uint64_t, Entry> EntryMap;
+
+        uint64_t makeKey(const AlignFlags& af, int left, int length) const;
+
+        // A search on the complement or the reverse of the read has the pair swapped
+        static bool isSwapped(const AlignFlags& af) { return af.isQueryRev() != af.isQueryComp(); }
+
+        int m_readLength;
+        EntryMap m_entries;
 };
 
 class OverlapAlgorithm
@@ -43,18 +83,23 @@ class OverlapAlgorithm
 										m_pRevSAI(pRevSAI),
 										m_pQueryRIT(pQueryRIT),
 										m_pTargetRIT(pTargetRIT),
+										m_errorRate(0.0f),
+										m_seedLength(0),
+										m_seedStride(0),
 										// default transitive reduction and exact overlap
 										m_bIrreducible(true),
                                         m_exactModeOverlap(true),
-                                        m_exactModeIrreducible(true)
+                                        m_exactModeIrreducible(true),
+                                        m_maxSeeds(-1),
+                                        m_pMinimizerIndex(NULL),
+                                        m_pContainedReads(NULL)
 										 {
-										 	//Maintain a hashset for reducing edges of repeat vertices,by YTH
-											m_SuperRepeat=new DenseHashSet<std::string,StringHasher>();
-											m_SuperRepeat->set_empty_key("");
+										 	//Maintain a set of the query reads found to be super repeats for reducing their edges, by YTH
+											m_pSuperRepeats = new AtomicBitVector(pQueryRIT->getCount());
 										}
 		~OverlapAlgorithm()
 		{
-			delete m_SuperRepeat;
+			delete m_pSuperRepeats;
 		}
 										
 		OverlapAlgorithm(const BWT* pBWT, const BWT* pRevBWT,  
@@ -67,11 +112,11 @@ class OverlapAlgorithm
                                          m_bIrreducible(irrOnly),
                                          m_exactModeOverlap(false),
                                          m_exactModeIrreducible(false),
-                                         m_maxSeeds(maxSeeds)
+                                         m_maxSeeds(maxSeeds),
+                                         m_pMinimizerIndex(NULL),
+                                         m_pContainedReads(NULL),
+                                         m_pSuperRepeats(NULL)
 										 {
-										 	//Maintain a hashset for reducing edges of repeat vertices,by YTH
-											m_SuperRepeat=new DenseHashSet<std::string,StringHasher>();
-											m_SuperRepeat->set_empty_key("");
 										}
 
 		
@@ -101,6 +146,22 @@ class OverlapAlgorithm
         void setExactModeOverlap(bool b) { m_exactModeOverlap = b; }
         void setExactModeIrreducible(bool b) { m_exactModeIrreducible = b; }
 
+        // Set the parameters of the inexact overlap search
+        void setInexactParameters(double er, int seedLen, int seedStride) { m_errorRate = er; m_seedLength = seedLen; m_seedStride = seedStride; }
+
+        // Only extend the inexact seeds in the regions of a read that the minimizer
+        // candidates support. The index is not owned by the overlapper.
+        void setMinimizerIndex(const MinimizerIndex* pIndex) { m_pMinimizerIndex = pIndex; }
+
+        // Check whether the read is contained in another read, either as a proper substring
+        // or as a copy of a read with a lower id. Requires the query reads to be the target reads.
+        bool checkContainedRead(const std::string& seq, size_t readIdx) const;
+
+        // Skip the overlaps of the reads marked in the bitvector and the overlaps to them.
+        // The marks are indexed by the reads and are not owned by the overlapper.
+        void setContainedReads(const AtomicBitVector* pContained) { m_pContainedReads = pContained; }
+        bool isContainedRead(size_t readIdx) const { return m_pContainedReads != NULL && m_pContainedReads->test(readIdx); }
+
         //
         const BWT* getBWT() const { return m_pBWT; }
         const BWT* getRBWT() const { return m_pRevBWT; }
@@ -108,16 +169,12 @@ class OverlapAlgorithm
         const SuffixArray* getRevSAI() const { return m_pRevSAI; }
         const ReadInfoTable* getQueryRIT() const { return m_pQueryRIT; }
         const ReadInfoTable* getTargetRIT() const { return m_pTargetRIT; }
-		bool isSuperRepeatVertex(std::string vstr) const { 
-			DenseHashSet<std::string,StringHasher>::const_iterator found;
-			#pragma omp critical (SuperRepeat)
-			{
-				found  = m_SuperRepeat->find(vstr);
-			}
-			if(found!= m_SuperRepeat->end()) return true;
-			else return false;
-			
-		}
+
+		// The super repeats are indexed by the query reads. The set is safe to
+		// read and update from all threads without locking.
+		bool isSuperRepeatRead(size_t readIdx) const { return m_pSuperRepeats != NULL && m_pSuperRepeats->test(readIdx); }
+		void setSuperRepeatRead(size_t readIdx) const { if(m_pSuperRepeats != NULL) m_pSuperRepeats->testAndSet(readIdx); }
+		AtomicBitVector* getSuperRepeats() const { return m_pSuperRepeats; }
 		
     private:
 
@@ -127,13 +184,27 @@ class OverlapAlgorithm
                                     const AlignFlags& af, const int minOverlap, OverlapBlockList* pOBTemp, 
                                     OverlapBlockList* pOBFinal, OverlapResult& result) const;
 
-        // Same as above while allowing mismatches
+        // Same as above while allowing mismatches. If pSeedMask is given only the seeds
+        // covering a marked position of w are extended. If pSeedCache is given the
+        // exact seed intervals are shared with the other searches of the read.
         bool findOverlapBlocksInexact(const std::string& w, const BWT* pBWT, const BWT* pRevBWT, 
                                       const AlignFlags& af, const int minOverlap, OverlapBlockList* pOBList, 
-                                      OverlapBlockList* pOBFinal, OverlapResult& result) const;
+                                      OverlapBlockList* pOBFinal, OverlapResult& result,
+                                      const std::vector<bool>* pSeedMask = NULL,
+                                      SeedIntervalCache* pSeedCache = NULL) const;
+
+        // Mark the positions of w covered by the candidate regions of one inexact search.
+        // The overlaps of the search are on the reverse strand if isReverse is set and
+        // touch the start of the read if isPrefix is set, in which case w is reversed.
+        void buildSeedMask(const CandidateRegionVector& candidates, int len, bool isReverse, 
+                           bool isPrefix, std::vector<bool>& mask) const;
 
 		bool TrimOBLInterval(OverlapBlockList* pOverlapList, int MaxInterval) const;
 
+		// Check whether the blocks found by the inexact search make the read a super repeat,
+		// by the rule of TrimOBLInterval but without trimming the blocks
+		bool hasSuperRepeatBlocks(const OverlapBlockList* pOverlapList, int readLength) const;
+
         //
         inline bool extendSeedExactRight(SearchSeed& seed, const std::string& w, const BWT* pBWT, const BWT* pRevBWT) const;
         inline bool extendSeedExactLeft(SearchSeed& seed, const std::string& w, const BWT* pBWT, const BWT* pRevBWT) const;
@@ -167,6 +238,11 @@ class OverlapAlgorithm
         inline void extendSeedsExactRight(const std::string& w, const BWT* pBWT, const BWT* pRevBWT, 
                                                  ExtendDirection dir, const SearchSeedVector* pInVector, 
                                                  SearchSeedVector* pOutVector) const;
+
+        // As above, taking the seeds already extended by another search from the cache
+        void extendSeedsExactRightCached(const std::string& w, const BWT* pRevBWT, const AlignFlags& af,
+                                         SeedIntervalCache* pSeedCache, const SearchSeedVector* pInVector, 
+                                         SearchSeedVector* pOutVector) const;
         
         // Calculate the terminal extension for the contained blocks to make the intervals consistent
         void terminateContainedBlocks(OverlapBlockList& containedBlocks) const;
@@ -201,6 +277,12 @@ class OverlapAlgorithm
                                      OverlapBlockList& terminalList,
                                      OverlapBlockList& containedList) const;
 
+        // Check whether all the reads of a terminal block are marked as contained
+        bool isContainedBlock(const OverlapBlock& terminalBlock) const;
+
+        // The canonical extensions of a block, without the $ if all the reads ending there are contained
+        AlphaCount64 getUncontainedExtCount(const OverlapBlock& block, const BWT* pBWT, const BWT* pRevBWT) const;
+
         double calculateBlockErrorRate(const OverlapBlock& terminalBlock, const OverlapBlock& otherBlock) const;
         bool isBlockSubstring(OverlapBlock& terminalBlock, const OverlapBlockList& blockList, double maxER) const;
 
@@ -215,8 +297,6 @@ class OverlapAlgorithm
 		ReadInfoTable* m_pQueryRIT;
 		ReadInfoTable* m_pTargetRIT;
 
-		DenseHashSet<std::string,StringHasher>* m_SuperRepeat;
-
 		double m_errorRate;
         int m_seedLength;
         int m_seedStride;
@@ -226,6 +306,11 @@ class OverlapAlgorithm
         
         // Optional parameter to limit the amount of branching that is performed
         int m_maxSeeds; 
+
+        const MinimizerIndex* m_pMinimizerIndex;
+        const AtomicBitVector* m_pContainedReads;
+
+		AtomicBitVector* m_pSuperRepeats;
 };
 
 #endif
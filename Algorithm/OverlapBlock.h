@@ -121,7 +121,7 @@ struct OverlapBlock
     // reference for the original read
     int getCanonicalIntervalIndex() const;
 	
-	int getOverlapLength(){return overlapLen;};
+	int getOverlapLength() const {return overlapLen;};
 
     // Return the canonical interval.
     BWTInterval getCanonicalInterval() const;
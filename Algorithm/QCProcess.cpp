@@ -245,7 +245,7 @@ DuplicateCheckResult QCProcess::performDuplicateCheck(const SequenceWorkItem& wo
     {
         // This read is not a duplicate
         // Attempt to atomically set the bit from false to true
-        if(m_params.pSharedBV->updateCAS(canonicalIdx, false, true))
+        if(m_params.pSharedBV->testAndSet(canonicalIdx))
         {
             // Call succeed, return that this read is not a duplicate
             return DCR_UNIQUE;
@@ -409,6 +409,17 @@ QCPostProcess::~QCPostProcess()
     std::cout << "Reads failed degenerate check: " << m_readsFailedDegen << "\n";
 }
 
+//
+void QCPostProcess::registerCheckpoint(Checkpoint* pCheckpoint)
+{
+    pCheckpoint->addCounter("readsKept", &m_readsKept);
+    pCheckpoint->addCounter("readsDiscarded", &m_readsDiscarded);
+    pCheckpoint->addCounter("readsFailedKmer", &m_readsFailedKmer);
+    pCheckpoint->addCounter("readsFailedDup", &m_readsFailedDup);
+    pCheckpoint->addCounter("readsFailedHP", &m_readsFailedHP);
+    pCheckpoint->addCounter("readsFailedDegen", &m_readsFailedDegen);
+}
+
 //
 void QCPostProcess::process(const SequenceWorkItem& item, const QCResult& result)
 {
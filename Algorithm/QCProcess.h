@@ -14,7 +14,7 @@
 #include "BWT.h"
 #include "SequenceProcessFramework.h"
 #include "SequenceWorkItem.h"
-#include "BitVector.h"
+#include "AtomicBitVector.h"
 
 // Parameters
 struct QCParameters
@@ -48,7 +48,7 @@ struct QCParameters
 
     const BWT* pBWT;
     const BWT* pRevBWT;
-    BitVector* pSharedBV;
+    AtomicBitVector* pSharedBV;
 
     // Control parameters
     bool checkDuplicates;
@@ -156,6 +156,9 @@ class QCPostProcess
 
         void process(const SequenceWorkItem& item, const QCResult& result);
 
+        // Save the counters with each checkpoint of the run
+        void registerCheckpoint(Checkpoint* pCheckpoint);
+
     private:
 
         std::ostream* m_pCorrectedWriter;
@@ -282,9 +282,9 @@ Vertex* Bigraph::buildVertex (EdgePtrVec & pathEdges,std::string vertexName)
 			SeqCoord matchCoord (pEdge->getMatchCoord().interval.start+offset
 			, pEdge->getMatchCoord().interval.end+offset
 			, pathSeq.length()) ;
-			Edge* pNewEdge = new (getEdgeAllocator())  Edge(end,dir,comp,matchCoord);
+			Edge* pNewEdge = new Edge(end,dir,comp,matchCoord);
 			Edge* pTwin = pEdge->getTwin();
-			Edge* pNewTwin = new (getEdgeAllocator())  Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
+			Edge* pNewTwin = new Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
 
 			pNewEdge->setTwin(pNewTwin);
 			pNewTwin->setTwin(pNewEdge);
@@ -308,9 +308,9 @@ Vertex* Bigraph::buildVertex (EdgePtrVec & pathEdges,std::string vertexName)
 				, pEdge->getMatchCoord().interval.end
 				, pathSeq.length()) ;
 
-				Edge* pNewEdge = new (getEdgeAllocator())  Edge(end,dir,comp,matchCoord);
+				Edge* pNewEdge = new Edge(end,dir,comp,matchCoord);
 				Edge* pTwin = pEdge->getTwin();
-				Edge* pNewTwin = new (getEdgeAllocator())  Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
+				Edge* pNewTwin = new Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
 
 				pNewEdge->setTwin(pNewTwin);
 				pNewTwin->setTwin(pNewEdge);
@@ -329,9 +329,9 @@ Vertex* Bigraph::buildVertex (EdgePtrVec & pathEdges,std::string vertexName)
 				SeqCoord m = pEdge->getMatchCoord();
 				int matchLength = m.length() ;
 				SeqCoord matchCoord (0,matchLength-1,pathSeq.length());
-				Edge* pNewEdge = new (getEdgeAllocator())  Edge(end,dir,comp,matchCoord);
+				Edge* pNewEdge = new Edge(end,dir,comp,matchCoord);
 				Edge* pTwin = pEdge->getTwin();
-				Edge* pNewTwin = new (getEdgeAllocator())  Edge(pNewVertex,pTwin->getDir(),!pTwin->getComp(), pTwin->getMatchCoord());
+				Edge* pNewTwin = new Edge(pNewVertex,pTwin->getDir(),!pTwin->getComp(), pTwin->getMatchCoord());
 
 				pNewEdge->setTwin(pNewTwin);
 				pNewTwin->setTwin(pNewEdge);
@@ -356,9 +356,9 @@ Vertex* Bigraph::buildVertex (EdgePtrVec & pathEdges,std::string vertexName)
 			assert (dir==ED_ANTISENSE);
 			SeqCoord matchCoord (pEdge->getMatchCoord().interval.start, pEdge->getMatchCoord().interval.end, pathSeq.length()) ;
 
-			Edge* pNewEdge = new (getEdgeAllocator())  Edge(end,dir,comp,matchCoord);
+			Edge* pNewEdge = new Edge(end,dir,comp,matchCoord);
 			Edge* pTwin = pEdge->getTwin();
-			Edge* pNewTwin = new (getEdgeAllocator())  Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
+			Edge* pNewTwin = new Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
 
 			pNewEdge->setTwin(pNewTwin);
 			pNewTwin->setTwin(pNewEdge);
@@ -381,9 +381,9 @@ Vertex* Bigraph::buildVertex (EdgePtrVec & pathEdges,std::string vertexName)
 				SeqCoord matchCoord (pEdge->getMatchCoord().interval.start+offset
 				, pEdge->getMatchCoord().interval.end+offset
 				, pathSeq.length()) ;
-				Edge* pNewEdge = new (getEdgeAllocator())  Edge(end,dir,comp,matchCoord);
+				Edge* pNewEdge = new Edge(end,dir,comp,matchCoord);
 				Edge* pTwin = pEdge->getTwin();
-				Edge* pNewTwin = new (getEdgeAllocator())  Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
+				Edge* pNewTwin = new Edge(pNewVertex,pTwin->getDir(),pTwin->getComp(), pTwin->getMatchCoord());
 
 				pNewEdge->setTwin(pNewTwin);
 				pNewTwin->setTwin(pNewEdge);
@@ -401,9 +401,9 @@ Vertex* Bigraph::buildVertex (EdgePtrVec & pathEdges,std::string vertexName)
 				SeqCoord m = pEdge->getMatchCoord();
 				int matchLength = m.length() ;
 				SeqCoord matchCoord (pathSeq.length()-matchLength,pathSeq.length()-1,pathSeq.length());
-				Edge* pNewEdge = new (getEdgeAllocator())  Edge(end,dir,comp,matchCoord);
+				Edge* pNewEdge = new Edge(end,dir,comp,matchCoord);
 				Edge* pTwin = pEdge->getTwin();
-				Edge* pNewTwin = new (getEdgeAllocator())  Edge(pNewVertex,pTwin->getDir(),!pTwin->getComp(), pTwin->getMatchCoord());
+				Edge* pNewTwin = new Edge(pNewVertex,pTwin->getDir(),!pTwin->getComp(), pTwin->getMatchCoord());
 
 				pNewEdge->setTwin(pNewTwin);
 				pNewTwin->setTwin(pNewEdge);
@@ -0,0 +1,342 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactGraph - Compact core of a bidirectional graph
+//
+#include <assert.h>
+#include <limits>
+#include <new>
+#include <utility>
+#include "CompactGraph.h"
+#include "Bigraph.h"
+#include "Alphabet.h"
+
+const double CompactGraph::MAX_DELETED_FRACTION = 0.25;
+
+static const size_t BASES_PER_WORD = 32;
+
+// Set flag on an edge or vertex, returning true if it was not set before
+static inline bool setFlagOnce(uint8_t* pFlags, uint8_t flag)
+{
+    return (__sync_fetch_and_or(pFlags, flag) & flag) == 0;
+}
+
+// Copy the elements of v whose keep flag is set, in order
+template<typename T>
+static void compactVector(std::vector<T>& v, const std::vector<bool>& keep)
+{
+    size_t out = 0;
+    for(size_t i = 0; i < v.size(); ++i)
+    {
+        if(keep[i])
+            v[out++] = v[i];
+    }
+    v.resize(out);
+    std::vector<T>(v).swap(v);
+}
+
+//
+CompactGraph::CompactGraph() : m_numDeletedVertices(0), m_numDeletedEdges(0),
+                               m_hasContainment(false), m_hasTransitive(false), m_isExactMode(false),
+                               m_minOverlap(0), m_errorRate(0.0f)
+{
+    m_nameOffset.push_back(0);
+    m_firstEdge.push_back(0);
+}
+
+// The vertex pool is not thread-safe so the memory of the vertices is taken
+// from it first, then the vertices and edges are built in parallel. The names
+// and sequences are released once the vertices are built, so only the edges of
+// the core are held alongside the string graph.
+Bigraph* CompactGraph::releaseToBigraph()
+{
+    Bigraph* pGraph = new Bigraph;
+    pGraph->setContainmentFlag(m_hasContainment);
+    pGraph->setTransitiveFlag(m_hasTransitive);
+    pGraph->setExactMode(m_isExactMode);
+    pGraph->setMinOverlap(m_minOverlap);
+    pGraph->setErrorRate(m_errorRate);
+
+    int64_t numVertices = getNumVertices();
+    VertexPtrVec vertices(numVertices, NULL);
+    for(int64_t i = 0; i < numVertices; ++i)
+    {
+        if(!isDeleted(i))
+            vertices[i] = (Vertex*)pGraph->getVertexAllocator()->alloc();
+    }
+
+    #pragma omp parallel for
+    for(int64_t i = 0; i < numVertices; ++i)
+    {
+        if(vertices[i] == NULL)
+            continue;
+
+        Vertex* pVertex = ::new(vertices[i]) Vertex(getName(i), getSeq(i));
+        pVertex->setContained(isContained(i));
+        pVertex->setSuperRepeat(isSuperRepeat(i));
+        pVertex->setColor(getColor(i));
+        pVertex->setCoverage(getCoverage(i));
+        pVertex->setOriginLength(getOriginLength(i, ED_SENSE), ED_SENSE);
+        pVertex->setOriginLength(getOriginLength(i, ED_ANTISENSE), ED_ANTISENSE);
+    }
+
+    for(int64_t i = 0; i < numVertices; ++i)
+    {
+        if(vertices[i] != NULL)
+            pGraph->addVertex(vertices[i]);
+    }
+
+    std::string().swap(m_namePool);
+    std::vector<uint64_t>().swap(m_nameOffset);
+    std::vector<uint64_t>().swap(m_bases);
+    std::vector<uint64_t>().swap(m_seqWord);
+    std::vector<uint32_t>().swap(m_originLength);
+    std::vector<uint16_t>().swap(m_coverage);
+    std::vector<GraphColor>().swap(m_vertexColor);
+    std::vector<uint8_t>().swap(m_vertexFlags);
+
+    int64_t numEdges = getNumEdges();
+    EdgePtrVec edges(numEdges, NULL);
+    #pragma omp parallel for
+    for(int64_t i = 0; i < numEdges; ++i)
+    {
+        const CompactEdge& edge = m_edges[i];
+        if(edge.isDeleted())
+            continue;
+
+        assert(vertices[edge.end] != NULL);
+        Edge* pEdge = new Edge(vertices[edge.end], edge.getDir(), edge.getComp(), getMatchCoord(i), edge.color);
+        pEdge->isTrusted = (edge.flags & CEF_TRUSTED) != 0;
+        edges[i] = pEdge;
+    }
+
+    // Twin the edges and fill the adjacency lists, each list is filled by one thread
+    #pragma omp parallel for
+    for(int64_t i = 0; i < numVertices; ++i)
+    {
+        if(vertices[i] == NULL)
+            continue;
+
+        for(EdgeIdx e = getFirstEdge(i); e < getLastEdge(i); ++e)
+        {
+            if(edges[e] == NULL)
+                continue;
+            edges[e]->setTwin(edges[m_edges[e].twin]);
+            pGraph->addEdge(vertices[i], edges[e]);
+        }
+    }
+
+    CompactGraph empty;
+    swap(empty);
+    return pGraph;
+}
+
+//
+void CompactGraph::swap(CompactGraph& other)
+{
+    m_nameOffset.swap(other.m_nameOffset);
+    m_seqWord.swap(other.m_seqWord);
+    m_seqLength.swap(other.m_seqLength);
+    m_originLength.swap(other.m_originLength);
+    m_coverage.swap(other.m_coverage);
+    m_vertexColor.swap(other.m_vertexColor);
+    m_vertexFlags.swap(other.m_vertexFlags);
+    m_namePool.swap(other.m_namePool);
+    m_bases.swap(other.m_bases);
+    m_firstEdge.swap(other.m_firstEdge);
+    m_edges.swap(other.m_edges);
+    std::swap(m_numDeletedVertices, other.m_numDeletedVertices);
+    std::swap(m_numDeletedEdges, other.m_numDeletedEdges);
+    std::swap(m_hasContainment, other.m_hasContainment);
+    std::swap(m_hasTransitive, other.m_hasTransitive);
+    std::swap(m_isExactMode, other.m_isExactMode);
+    std::swap(m_minOverlap, other.m_minOverlap);
+    std::swap(m_errorRate, other.m_errorRate);
+}
+
+//
+VertexIdx CompactGraph::addVertex(const std::string& name, const std::string& seq)
+{
+    size_t numWords = (seq.length() + BASES_PER_WORD - 1) / BASES_PER_WORD;
+    std::vector<uint64_t> words(numWords, 0);
+    for(size_t j = 0; j < seq.length(); ++j)
+        words[j / BASES_PER_WORD] |= (uint64_t)(DNA_ALPHABET::getBaseRank(seq[j]) & 3) << (2 * (j % BASES_PER_WORD));
+    return addVertex(name, words.empty() ? NULL : &words[0], seq.length());
+}
+
+//
+VertexIdx CompactGraph::addVertex(const std::string& name, const uint64_t* pWords, size_t length)
+{
+    assert(m_edges.empty());
+    assert(getNumVertices() < std::numeric_limits<VertexIdx>::max());
+    VertexIdx v = getNumVertices();
+
+    m_namePool.append(name);
+    m_nameOffset.push_back(m_namePool.size());
+
+    m_seqWord.push_back(m_bases.size());
+    m_bases.insert(m_bases.end(), pWords, pWords + (length + BASES_PER_WORD - 1) / BASES_PER_WORD);
+    m_seqLength.push_back(length);
+    m_originLength.push_back(length);
+    m_originLength.push_back(length);
+    m_coverage.push_back(1);
+    m_vertexColor.push_back(GC_WHITE);
+    m_vertexFlags.push_back(0);
+    m_firstEdge.push_back(0);
+    return v;
+}
+
+//
+void CompactGraph::setDegrees(const std::vector<uint32_t>& degrees)
+{
+    assert(degrees.size() == getNumVertices() && m_edges.empty());
+    for(size_t i = 0; i < degrees.size(); ++i)
+        m_firstEdge[i + 1] = m_firstEdge[i] + degrees[i];
+    m_edges.resize(m_firstEdge.back());
+}
+
+//
+std::string CompactGraph::getName(VertexIdx v) const
+{
+    return m_namePool.substr(m_nameOffset[v], m_nameOffset[v + 1] - m_nameOffset[v]);
+}
+
+//
+std::string CompactGraph::getSeq(VertexIdx v) const
+{
+    static const char* BASES = "ACGT";
+    size_t length = m_seqLength[v];
+    const uint64_t* pWords = length > 0 ? &m_bases[m_seqWord[v]] : NULL;
+    std::string out(length, 'A');
+    for(size_t j = 0; j < length; ++j)
+        out[j] = BASES[(pWords[j / BASES_PER_WORD] >> (2 * (j % BASES_PER_WORD))) & 3];
+    return out;
+}
+
+//
+void CompactGraph::setContained(VertexIdx v, bool b)
+{
+    m_vertexFlags[v] = b ? (m_vertexFlags[v] | CVF_CONTAINED) : (m_vertexFlags[v] & ~CVF_CONTAINED);
+}
+
+//
+void CompactGraph::setSuperRepeat(VertexIdx v, bool b)
+{
+    m_vertexFlags[v] = b ? (m_vertexFlags[v] | CVF_SUPER_REPEAT) : (m_vertexFlags[v] & ~CVF_SUPER_REPEAT);
+}
+
+//
+SeqCoord CompactGraph::getMatchCoord(EdgeIdx e) const
+{
+    const CompactEdge& edge = m_edges[e];
+    return SeqCoord(edge.matchStart, edge.matchEnd, m_seqLength[getStart(e)]);
+}
+
+//
+void CompactGraph::removeEdge(EdgeIdx e)
+{
+    if(setFlagOnce(&m_edges[e].flags, CEF_DELETED))
+        __sync_fetch_and_add(&m_numDeletedEdges, 1);
+
+    if(setFlagOnce(&m_edges[m_edges[e].twin].flags, CEF_DELETED))
+        __sync_fetch_and_add(&m_numDeletedEdges, 1);
+}
+
+//
+void CompactGraph::removeVertex(VertexIdx v)
+{
+    if(setFlagOnce(&m_vertexFlags[v], CVF_DELETED))
+        __sync_fetch_and_add(&m_numDeletedVertices, 1);
+
+    for(EdgeIdx e = getFirstEdge(v); e < getLastEdge(v); ++e)
+        removeEdge(e);
+}
+
+//
+void CompactGraph::compact()
+{
+    if(m_numDeletedVertices == 0 && m_numDeletedEdges == 0)
+        return;
+
+    // Number the remaining vertices and edges
+    size_t numVertices = getNumVertices();
+    size_t numEdges = getNumEdges();
+    std::vector<bool> keepVertex(numVertices);
+    std::vector<bool> keepEdge(numEdges);
+    std::vector<VertexIdx> newVertex(numVertices);
+    std::vector<EdgeIdx> newEdge(numEdges);
+    std::vector<EdgeIdx> firstEdge(1, 0);
+    std::string namePool;
+    std::vector<uint64_t> nameOffset(1, 0);
+    std::vector<uint64_t> bases;
+
+    VertexIdx nextVertex = 0;
+    EdgeIdx nextEdge = 0;
+    for(size_t i = 0; i < numVertices; ++i)
+    {
+        keepVertex[i] = !isDeleted(i);
+        for(EdgeIdx e = getFirstEdge(i); e < getLastEdge(i); ++e)
+        {
+            keepEdge[e] = keepVertex[i] && !m_edges[e].isDeleted();
+            if(keepEdge[e])
+                newEdge[e] = nextEdge++;
+        }
+
+        if(!keepVertex[i])
+            continue;
+
+        newVertex[i] = nextVertex++;
+        firstEdge.push_back(nextEdge);
+        namePool.append(m_namePool, m_nameOffset[i], m_nameOffset[i + 1] - m_nameOffset[i]);
+        nameOffset.push_back(namePool.size());
+
+        size_t seqWord = bases.size();
+        size_t numWords = (m_seqLength[i] + BASES_PER_WORD - 1) / BASES_PER_WORD;
+        bases.insert(bases.end(), m_bases.begin() + m_seqWord[i], m_bases.begin() + m_seqWord[i] + numWords);
+        m_seqWord[i] = seqWord;
+    }
+
+    #pragma omp parallel for
+    for(int64_t i = 0; i < (int64_t)numEdges; ++i)
+    {
+        if(!keepEdge[i])
+            continue;
+        assert(keepVertex[m_edges[i].end] && keepEdge[m_edges[i].twin]);
+        m_edges[i].end = newVertex[m_edges[i].end];
+        m_edges[i].twin = newEdge[m_edges[i].twin];
+    }
+
+    // The per vertex arrays keep two origin lengths for each vertex
+    std::vector<bool> keepOrigin(2 * numVertices);
+    for(size_t i = 0; i < numVertices; ++i)
+        keepOrigin[2 * i] = keepOrigin[2 * i + 1] = keepVertex[i];
+
+    compactVector(m_edges, keepEdge);
+    compactVector(m_seqWord, keepVertex);
+    compactVector(m_seqLength, keepVertex);
+    compactVector(m_originLength, keepOrigin);
+    compactVector(m_coverage, keepVertex);
+    compactVector(m_vertexColor, keepVertex);
+    compactVector(m_vertexFlags, keepVertex);
+    m_firstEdge.swap(firstEdge);
+    m_namePool.swap(namePool);
+    m_nameOffset.swap(nameOffset);
+    m_bases.swap(bases);
+
+    m_numDeletedVertices = 0;
+    m_numDeletedEdges = 0;
+}
+
+//
+bool CompactGraph::compactIfNeeded()
+{
+    if(m_numDeletedVertices > MAX_DELETED_FRACTION * getNumVertices() ||
+       m_numDeletedEdges > MAX_DELETED_FRACTION * getNumEdges())
+    {
+        compact();
+        return true;
+    }
+    return false;
+}
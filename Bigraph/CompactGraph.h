@@ -0,0 +1,214 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactGraph - Compact core of a bidirectional graph.
+// Vertices are numbered densely from zero and their names
+// are kept in a side table. The edges of each vertex are
+// stored contiguously in one array (CSR layout) and refer
+// to their end vertex and twin by index, so walking the
+// graph does not chase pointers. Deleted vertices and edges
+// are tombstoned and dropped by compact(), which runs after
+// a visit once enough of the graph has been deleted.
+//
+// The vertices of the core are never merged. assemble loads
+// a binary graph into it, gathers the input stats and removes
+// the contained vertices, then expands it into a Bigraph. All
+// the later passes run on the Bigraph, including the trims and
+// other passes that only delete, because assemble runs them
+// after the first vertex merge. The core therefore lowers the
+// memory used while loading, not the peak of the assembly.
+// The core is released while it is expanded, but its edges
+// are held alongside the Bigraph until the expansion ends.
+//
+#ifndef COMPACTGRAPH_H
+#define COMPACTGRAPH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "GraphCommon.h"
+#include "SeqCoord.h"
+
+class Bigraph;
+
+typedef uint32_t VertexIdx;
+typedef uint64_t EdgeIdx;
+
+// Edge flags
+const uint8_t CEF_ANTISENSE = 1;
+const uint8_t CEF_REVERSE = 2;
+const uint8_t CEF_TRUSTED = 4;
+const uint8_t CEF_DELETED = 8;
+
+// Vertex flags
+const uint8_t CVF_CONTAINED = 1;
+const uint8_t CVF_SUPER_REPEAT = 2;
+const uint8_t CVF_DELETED = 4;
+
+// An edge starting at the vertex that holds it. The match is on
+// the start vertex, which also gives the length of the match coordinate.
+struct CompactEdge
+{
+    EdgeIdx twin;
+    VertexIdx end;
+    int32_t matchStart;
+    int32_t matchEnd;
+    uint8_t flags;
+    uint8_t color;
+    uint16_t padding;
+
+    inline EdgeDir getDir() const { return (flags & CEF_ANTISENSE) ? ED_ANTISENSE : ED_SENSE; }
+    inline EdgeComp getComp() const { return (flags & CEF_REVERSE) ? EC_REVERSE : EC_SAME; }
+    inline EdgeDir getTwinDir() const { return (getComp() == EC_SAME) ? !getDir() : getDir(); }
+    inline bool isDeleted() const { return (flags & CEF_DELETED) != 0; }
+    inline int getMatchLength() const { return matchEnd - matchStart + 1; }
+};
+
+class CompactGraph
+{
+    public:
+
+        CompactGraph();
+
+        // Expand the core into a pointer based graph, for the visitors that work on a Bigraph.
+        // The deleted vertices and edges are not copied and the core is left empty.
+        Bigraph* releaseToBigraph();
+
+        // Construction. The vertices are added first, then setDegrees
+        // sizes the edge list of each vertex and the edges are filled
+        // in with getEdge, in parallel if needed.
+        VertexIdx addVertex(const std::string& name, const std::string& seq);
+
+        // Add a vertex from 2-bit codes, 32 bases per word with the first base in the lowest bits
+        VertexIdx addVertex(const std::string& name, const uint64_t* pWords, size_t length);
+        void setDegrees(const std::vector<uint32_t>& degrees);
+
+        // Vertices
+        inline size_t getNumVertices() const { return m_seqLength.size(); }
+        inline size_t getNumLiveVertices() const { return getNumVertices() - m_numDeletedVertices; }
+        inline bool isDeleted(VertexIdx v) const { return (m_vertexFlags[v] & CVF_DELETED) != 0; }
+        inline bool isContained(VertexIdx v) const { return (m_vertexFlags[v] & CVF_CONTAINED) != 0; }
+        inline bool isSuperRepeat(VertexIdx v) const { return (m_vertexFlags[v] & CVF_SUPER_REPEAT) != 0; }
+        inline size_t getSeqLen(VertexIdx v) const { return m_seqLength[v]; }
+        inline GraphColor getColor(VertexIdx v) const { return m_vertexColor[v]; }
+        inline uint16_t getCoverage(VertexIdx v) const { return m_coverage[v]; }
+        inline size_t getOriginLength(VertexIdx v, EdgeDir dir) const { return m_originLength[2 * v + dir]; }
+        std::string getName(VertexIdx v) const;
+        std::string getSeq(VertexIdx v) const;
+
+        void setColor(VertexIdx v, GraphColor c) { m_vertexColor[v] = c; }
+        void setContained(VertexIdx v, bool b);
+        void setSuperRepeat(VertexIdx v, bool b);
+        void setCoverage(VertexIdx v, uint16_t c) { m_coverage[v] = c; }
+        void setOriginLength(VertexIdx v, size_t l, EdgeDir dir) { m_originLength[2 * v + dir] = l; }
+
+        // Edges. The edges of v are [getFirstEdge(v), getLastEdge(v)), including tombstones.
+        inline size_t getNumEdges() const { return m_edges.size(); }
+        inline size_t getNumLiveEdges() const { return getNumEdges() - m_numDeletedEdges; }
+        inline EdgeIdx getFirstEdge(VertexIdx v) const { return m_firstEdge[v]; }
+        inline EdgeIdx getLastEdge(VertexIdx v) const { return m_firstEdge[v + 1]; }
+        inline const CompactEdge& getEdge(EdgeIdx e) const { return m_edges[e]; }
+        inline CompactEdge& getEdge(EdgeIdx e) { return m_edges[e]; }
+
+        // The start vertex of an edge, found through its twin
+        inline VertexIdx getStart(EdgeIdx e) const { return m_edges[m_edges[e].twin].end; }
+
+        // The match coordinate of an edge
+        SeqCoord getMatchCoord(EdgeIdx e) const;
+
+        // Tombstone an edge and its twin, or a vertex and all its edges.
+        // Both are thread-safe, an edge deleted from both ends is counted once.
+        void removeEdge(EdgeIdx e);
+        void removeVertex(VertexIdx v);
+
+        // Drop the tombstones and renumber the remaining vertices, keeping their order
+        void compact();
+
+        // Compact if more than MAX_DELETED_FRACTION of the vertices or edges are tombstones
+        bool compactIfNeeded();
+
+        // Graph parameters, as in Bigraph
+        void setContainmentFlag(bool b) { m_hasContainment = b; }
+        bool hasContainment() const { return m_hasContainment; }
+        void setTransitiveFlag(bool b) { m_hasTransitive = b; }
+        bool hasTransitive() const { return m_hasTransitive; }
+        void setExactMode(bool b) { m_isExactMode = b; }
+        bool isExactMode() const { return m_isExactMode; }
+        void setMinOverlap(int mo) { m_minOverlap = mo; }
+        int getMinOverlap() const { return m_minOverlap; }
+        void setErrorRate(double er) { m_errorRate = er; }
+        double getErrorRate() const { return m_errorRate; }
+
+        // Visit each live vertex and call the visit functor object. The tombstones
+        // left by the visit are compacted once there are enough of them.
+        template<typename VF>
+        bool visit(VF& vf)
+        {
+            bool modified = false;
+            vf.previsit(this);
+            for(VertexIdx v = 0; v < getNumVertices(); ++v)
+            {
+                if(!isDeleted(v))
+                    modified = vf.visit(this, v) || modified;
+            }
+            vf.postvisit(this);
+            compactIfNeeded();
+            return modified;
+        }
+
+        // Parallel visit, the visitor must be thread-safe
+        template<typename VF>
+        bool visitP(VF& vf)
+        {
+            bool modified = false;
+            vf.previsit(this);
+            int64_t numVertices = getNumVertices();
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for(int64_t v = 0; v < numVertices; ++v)
+            {
+                if(!isDeleted(v) && vf.visit(this, v))
+                    modified = true;
+            }
+            vf.postvisit(this);
+            compactIfNeeded();
+            return modified;
+        }
+
+        static const double MAX_DELETED_FRACTION;
+
+    private:
+
+        void swap(CompactGraph& other);
+
+        // Per vertex data
+        std::vector<uint64_t> m_nameOffset;
+        std::vector<uint64_t> m_seqWord;
+        std::vector<uint32_t> m_seqLength;
+        std::vector<uint32_t> m_originLength;
+        std::vector<uint16_t> m_coverage;
+        std::vector<GraphColor> m_vertexColor;
+        std::vector<uint8_t> m_vertexFlags;
+
+        // Side tables of the names and the 2-bit codes of the sequences
+        std::string m_namePool;
+        std::vector<uint64_t> m_bases;
+
+        // The edges of vertex v are m_edges[m_firstEdge[v], m_firstEdge[v + 1])
+        std::vector<EdgeIdx> m_firstEdge;
+        std::vector<CompactEdge> m_edges;
+
+        size_t m_numDeletedVertices;
+        size_t m_numDeletedEdges;
+
+        // Graph parameters
+        bool m_hasContainment;
+        bool m_hasTransitive;
+        bool m_isExactMode;
+        int m_minOverlap;
+        double m_errorRate;
+};
+
+#endif
@@ -139,6 +139,7 @@ class Vertex
         void setColor(GraphColor c) { m_color = c; }
         void setContained(bool c) { m_isContained = c; }
         void setSuperRepeat(bool b) { m_isSuperRepeat = b; }
+        void setCoverage(uint16_t c) { m_coverage = c; }
 		void setOriginLength (size_t l,EdgeDir dir){ m_originLength[dir] = l;}
 
         // getters
@@ -0,0 +1,215 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// LocalityReorder - Generate work items in an order that
+// keeps consecutive reads on nearby regions of the FM-index,
+// and restore the input order before the results are
+// handed to the post processor.
+//
+#ifndef LOCALITYREORDER_H
+#define LOCALITYREORDER_H
+
+#include <map>
+#include <algorithm>
+#include "SequenceWorkItem.h"
+
+namespace LocalityReorder
+{
+
+// Number of reads that are buffered and sorted at once. The reorder
+// post processor holds at most about this many results in memory.
+const size_t DEFAULT_WINDOW_SIZE = 1000000;
+
+// Length of the minimizer kmer used as the sort key, at most 32
+const int DEFAULT_KMER_SIZE = 21;
+
+// Integer mixing function used to rank kmers when picking the minimizer.
+// Ranking on the raw 2-bit code would always favour poly-A kmers.
+inline uint64_t hashKmer(uint64_t key)
+{
+    key = (~key) + (key << 21);
+    key = key ^ (key >> 24);
+    key = (key + (key << 3)) + (key << 8);
+    key = key ^ (key >> 14);
+    key = (key + (key << 2)) + (key << 4);
+    key = key ^ (key >> 28);
+    key = key + (key << 31);
+    return key;
+}
+
+// Return the 2-bit code of the canonical minimizer of seq.
+// Bases are coded in lexicographic order so sorting on the code
+// sorts reads by the suffix array interval of their minimizer kmer.
+// Reads without a valid kmer get the largest key and go last.
+inline uint64_t computeKey(const std::string& seq, int k)
+{
+    assert(k > 0 && k <= 32);
+    const uint64_t mask = (k == 32) ? (uint64_t)-1 : (((uint64_t)1 << (2 * k)) - 1);
+    const int rcShift = 2 * (k - 1);
+
+    uint64_t fwd = 0;
+    uint64_t rvc = 0;
+    int validLength = 0;
+
+    uint64_t bestKey = (uint64_t)-1;
+    uint64_t bestHash = (uint64_t)-1;
+    for(size_t i = 0; i < seq.size(); ++i)
+    {
+        uint64_t code;
+        switch(seq[i])
+        {
+            case 'A': code = 0; break;
+            case 'C': code = 1; break;
+            case 'G': code = 2; break;
+            case 'T': code = 3; break;
+            default:
+                // Kmers spanning an ambiguous base are skipped
+                validLength = 0;
+                continue;
+        }
+
+        fwd = ((fwd << 2) | code) & mask;
+        rvc = (rvc >> 2) | ((3 - code) << rcShift);
+        if(++validLength < k)
+            continue;
+
+        // Use the canonical kmer so both strands of a locus share a key
+        uint64_t canonical = std::min(fwd, rvc);
+        uint64_t h = hashKmer(canonical);
+        if(h < bestHash)
+        {
+            bestHash = h;
+            bestKey = canonical;
+        }
+    }
+    return bestKey;
+}
+
+};
+
+// Generate SequenceWorkItems by taking a window of items from another
+// generator, sorting it on the minimizer key and emitting the window in
+// sorted order. The idx of each work item is the one assigned by the
+// wrapped generator, normally the position of the read in the input.
+// When this generator is used with the n parameter of the framework,
+// the first n generated items are not necessarily the first n reads.
+template<class Generator>
+class LocalityWorkItemGenerator
+{
+    public:
+
+        LocalityWorkItemGenerator(Generator* pGenerator,
+                                  int kmerSize = LocalityReorder::DEFAULT_KMER_SIZE,
+                                  size_t windowSize = LocalityReorder::DEFAULT_WINDOW_SIZE) :
+                                                             m_pGenerator(pGenerator),
+                                                             m_kmerSize(kmerSize),
+                                                             m_windowSize(windowSize),
+                                                             m_nextInWindow(0),
+                                                             m_numConsumedLast(0),
+                                                             m_numConsumedTotal(0)
+        {
+            assert(m_windowSize > 0);
+        }
+
+        // Returns false when no more items could be consumed from the wrapped generator
+        bool generate(SequenceWorkItem& out)
+        {
+            if(m_nextInWindow == m_order.size() && !fillWindow())
+                return false;
+
+            out = m_window[m_order[m_nextInWindow].second];
+            ++m_nextInWindow;
+
+            m_numConsumedLast = 1;
+            m_numConsumedTotal += 1;
+            return true;
+        }
+
+        inline size_t getConsumedLast() const { return m_numConsumedLast; }
+        inline size_t getNumConsumed() const { return m_numConsumedTotal; }
+
+    private:
+
+        typedef std::pair<uint64_t, size_t> KeyIndexPair;
+        typedef std::vector<KeyIndexPair> KeyIndexVector;
+
+        // Take the next window of items and sort it on the minimizer key.
+        // Ties are broken on the window position so the order is deterministic.
+        bool fillWindow()
+        {
+            m_window.clear();
+            m_order.clear();
+            m_nextInWindow = 0;
+
+            SequenceWorkItem item;
+            while(m_window.size() < m_windowSize && m_pGenerator->generate(item))
+            {
+                m_order.push_back(KeyIndexPair(LocalityReorder::computeKey(item.read.seq.toString(), m_kmerSize), m_window.size()));
+                m_window.push_back(item);
+            }
+
+            std::sort(m_order.begin(), m_order.end());
+            return !m_window.empty();
+        }
+
+        Generator* m_pGenerator;
+        int m_kmerSize;
+        size_t m_windowSize;
+
+        std::vector<SequenceWorkItem> m_window;
+        KeyIndexVector m_order;
+        size_t m_nextInWindow;
+
+        size_t m_numConsumedLast;
+        size_t m_numConsumedTotal;
+};
+
+// Wrap a post processor so that it sees the work items in input order
+// (by idx) regardless of the order they were generated in. Results that
+// arrive early are buffered until all items before them are done.
+template<class Input, class Output, class PostProcessor>
+class ReorderPostProcess
+{
+    public:
+        ReorderPostProcess(PostProcessor* pPostProcessor) : m_pPostProcessor(pPostProcessor), m_nextIdx(0) {}
+
+        ~ReorderPostProcess()
+        {
+            assert(m_pending.empty());
+        }
+
+        void process(const Input& item, const Output& result)
+        {
+            if(item.idx != m_nextIdx)
+            {
+                assert(item.idx > m_nextIdx);
+                m_pending.insert(std::make_pair(item.idx, std::make_pair(item, result)));
+                return;
+            }
+
+            m_pPostProcessor->process(item, result);
+            ++m_nextIdx;
+
+            // Release the buffered results that are now in order
+            typename PendingMap::iterator iter = m_pending.begin();
+            while(iter != m_pending.end() && iter->first == m_nextIdx)
+            {
+                m_pPostProcessor->process(iter->second.first, iter->second.second);
+                ++m_nextIdx;
+                m_pending.erase(iter++);
+            }
+        }
+
+        size_t getNumPending() const { return m_pending.size(); }
+
+    private:
+        typedef std::map<size_t, std::pair<Input, Output> > PendingMap;
+
+        PostProcessor* m_pPostProcessor;
+        PendingMap m_pending;
+        size_t m_nextIdx;
+};
+
+#endif
@@ -14,25 +14,64 @@
 //
 OverlapProcess::OverlapProcess(const std::string& outFile, 
                                const OverlapAlgorithm* pOverlapper, 
-                               int minOverlap) : m_pOverlapper(pOverlapper), 
+                               int minOverlap,
+                               Checkpoint* pCheckpoint) : m_pOverlapper(pOverlapper), 
+                                                          m_minOverlap(minOverlap)
+{
+    if(pCheckpoint != NULL)
+        m_pWriter = pCheckpoint->openOutput(outFile);
+    else
+        m_pWriter = createWriter(outFile);
+
+    // A resumed file already starts with the header
+    bool isResuming = pCheckpoint != NULL && pCheckpoint->isResuming();
+    m_pHitWriter = new OverlapHitWriter(m_pWriter, !isResuming);
+}
+
+//
+OverlapProcess::OverlapProcess(const OverlapAlgorithm* pOverlapper, 
+                               int minOverlap) : m_pWriter(NULL),
+                                                 m_pHitWriter(NULL),
+                                                 m_pOverlapper(pOverlapper), 
                                                  m_minOverlap(minOverlap)
 {
-    m_pWriter = createWriter(outFile);
+
 }
 
 //
 OverlapProcess::~OverlapProcess()
 {
+    delete m_pHitWriter;
     delete m_pWriter;
 }
 
 //
 OverlapResult OverlapProcess::process(const SequenceWorkItem& workItem)
 {
+    assert(m_pHitWriter != NULL);
+    OverlapResult result = computeHits(workItem, m_hits);
+    m_pHitWriter->write(workItem.idx, m_hits);
+    return result;
+}
+
+//
+OverlapResult OverlapProcess::computeHits(const SequenceWorkItem& workItem, OverlapHitVector& hits)
+{
+    // Contained reads are removed from the graph, so only their vertex is written
+    hits.clear();
+    if(m_pOverlapper->isContainedRead(workItem.idx))
+    {
+        OverlapResult result;
+        result.isSubstring = true;
+        return result;
+    }
+
 	//compute overlap of workItem.read with results stored in m_blockList, where each block stores SA intervals of overlapping reads
     OverlapResult result = m_pOverlapper->overlapRead(workItem.read, m_minOverlap, &m_blockList);
+    if(result.isSuperRepeat)
+        m_pOverlapper->setSuperRepeatRead(workItem.idx);
 
-	//Convert list of overlap blocks into Edges
+	//Convert list of overlap blocks into hits between read indices
     OverlapBlockList::iterator it = m_blockList.begin();
 	for(; it != m_blockList.end(); it++)
     {
@@ -49,7 +88,11 @@ OverlapResult OverlapProcess::process(const SequenceWorkItem& workItem)
             int64_t saIdx = j;
 
             // The index of the second read is given as the position in the SuffixArray index
-            const ReadInfo& targetInfo = m_pOverlapper->getTargetRIT()->getReadInfo(pCurrSAI->get(saIdx).getID());
+            size_t targetIdx = pCurrSAI->get(saIdx).getID();
+            if(m_pOverlapper->isContainedRead(targetIdx))
+                continue;
+
+            const ReadInfo& targetInfo = m_pOverlapper->getTargetRIT()->getReadInfo(targetIdx);
 
             // Skip self alignments and non-canonical (where the query read has a lexo. higher name)
             if(queryInfo.id != targetInfo.id)
@@ -83,8 +126,7 @@ OverlapResult OverlapProcess::process(const SequenceWorkItem& workItem)
 								
 				//assert(isQuerySuperRepeat || o.id[0] > o.id[1]);
 				
-                ASQG::EdgeRecord edgeRecord( o );
-				edgeRecord.write( *m_pWriter );
+                hits.push_back(OverlapHit(targetIdx, o.match));
             }
         }
     }
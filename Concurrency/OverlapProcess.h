@@ -12,21 +12,34 @@
 #include "Util.h"
 #include "OverlapAlgorithm.h"
 #include "SequenceProcessFramework.h"
+#include "../SQG/OverlapHitFile.h"
 
 // Compute the overlap blocks for reads
 class OverlapProcess
 {
     public:
+        // The overlaps are written to outFile as a binary hit file.
+        // If pCheckpoint is set, outFile is opened through it so the
+        // hits written by this process are part of the checkpoints
         OverlapProcess(const std::string& outFile, 
                        const OverlapAlgorithm* pOverlapper, 
-                       int minOverlap);
+                       int minOverlap,
+                       Checkpoint* pCheckpoint = NULL);
+
+        // The hits are only returned by computeHits, no file is written
+        OverlapProcess(const OverlapAlgorithm* pOverlapper, int minOverlap);
 
         ~OverlapProcess();
 
         OverlapResult process(const SequenceWorkItem& item);
+
+        // Compute the hits of the read without writing them
+        OverlapResult computeHits(const SequenceWorkItem& item, OverlapHitVector& hits);
     
     private:
         std::ostream* m_pWriter;
+        OverlapHitWriter* m_pHitWriter;
+        OverlapHitVector m_hits;
         OverlapBlockList m_blockList;
         const OverlapAlgorithm* m_pOverlapper;
         const int m_minOverlap;
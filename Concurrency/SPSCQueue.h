@@ -0,0 +1,84 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// SPSCQueue - Bounded queue between exactly one producer
+// thread and one consumer thread. The ring buffer itself is
+// lock-free: each index is only written by one side. The
+// semaphores count free and filled slots so either side
+// can block when the queue is full or empty.
+//
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <semaphore.h>
+#include "Util.h"
+
+template<class T>
+class SPSCQueue
+{
+    public:
+        SPSCQueue(size_t capacity) : m_slots(capacity), m_head(0), m_tail(0)
+        {
+            assert(capacity > 0);
+            if(sem_init(&m_freeSem, PTHREAD_PROCESS_PRIVATE, capacity) != 0 ||
+               sem_init(&m_filledSem, PTHREAD_PROCESS_PRIVATE, 0) != 0)
+            {
+                std::cerr << "Semaphore initialization failed\n";
+                std::cerr << "You are probably running on OSX which does not provide unnamed semaphores\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        ~SPSCQueue()
+        {
+            sem_destroy(&m_freeSem);
+            sem_destroy(&m_filledSem);
+        }
+
+        // Producer side, blocks while the queue is full
+        void push(const T& item)
+        {
+            sem_wait(&m_freeSem);
+            m_slots[m_tail] = item;
+            m_tail = (m_tail + 1) % m_slots.size();
+            sem_post(&m_filledSem);
+        }
+
+        // Consumer side, blocks while the queue is empty
+        T pop()
+        {
+            sem_wait(&m_filledSem);
+            T item = m_slots[m_head];
+            m_head = (m_head + 1) % m_slots.size();
+            sem_post(&m_freeSem);
+            return item;
+        }
+
+        // Consumer side, returns false instead of blocking if the queue is empty
+        bool tryPop(T& item)
+        {
+            if(sem_trywait(&m_filledSem) != 0)
+                return false;
+            item = m_slots[m_head];
+            m_head = (m_head + 1) % m_slots.size();
+            sem_post(&m_freeSem);
+            return true;
+        }
+
+        size_t capacity() const { return m_slots.size(); }
+
+    private:
+        std::vector<T> m_slots;
+
+        // m_tail is only touched by the producer and m_head by the consumer.
+        // The semaphore operations order the slot accesses between the threads.
+        size_t m_head;
+        size_t m_tail;
+
+        sem_t m_freeSem;
+        sem_t m_filledSem;
+};
+
+#endif
@@ -8,9 +8,13 @@
 // some operations on input data produced by a generator,
 // serially or in parallel.
 //
-#include "ThreadWorker.h"
+#include "WorkStealingScheduler.h"
+#include "SPSCQueue.h"
 #include "Timer.h"
 #include "SequenceWorkItem.h"
+#include "LocalityReorder.h"
+#include "Checkpoint.h"
+#include "NUMA.h"
 #include "config.h"
 
 #if HAVE_OPENMP
@@ -25,14 +29,60 @@ namespace SequenceProcessFramework
 
 const size_t BUFFER_SIZE = 1000;
 
+// Number of work items in a chunk of the work stealing scheduler.
+// It must be even so both mates of a read pair go to the same worker.
+const size_t CHUNK_SIZE = 64;
+
+// The progress messages are printed to stdout unless a subprogram that
+// writes its results to stdout redirects them with setReportStream.
+inline FILE*& reportStream()
+{
+    static FILE* pStream = stdout;
+    return pStream;
+}
+
+inline FILE* getReportStream() { return reportStream(); }
+inline void setReportStream(FILE* pStream) { reportStream() = pStream; }
+
+// Skip the work items that were completed before the checkpoint was written.
+// The generator must produce the items in the same order as the interrupted run.
+// Returns the number of items skipped.
+template<class Input, class Generator>
+size_t skipCompletedWork(Generator& generator, Checkpoint* pCheckpoint)
+{
+    if(pCheckpoint == NULL)
+        return 0;
+
+    pCheckpoint->validate();
+
+    Input workItem;
+    size_t numSkipped = 0;
+    while(numSkipped < pCheckpoint->getNumCompleted() && generator.generate(workItem))
+        ++numSkipped;
+
+    if(numSkipped != pCheckpoint->getNumCompleted())
+    {
+        std::cerr << "Error: the input has fewer work items than the checkpoint (" << numSkipped << " < " << pCheckpoint->getNumCompleted() << ")\n";
+        exit(EXIT_FAILURE);
+    }
+
+    if(numSkipped > 0)
+        fprintf(getReportStream(), "Skipped %zu work items completed before the checkpoint\n", numSkipped);
+    return numSkipped;
+}
+
 // Generic function to process n work items from a file.
 // With the default value of -1, n becomes the largest value representable for
-// a size_t and all values will be read
+// a size_t and all values will be read.
+// If pCheckpoint is set, the work completed by a previous run is skipped and
+// a checkpoint is written whenever it is due and once all items are done.
 template<class Input, class Output, class Generator, class Processor, class PostProcessor>
-size_t processWorkSerial(Generator& generator, Processor* pProcessor, PostProcessor* pPostProcessor, size_t n = -1)
+size_t processWorkSerial(Generator& generator, Processor* pProcessor, PostProcessor* pPostProcessor, size_t n = -1,
+                         Checkpoint* pCheckpoint = NULL)
 {
     Timer timer("SequenceProcess", true);
     Input workItem;
+    size_t numWorkItems = skipCompletedWork<Input>(generator, pCheckpoint);
 
     // Generate work items using the generic generation class while the number
     // of sequences consumed from the SeqReader is less than n and there
@@ -42,15 +92,22 @@ size_t processWorkSerial(Generator& generator, Processor* pProcessor, PostProces
         Output output = pProcessor->process(workItem);
 
         pPostProcessor->process(workItem, output);
+        ++numWorkItems;
+
         if(generator.getNumConsumed() % 50000 == 0)
-            printf("Processed %zu sequences (%lfs elapsed)\n", generator.getNumConsumed(), timer.getElapsedWallTime());
+            fprintf(getReportStream(), "Processed %zu sequences (%lfs elapsed)\n", generator.getNumConsumed(), timer.getElapsedWallTime());
+
+        if(pCheckpoint != NULL && pCheckpoint->isDue())
+            pCheckpoint->write(numWorkItems);
     }
 
     assert(n == (size_t)-1 || generator.getNumConsumed() == n);
+    if(pCheckpoint != NULL)
+        pCheckpoint->write(numWorkItems);
 
     //
     double proc_time_secs = timer.getElapsedWallTime();
-    printf("Processed %zu sequences in %lfs (%lf sequences/s)\n",
+    fprintf(getReportStream(), "Processed %zu sequences in %lfs (%lf sequences/s)\n",
             generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
 
     return generator.getNumConsumed();
@@ -71,7 +128,8 @@ size_t processSequencesSerial(SeqReader& reader, Processor* pProcessor, PostProc
 
 // Wrapper function for performing operations over every sequence read in readsFile
 template<class Input, class Output, class Processor, class PostProcessor>
-size_t processSequencesSerial(const std::string& readsFile, Processor* pProcessor, PostProcessor* pPostProcessor)
+size_t processSequencesSerial(const std::string& readsFile, Processor* pProcessor, PostProcessor* pPostProcessor,
+                              Checkpoint* pCheckpoint = NULL)
 {
     SeqReader reader(readsFile);
     WorkItemGenerator<Input> generator(&reader);
@@ -79,165 +137,225 @@ size_t processSequencesSerial(const std::string& readsFile, Processor* pProcesso
                              Output,
                              WorkItemGenerator<Input>,
                              Processor,
-                             PostProcessor>(generator, pProcessor, pPostProcessor);
+                             PostProcessor>(generator, pProcessor, pPostProcessor, -1, pCheckpoint);
 }
 
-
-// Design:
-// This function is a generic function to read some INPUT from a
-// generic generator object, then perform work on them.
-// The actual processing is done by the Processor class
-// that is passed in. The number of threads
-// created is determined by the size of the vector of processors -
-// one thread per processor.
-//
-// The function buffers batches of input data.
-// Once the buffers are full, the reads are dispatched to the thread
-// which run the actual processing independently. An optional post processor
-// can be specified to process the results that the threads return. If the n
-// parameter is used, at most n sequences will be read from the file.
-//
-// This version is based on pthreads.
-template<class Input, class Output, class Generator, class Processor, class PostProcessor>
-size_t processWorkParallelPthread(Generator& generator,
-                                  std::vector<Processor*> processPtrVector,
-                                  PostProcessor* pPostProcessor,
-                                  size_t n = -1)
+// State shared by the stages of processWorkParallelStealing
+template<class Input, class Output, class Generator, class Processor>
+struct PipelineState
 {
-    Timer timer("SequenceProcess", true);
+    typedef Input InputType;
+    typedef WorkStealingScheduler<Input, Output, Processor> Scheduler;
+    typedef typename Scheduler::Chunk Chunk;
 
-    // Helpful typedefs
-    typedef ThreadWorker<Input, Output, Processor> Thread;
-    typedef std::vector<Thread*> ThreadPtrVector;
+    PipelineState(size_t queueSize) : queue(queueSize), freeChunks(queueSize + 2), numWorkItemsRead(0), checkpointRequested(false)
+    {
+        sem_init(&resumeSem, PTHREAD_PROCESS_PRIVATE, 0);
+    }
+
+    ~PipelineState()
+    {
+        sem_destroy(&resumeSem);
+    }
 
-    typedef std::vector<Input> InputItemVector;
-    typedef std::vector<InputItemVector*> InputBufferVector;
+    Generator* pGenerator;
+    Scheduler* pScheduler;
+    size_t n;
 
-    typedef std::vector<Output> OutputVector;
-    typedef std::vector<OutputVector*> OutputBufferVector;
-    typedef std::vector<sem_t*> SemaphorePtrVector;
+    // Chunks in input order, from the reader to the writer. A chunk without
+    // inputs marks a checkpoint and NULL marks the end of the input.
+    SPSCQueue<Chunk*> queue;
 
+    // Chunks that have been written, returned by the writer so the reader can
+    // refill them. At most queueSize + 1 chunks exist so pushing never blocks.
+    SPSCQueue<Chunk*> freeChunks;
+    size_t numWorkItemsRead;
 
-    // Initialize threads, one thread per processor that was passed in
-    int numThreads = processPtrVector.size();
+    // Set by the writer when a checkpoint is due. The reader answers with a
+    // checkpoint marker and waits on resumeSem until the checkpoint is written.
+    volatile bool checkpointRequested;
+    sem_t resumeSem;
+};
 
-    ThreadPtrVector threadVec(numThreads);
-    InputBufferVector inputBuffers(numThreads);
-    OutputBufferVector outputBuffers(numThreads);
-    SemaphorePtrVector semVec(numThreads);
+// Reader stage of processWorkParallelStealing. Cuts the input into chunks,
+// queues them for the writer and hands them to the workers.
+template<class State>
+void* runPipelineReader(void* obj)
+{
+    typedef typename State::Chunk Chunk;
+    State* pState = static_cast<State*>(obj);
 
-    // Create the threads
-    for(int i = 0; i < numThreads; ++i)
+    while(1)
     {
-        semVec[i] = new sem_t;
-        int ret = sem_init( semVec[i], PTHREAD_PROCESS_PRIVATE, 0 );
-        if(ret != 0)
+        __sync_synchronize();
+        if(pState->checkpointRequested)
         {
-            std::cerr << "Semaphore initialization failed with error " << ret << "\n";
-            std::cerr << "You are probably running on OSX which does not provide unnamed semaphores\n";
-            exit(EXIT_FAILURE);
+            pState->queue.push(new Chunk);
+            sem_wait(&pState->resumeSem);
+            continue;
         }
 
-        // Create and start the thread
-        threadVec[i] = new Thread(semVec[i], processPtrVector[i], BUFFER_SIZE);
-        threadVec[i]->start();
+        // Reuse a written chunk if there is one. Its work items keep the string
+        // buffers of the previous records, so refilling them in place does not
+        // allocate once the buffers are large enough.
+        Chunk* pChunk;
+        if(!pState->freeChunks.tryPop(pChunk))
+            pChunk = new Chunk;
+        pChunk->inputs.resize(CHUNK_SIZE);
 
-        inputBuffers[i] = new InputItemVector;
-        inputBuffers[i]->reserve(BUFFER_SIZE);
+        size_t numItems = 0;
+        while(numItems < CHUNK_SIZE && pState->pGenerator->getNumConsumed() < pState->n && pState->pGenerator->generate(pChunk->inputs[numItems]))
+            ++numItems;
+
+        if(numItems == 0)
+        {
+            delete pChunk;
+            break;
+        }
 
-        outputBuffers[i] = new OutputVector;
-        outputBuffers[i]->reserve(BUFFER_SIZE);
+        bool inputDone = numItems < CHUNK_SIZE;
+        if(inputDone)
+            pChunk->inputs.resize(numItems);
+        pState->numWorkItemsRead += pChunk->inputs.size();
+
+        // Queue the chunk before submitting it so the queue bounds the work in flight
+        pState->queue.push(pChunk);
+        pState->pScheduler->submit(pChunk);
+        if(inputDone)
+            break;
     }
 
-    size_t numWorkItemsRead = 0;
+    pState->queue.push(NULL);
+    return NULL;
+}
+
+// Design:
+// This function reads INPUT from a generic generator object and processes
+// it with one thread per processor, as a three stage pipeline without a
+// barrier between batches:
+//
+// - A reader thread runs the generator and cuts the input into chunks of
+//   CHUNK_SIZE items. Each chunk is given to the workers and put on a
+//   bounded queue that keeps the chunks in input order.
+// - The workers take chunks from per-thread deques. A thread that runs out
+//   of work steals chunks from the other threads, so a batch of slow reads
+//   does not hold up the threads that finished early.
+// - The calling thread is the writer. It takes the chunks off the queue in
+//   order, waits for each to finish and hands the results to the post
+//   processor, so parsing, processing and writing overlap.
+//
+// The queue holds at most 2 * BUFFER_SIZE items per thread, which bounds
+// both the read-ahead and the results waiting to be written. Written chunks
+// go back to the reader and are refilled in place, so the work items are
+// not copied and their buffers are reused for the whole run. When a
+// checkpoint is due the reader stops at a marker and the checkpoint is
+// written once everything before the marker has been post processed.
+template<class Input, class Output, class Generator, class Processor, class PostProcessor>
+size_t processWorkParallelStealing(Generator& generator,
+                                   std::vector<Processor*> processPtrVector,
+                                   PostProcessor* pPostProcessor,
+                                   size_t n = -1,
+                                   Checkpoint* pCheckpoint = NULL)
+{
+    Timer timer("SequenceProcess", true);
+
+    typedef PipelineState<Input, Output, Generator, Processor> State;
+    typedef typename State::Scheduler Scheduler;
+    typedef typename State::Chunk Chunk;
+
+    size_t numThreads = processPtrVector.size();
+    size_t maxPendingChunks = (2 * BUFFER_SIZE * numThreads + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    size_t numWorkItemsSkipped = skipCompletedWork<Input>(generator, pCheckpoint);
     size_t numWorkItemsWrote = 0;
-    bool done = false;
-    int next_thread = 0;
-    int num_buffers_full = 0;
+    size_t nextReport = 10 * BUFFER_SIZE * numThreads;
 
-    while(!done)
+    Scheduler scheduler(processPtrVector);
+    State state(maxPendingChunks);
+    state.pGenerator = &generator;
+    state.pScheduler = &scheduler;
+    state.n = n;
+
+    pthread_t readerThread;
+    int ret = pthread_create(&readerThread, 0, &runPipelineReader<State>, &state);
+    if(ret != 0)
     {
-        // Parse reads from the stream and add them into the incoming buffers
-        Input workItem;
-        bool valid = generator.generate(workItem);
-        if(valid)
-        {
-            inputBuffers[next_thread]->push_back(workItem);
-            numWorkItemsRead += 1;
+        std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
-            // Change buffers if this one is full
-            if(inputBuffers[next_thread]->size() == BUFFER_SIZE)
-            {
-                ++num_buffers_full;
-                ++next_thread;
-            }
+    while(1)
+    {
+        Chunk* pChunk = state.queue.pop();
+        if(pChunk == NULL)
+            break;
+
+        if(pChunk->inputs.empty())
+        {
+            // Every chunk before the marker has been written and the reader is paused
+            assert(pCheckpoint != NULL);
+            pCheckpoint->write(numWorkItemsSkipped + numWorkItemsWrote);
+            delete pChunk;
+            state.checkpointRequested = false;
+            __sync_synchronize();
+            sem_post(&state.resumeSem);
+            continue;
         }
 
-        done = !valid || generator.getNumConsumed() == n;
+        while(!scheduler.isDone(pChunk))
+            scheduler.waitForAny();
+
+        assert(pChunk->inputs.size() == pChunk->outputs.size());
+        for(size_t i = 0; i < pChunk->inputs.size(); ++i)
+            pPostProcessor->process(pChunk->inputs[i], pChunk->outputs[i]);
+        numWorkItemsWrote += pChunk->inputs.size();
+
+        pChunk->reset();
+        state.freeChunks.push(pChunk);
 
-        // Once all buffers are full or the input is finished, dispatch the reads to the threads
-        // by swapping work buffers.
-        if(num_buffers_full == numThreads || done)
+        if(numWorkItemsWrote >= nextReport)
         {
-            int numLoops = 0;
-            do
-            {
-                // Wait for all threads to be ready to receive
-                for(int i = 0; i < numThreads; ++i)
-                {
-                    sem_wait(semVec[i]);
-                    Thread* pThread = threadVec[i];
-                    pThread->swapBuffers(*inputBuffers[i], *outputBuffers[i]);
-                }
-                num_buffers_full = 0;
-                next_thread = 0;
-
-                // Process the results and clear the buffers
-                for(int i = 0; i < numThreads; ++i)
-                {
-                    assert(inputBuffers[i]->size() == outputBuffers[i]->size());
-                    for(size_t j = 0; j < inputBuffers[i]->size(); ++j)
-                    {
-                        pPostProcessor->process((*inputBuffers[i])[j], (*outputBuffers[i])[j]);
-                        ++numWorkItemsWrote;
-                    }
-
-                    inputBuffers[i]->clear();
-                    outputBuffers[i]->clear();
-                }
-
-                double proc_time_secs = timer.getElapsedWallTime();
-                if(generator.getNumConsumed() % (10 * BUFFER_SIZE * numThreads) == 0)
-                    printf("Processed %zu sequences in %lfs (%lf sequences/s)\n", generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
-
-                // This should never loop more than twice
-                assert(numLoops < 2);
-                ++numLoops;
-            } while(done && numWorkItemsWrote < numWorkItemsRead);
+            double proc_time_secs = timer.getElapsedWallTime();
+            fprintf(getReportStream(), "Processed %zu sequences in %lfs (%lf sequences/s)\n", numWorkItemsWrote, proc_time_secs, (double)numWorkItemsWrote / proc_time_secs);
+            nextReport += 10 * BUFFER_SIZE * numThreads;
+        }
+
+        if(pCheckpoint != NULL && !state.checkpointRequested && pCheckpoint->isDue())
+        {
+            state.checkpointRequested = true;
+            __sync_synchronize();
         }
     }
 
-    // Cleanup
-    for(int i = 0; i < numThreads; ++i)
+    ret = pthread_join(readerThread, NULL);
+    if(ret != 0)
     {
-        threadVec[i]->stop(); // Blocks until the thread joins
-        delete threadVec[i];
-
-        sem_destroy(semVec[i]);
-        delete semVec[i];
+        std::cerr << "Thread join failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
-        assert(inputBuffers[i]->empty());
-        delete inputBuffers[i];
+    Chunk* pFreeChunk;
+    while(state.freeChunks.tryPop(pFreeChunk))
+        delete pFreeChunk;
 
-        assert(outputBuffers[i]->empty());
-        delete outputBuffers[i];
-    }
     assert(n == (size_t)-1 || generator.getNumConsumed() == n);
-    assert(numWorkItemsRead == numWorkItemsWrote);
+    assert(state.numWorkItemsRead == numWorkItemsWrote);
+    if(pCheckpoint != NULL)
+        pCheckpoint->write(numWorkItemsSkipped + numWorkItemsWrote);
 
     double proc_time_secs = timer.getElapsedWallTime();
-    printf("Processed %zu sequences in %lfs (%lf sequences/s)\n",
+    fprintf(getReportStream(), "Processed %zu sequences in %lfs (%lf sequences/s)\n",
             generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
+
+    if(NUMA::isEnabled())
+    {
+        // Report the work done by the threads of each node
+        std::vector<size_t> nodeCounts(NUMA::getNumNodes(), 0);
+        for(size_t i = 0; i < scheduler.getNumThreads(); ++i)
+            nodeCounts[NUMA::getNodeForThread(i)] += scheduler.getNumProcessed(i);
+        for(size_t i = 0; i < nodeCounts.size(); ++i)
+            fprintf(getReportStream(), "[numa] node %zu processed %zu sequences (%lf sequences/s)\n", i, nodeCounts[i], (double)nodeCounts[i] / proc_time_secs);
+    }
     return generator.getNumConsumed();
 }
 
@@ -317,7 +435,7 @@ size_t processWorkParallelOpenMP(Generator& generator,
 
             double proc_time_secs = timer.getElapsedWallTime();
             if(generator.getNumConsumed() % (numThreads * BUFFER_SIZE) == 0)
-                printf("Processed %zu sequences in %lfs (%lf sequences/s)\n", generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
+                fprintf(getReportStream(), "Processed %zu sequences in %lfs (%lf sequences/s)\n", generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
         }
     }
 
@@ -325,7 +443,7 @@ size_t processWorkParallelOpenMP(Generator& generator,
     assert(numWorkItemsRead == numWorkItemsWrote);
 
     double proc_time_secs = timer.getElapsedWallTime();
-    printf("Processed %zu sequences in %lfs (%lf sequences/s)\n",
+    fprintf(getReportStream(), "Processed %zu sequences in %lfs (%lf sequences/s)\n",
             generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
     
 	#pragma omp barrier
@@ -346,15 +464,16 @@ template<class Input, class Output, class Processor, class PostProcessor>
 size_t processSequencesParallel(SeqReader& reader,
                                 std::vector<Processor*> processPtrVector,
                                 PostProcessor* pPostProcessor,
-                                size_t n = -1)
+                                size_t n = -1,
+                                Checkpoint* pCheckpoint = NULL)
 {
     typedef WorkItemGenerator<Input> InputGenerator;
     InputGenerator generator(&reader);
-    return processWorkParallelPthread<Input,
-                                      Output,
-                                      InputGenerator,
-                                      Processor,
-                                      PostProcessor>(generator, processPtrVector, pPostProcessor, n);
+    return processWorkParallelStealing<Input,
+                                       Output,
+                                       InputGenerator,
+                                       Processor,
+                                       PostProcessor>(generator, processPtrVector, pPostProcessor, n, pCheckpoint);
 }
 
 // Wrapper function for operating over n elements of from a SeqReader
@@ -375,10 +494,11 @@ size_t processSequencesParallelOpenMP(SeqReader& reader,
 
 // Wrapper function for operating over a file of sequences
 template<class Input, class Output, class Processor, class PostProcessor>
-size_t processSequencesParallel(const std::string& readsFile, std::vector<Processor*> processPtrVector, PostProcessor* pPostProcessor)
+size_t processSequencesParallel(const std::string& readsFile, std::vector<Processor*> processPtrVector, PostProcessor* pPostProcessor,
+                                Checkpoint* pCheckpoint = NULL)
 {
     SeqReader reader(readsFile);
-    return processSequencesParallel<Input, Output, Processor, PostProcessor>(reader, processPtrVector, pPostProcessor);
+    return processSequencesParallel<Input, Output, Processor, PostProcessor>(reader, processPtrVector, pPostProcessor, -1, pCheckpoint);
 }
 
 // Wrapper function for operating over a file of sequences
@@ -390,6 +510,49 @@ size_t processSequencesParallelOpenMP(const std::string& readsFile, std::vector<
 }
 
 
+
+// Wrapper function for operating over a file of sequences in an order that
+// keeps consecutive work items on nearby regions of the FM-index.
+// The post processor still receives the results in input order.
+template<class Input, class Output, class Processor, class PostProcessor>
+size_t processSequencesSerialReordered(const std::string& readsFile,
+                                       Processor* pProcessor,
+                                       PostProcessor* pPostProcessor,
+                                       size_t windowSize = LocalityReorder::DEFAULT_WINDOW_SIZE)
+{
+    typedef LocalityWorkItemGenerator<WorkItemGenerator<Input> > InputGenerator;
+    typedef ReorderPostProcess<Input, Output, PostProcessor> ReorderPostProcessor;
+    SeqReader reader(readsFile);
+    WorkItemGenerator<Input> readerGenerator(&reader);
+    InputGenerator generator(&readerGenerator, LocalityReorder::DEFAULT_KMER_SIZE, windowSize);
+    ReorderPostProcessor reorderPostProcessor(pPostProcessor);
+    return processWorkSerial<Input,
+                             Output,
+                             InputGenerator,
+                             Processor,
+                             ReorderPostProcessor>(generator, pProcessor, &reorderPostProcessor);
+}
+
+// Parallel version of the above
+template<class Input, class Output, class Processor, class PostProcessor>
+size_t processSequencesParallelReordered(const std::string& readsFile,
+                                         std::vector<Processor*> processPtrVector,
+                                         PostProcessor* pPostProcessor,
+                                         size_t windowSize = LocalityReorder::DEFAULT_WINDOW_SIZE)
+{
+    typedef LocalityWorkItemGenerator<WorkItemGenerator<Input> > InputGenerator;
+    typedef ReorderPostProcess<Input, Output, PostProcessor> ReorderPostProcessor;
+    SeqReader reader(readsFile);
+    WorkItemGenerator<Input> readerGenerator(&reader);
+    InputGenerator generator(&readerGenerator, LocalityReorder::DEFAULT_KMER_SIZE, windowSize);
+    ReorderPostProcessor reorderPostProcessor(pPostProcessor);
+    return processWorkParallelStealing<Input,
+                                       Output,
+                                       InputGenerator,
+                                       Processor,
+                                       ReorderPostProcessor>(generator, processPtrVector, &reorderPostProcessor);
+}
+
 };
 
 #endif
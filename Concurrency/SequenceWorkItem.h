@@ -11,6 +11,7 @@
 #define SEQUENCEWORKITEM_H
 
 #include "SeqReader.h"
+#include "PackedReadTable.h"
 
 struct SequenceWorkItem
 {
@@ -35,15 +36,14 @@ class WorkItemGenerator
         WorkItemGenerator(SeqReader* pReader) : m_pReader(pReader), m_numConsumedLast(0), m_numConsumedTotal(0) {}
 
         // Template specialization for a SequenceWorkItem
-        // Returns false when no more sequences could be consumed from the reader
+        // Returns false when no more sequences could be consumed from the reader.
+        // The record is read directly into out, reusing its buffers.
         bool generate(SequenceWorkItem& out)
         {
-            SeqRecord read;
-            bool valid = m_pReader->get(read);
+            bool valid = m_pReader->get(out.read);
             if(valid)
             {
                 out.idx = m_numConsumedTotal;
-                out.read = read;
 
                 m_numConsumedLast = 1;
                 m_numConsumedTotal += 1;
@@ -58,19 +58,14 @@ class WorkItemGenerator
         // Template specialization for a SequenceWorkItemPair
         bool generate(SequenceWorkItemPair& out)
         {
-            SeqRecord read1;
-            SeqRecord read2;
-
-            bool valid1 = m_pReader->get(read1);
+            bool valid1 = m_pReader->get(out.first.read);
             if(valid1)
             {
-                bool valid2 = m_pReader->get(read2);
+                bool valid2 = m_pReader->get(out.second.read);
                 assert(valid2);
 
                 out.first.idx = m_numConsumedTotal;
                 out.second.idx = m_numConsumedTotal + 1;
-                out.first.read = read1;
-                out.second.read = read2;
 
                 m_numConsumedLast = 2;
                 m_numConsumedTotal += 2;
@@ -92,4 +87,118 @@ class WorkItemGenerator
         size_t m_numConsumedTotal;
 };
 
+// Generate pairs of work items from two readers, the first read of each
+// pair from pReader1 and the second from pReader2. For interleaved pairs
+// both readers are the same. Stops as soon as either reader runs out.
+class PairedWorkItemGenerator
+{
+    public:
+
+        PairedWorkItemGenerator(SeqReader* pReader1, SeqReader* pReader2) : m_pReader1(pReader1),
+                                                                            m_pReader2(pReader2),
+                                                                            m_numConsumedLast(0),
+                                                                            m_numConsumedTotal(0) {}
+
+        // Returns false when no complete pair could be consumed from the readers
+        bool generate(SequenceWorkItemPair& out)
+        {
+            if(!m_pReader1->get(out.first.read) || !m_pReader2->get(out.second.read))
+                return false;
+
+            out.first.idx = m_numConsumedTotal;
+            out.second.idx = m_numConsumedTotal + 1;
+
+            m_numConsumedLast = 2;
+            m_numConsumedTotal += 2;
+            return true;
+        }
+
+        inline size_t getConsumedLast() const { return m_numConsumedLast; }
+        inline size_t getNumConsumed() const { return m_numConsumedTotal; }
+
+    private:
+
+        SeqReader* m_pReader1;
+        SeqReader* m_pReader2;
+        size_t m_numConsumedLast;
+        size_t m_numConsumedTotal;
+};
+
+// Generate work items from the reads held in a PackedReadTable
+class PackedReadTableGenerator
+{
+    public:
+
+        PackedReadTableGenerator(const PackedReadTable* pTable) : m_pTable(pTable), m_numConsumedLast(0), m_numConsumedTotal(0) {}
+
+        // Returns false when all the reads in the table have been consumed
+        bool generate(SequenceWorkItem& out)
+        {
+            if(m_numConsumedTotal == m_pTable->getCount())
+                return false;
+
+            out.idx = m_numConsumedTotal;
+            m_pTable->getRead(m_numConsumedTotal, out.read);
+
+            m_numConsumedLast = 1;
+            m_numConsumedTotal += 1;
+            return true;
+        }
+
+        inline size_t getConsumedLast() const { return m_numConsumedLast; }
+        inline size_t getNumConsumed() const { return m_numConsumedTotal; }
+
+    private:
+
+        const PackedReadTable* m_pTable;
+        size_t m_numConsumedLast;
+        size_t m_numConsumedTotal;
+};
+
+// Generate the work items of one shard of the input. The items of the
+// wrapped generator whose idx satisfies idx % numShards == shardIdx are
+// kept and the rest are skipped. The kept items are renumbered 0, 1, 2, ...
+// so the stages downstream see a dense sequence of indices.
+template<class Generator>
+class ShardWorkItemGenerator
+{
+    public:
+
+        ShardWorkItemGenerator(Generator* pGenerator, size_t shardIdx, size_t numShards) : m_pGenerator(pGenerator),
+                                                                                           m_shardIdx(shardIdx),
+                                                                                           m_numShards(numShards),
+                                                                                           m_numConsumedLast(0),
+                                                                                           m_numConsumedTotal(0)
+        {
+            assert(m_shardIdx < m_numShards);
+        }
+
+        // Returns false when the wrapped generator has no more items for this shard
+        bool generate(SequenceWorkItem& out)
+        {
+            while(m_pGenerator->generate(out))
+            {
+                if(out.idx % m_numShards != m_shardIdx)
+                    continue;
+
+                out.idx = m_numConsumedTotal;
+                m_numConsumedLast = 1;
+                m_numConsumedTotal += 1;
+                return true;
+            }
+            return false;
+        }
+
+        inline size_t getConsumedLast() const { return m_numConsumedLast; }
+        inline size_t getNumConsumed() const { return m_numConsumedTotal; }
+
+    private:
+
+        Generator* m_pGenerator;
+        size_t m_shardIdx;
+        size_t m_numShards;
+        size_t m_numConsumedLast;
+        size_t m_numConsumedTotal;
+};
+
 #endif
@@ -0,0 +1,259 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// WorkStealingScheduler - Run chunks of work items on a
+// pool of threads. Each thread has its own deque of chunks.
+// A thread takes chunks from the front of its own deque and,
+// when it runs dry, steals from the back of another thread's
+// deque so no thread waits while there is work left.
+//
+#ifndef WORKSTEALINGSCHEDULER_H
+#define WORKSTEALINGSCHEDULER_H
+
+#include <deque>
+#include <pthread.h>
+#include <semaphore.h>
+#include "Util.h"
+#include "NUMA.h"
+
+// A small batch of work items and the results computed for them
+template<class Input, class Output>
+struct WorkChunk
+{
+    WorkChunk() : done(false) {}
+
+    // Prepare a finished chunk to be filled again. The inputs are kept
+    // so their buffers can be reused.
+    void reset()
+    {
+        outputs.clear();
+        done = false;
+    }
+
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+
+    // Set by the worker once all outputs are filled in
+    volatile bool done;
+};
+
+template<class Input, class Output, class Processor>
+class WorkStealingScheduler
+{
+    public:
+        typedef WorkChunk<Input, Output> Chunk;
+
+        // One thread is started per processor
+        WorkStealingScheduler(const std::vector<Processor*>& processPtrVector);
+
+        // Stops the threads, all submitted chunks must be finished
+        ~WorkStealingScheduler();
+
+        // Queue a chunk for processing. The chunks are spread over the thread deques in turn.
+        void submit(Chunk* pChunk);
+
+        // Returns true if the chunk has been processed
+        bool isDone(const Chunk* pChunk) const
+        {
+            if(!pChunk->done)
+                return false;
+            // Make the outputs written by the worker visible to the caller
+            __sync_synchronize();
+            return true;
+        }
+
+        // Block until some chunk has been processed since the last call
+        void waitForAny() { sem_wait(&m_doneSem); }
+
+        // Number of work items processed by each thread
+        size_t getNumThreads() const { return m_threads.size(); }
+        size_t getNumProcessed(size_t threadIdx) const { return m_threads[threadIdx]->numProcessed; }
+
+    private:
+
+        struct ThreadState
+        {
+            WorkStealingScheduler* pScheduler;
+            Processor* pProcessor;
+            size_t idx;
+            pthread_t thread;
+            pthread_mutex_t mutex;
+            std::deque<Chunk*> chunks;
+            size_t numProcessed;
+        };
+
+        static void* startThread(void* obj);
+        void run(ThreadState* pState);
+
+        // Take a chunk from the thread's own deque or steal one from another thread.
+        // Returns NULL when the scheduler is stopping and there is no more work.
+        Chunk* takeChunk(ThreadState* pState);
+
+        std::vector<ThreadState*> m_threads;
+        size_t m_nextThread;
+
+        // Counts the chunks that are waiting in the deques
+        sem_t m_workSem;
+
+        // Posted once for every chunk that is finished
+        sem_t m_doneSem;
+
+        volatile bool m_stopRequested;
+};
+
+//
+template<class Input, class Output, class Processor>
+WorkStealingScheduler<Input, Output, Processor>::WorkStealingScheduler(const std::vector<Processor*>& processPtrVector) : m_nextThread(0),
+                                                                                                                         m_stopRequested(false)
+{
+    if(sem_init(&m_workSem, PTHREAD_PROCESS_PRIVATE, 0) != 0 || sem_init(&m_doneSem, PTHREAD_PROCESS_PRIVATE, 0) != 0)
+    {
+        std::cerr << "Semaphore initialization failed\n";
+        std::cerr << "You are probably running on OSX which does not provide unnamed semaphores\n";
+        exit(EXIT_FAILURE);
+    }
+
+    for(size_t i = 0; i < processPtrVector.size(); ++i)
+    {
+        ThreadState* pState = new ThreadState;
+        pState->pScheduler = this;
+        pState->pProcessor = processPtrVector[i];
+        pState->idx = i;
+        pState->numProcessed = 0;
+        pthread_mutex_init(&pState->mutex, NULL);
+        m_threads.push_back(pState);
+    }
+
+    // Start the threads once all the deques exist as any thread may steal from any other
+    for(size_t i = 0; i < m_threads.size(); ++i)
+    {
+        int ret = pthread_create(&m_threads[i]->thread, 0, &WorkStealingScheduler::startThread, m_threads[i]);
+        if(ret != 0)
+        {
+            std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+//
+template<class Input, class Output, class Processor>
+WorkStealingScheduler<Input, Output, Processor>::~WorkStealingScheduler()
+{
+    // Wake every thread so it sees the stop flag
+    m_stopRequested = true;
+    for(size_t i = 0; i < m_threads.size(); ++i)
+        sem_post(&m_workSem);
+
+    for(size_t i = 0; i < m_threads.size(); ++i)
+    {
+        int ret = pthread_join(m_threads[i]->thread, NULL);
+        if(ret != 0)
+        {
+            std::cerr << "Thread join failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        assert(m_threads[i]->chunks.empty());
+        pthread_mutex_destroy(&m_threads[i]->mutex);
+        delete m_threads[i];
+    }
+
+    sem_destroy(&m_workSem);
+    sem_destroy(&m_doneSem);
+}
+
+//
+template<class Input, class Output, class Processor>
+void WorkStealingScheduler<Input, Output, Processor>::submit(Chunk* pChunk)
+{
+    ThreadState* pState = m_threads[m_nextThread];
+    m_nextThread = (m_nextThread + 1) % m_threads.size();
+
+    pthread_mutex_lock(&pState->mutex);
+    pState->chunks.push_back(pChunk);
+    pthread_mutex_unlock(&pState->mutex);
+    sem_post(&m_workSem);
+}
+
+//
+template<class Input, class Output, class Processor>
+void* WorkStealingScheduler<Input, Output, Processor>::startThread(void* obj)
+{
+    ThreadState* pState = static_cast<ThreadState*>(obj);
+    pState->pScheduler->run(pState);
+    return NULL;
+}
+
+//
+template<class Input, class Output, class Processor>
+void WorkStealingScheduler<Input, Output, Processor>::run(ThreadState* pState)
+{
+    // Threads are spread over the nodes so each works against nearby memory
+    if(NUMA::isEnabled())
+        NUMA::bindThreadToNode(NUMA::getNodeForThread(pState->idx));
+
+    while(1)
+    {
+        // Block until there is a chunk in some deque
+        sem_wait(&m_workSem);
+
+        Chunk* pChunk = takeChunk(pState);
+        if(pChunk == NULL)
+            break;
+
+        assert(pChunk->outputs.empty());
+        pChunk->outputs.reserve(pChunk->inputs.size());
+        for(size_t i = 0; i < pChunk->inputs.size(); ++i)
+            pChunk->outputs.push_back(pState->pProcessor->process(pChunk->inputs[i]));
+        pState->numProcessed += pChunk->inputs.size();
+
+        __sync_synchronize();
+        pChunk->done = true;
+        sem_post(&m_doneSem);
+    }
+}
+
+//
+template<class Input, class Output, class Processor>
+typename WorkStealingScheduler<Input, Output, Processor>::Chunk* WorkStealingScheduler<Input, Output, Processor>::takeChunk(ThreadState* pState)
+{
+    size_t numThreads = m_threads.size();
+    while(1)
+    {
+        // The owner works from the front so its chunks are finished roughly in order
+        pthread_mutex_lock(&pState->mutex);
+        if(!pState->chunks.empty())
+        {
+            Chunk* pChunk = pState->chunks.front();
+            pState->chunks.pop_front();
+            pthread_mutex_unlock(&pState->mutex);
+            return pChunk;
+        }
+        pthread_mutex_unlock(&pState->mutex);
+
+        // Steal from the back of the other deques
+        for(size_t i = 1; i < numThreads; ++i)
+        {
+            ThreadState* pVictim = m_threads[(pState->idx + i) % numThreads];
+            pthread_mutex_lock(&pVictim->mutex);
+            if(!pVictim->chunks.empty())
+            {
+                Chunk* pChunk = pVictim->chunks.back();
+                pVictim->chunks.pop_back();
+                pthread_mutex_unlock(&pVictim->mutex);
+                return pChunk;
+            }
+            pthread_mutex_unlock(&pVictim->mutex);
+        }
+
+        // The semaphore guarantees a chunk for this thread unless the scheduler
+        // is stopping. The chunk may have been taken by a thread that was woken
+        // for a newer chunk, in which case the newer chunk is found on the next pass.
+        if(m_stopRequested)
+            return NULL;
+    }
+}
+
+#endif
@@ -611,6 +611,13 @@ FMIndexWalkPostProcess::~FMIndexWalkPostProcess()
 	std::cout << "Reads failed to kmerize or merge: " << m_qcFail << "\n";
 }
 
+//
+void FMIndexWalkPostProcess::registerCheckpoint(Checkpoint* pCheckpoint)
+{
+	pCheckpoint->addCounter("kmerizePassed", &m_kmerizePassed);
+	pCheckpoint->addCounter("mergePassed", &m_mergePassed);
+	pCheckpoint->addCounter("qcFail", &m_qcFail);
+}
 
 //
 void FMIndexWalkPostProcess::process(const SequenceWorkItem& item, const FMIndexWalkResult& result)
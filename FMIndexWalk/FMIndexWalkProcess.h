@@ -242,6 +242,9 @@ class FMIndexWalkPostProcess
         void process(const SequenceWorkItem& item, const FMIndexWalkResult& result);
 		void process(const SequenceWorkItemPair& itemPair, const FMIndexWalkResult& result);
 
+        // Save the counters with each checkpoint of the run
+        void registerCheckpoint(Checkpoint* pCheckpoint);
+
     private:
 
         std::ostream* m_pCorrectedWriter;
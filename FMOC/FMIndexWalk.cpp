@@ -45,6 +45,7 @@ static const char *CORRECT_USAGE_MESSAGE =
 "      -v, --verbose                    display verbose output\n"
 "      -p, --prefix=PREFIX              use PREFIX for the names of the index files (default: prefix of the input file)\n"
 "      -o, --outfile=FILE               write the corrected reads to FILE (default: READSFILE.ec.fa)\n"
+"                                       If FILE ends in .prd the reads are written packed into 2 bits per base\n"
 "      -t, --threads=NUM                use NUM threads for the computation (default: 1)\n"
 "      -a, --algorithm=STR              specify the walking algorithm. STR must be hybrid (merge and kmerize) or merge. (default: hybrid)\n"
 "\nMerge parameters:\n"
@@ -54,6 +55,10 @@ static const char *CORRECT_USAGE_MESSAGE =
 "      -I, --max-insertsize=N           the maximum insert size (i.e. search depth) (deault: 400)\n"
 "      -m, --min-overlap=N           the min overlap (default: 81)\n"
 "      -M, --max-overlap=N           the max overlap (default: avg read length*0.9)\n"
+"\nCheckpoint options:\n"
+"          --resume                     continue an interrupted run from its last checkpoint. The other options must be\n"
+"                                       the same as in the interrupted run\n"
+"          --checkpoint-interval=N      write a checkpoint every N seconds, 0 disables checkpoints (default: 600)\n"
 
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
@@ -72,20 +77,23 @@ namespace opt
 
 
     static int kmerLength = 31;
-    static int kmerThreshold = 3;
+    static int kmerThreshold = 3;
     static bool bLearnKmerParams = false;
 
     static int maxLeaves=32;
-	static int maxInsertSize=400;
+	static int maxInsertSize=400;
 	static int minOverlap=81;
 	static int maxOverlap=-1;
 
     static FMIndexWalkAlgorithm algorithm = FMW_HYBRID;
+
+    static bool bResume = false;
+    static int checkpointInterval = Checkpoint::DEFAULT_INTERVAL;
 }
 
 static const char* shortopts = "p:t:o:a:k:x:L:I:m:M:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN, OPT_RESUME, OPT_CHECKPOINT_INTERVAL };
 
 static const struct option longopts[] = {
     { "verbose",       no_argument,       NULL, 'v' },
@@ -103,6 +111,8 @@ static const struct option longopts[] = {
     { "help",          no_argument,       NULL, OPT_HELP },
     { "version",       no_argument,       NULL, OPT_VERSION },
     { "metrics",       required_argument, NULL, OPT_METRICS },
+    { "resume",        no_argument,       NULL, OPT_RESUME },
+    { "checkpoint-interval", required_argument, NULL, OPT_CHECKPOINT_INTERVAL },
     { NULL, 0, NULL, 0 }
 };
 
@@ -112,27 +122,27 @@ static const struct option longopts[] = {
 int FMindexWalkMain(int argc, char** argv)
 {
     parseFMWalkOptions(argc, argv);
-
+
     // Set the error correction parameters
     FMIndexWalkParameters ecParams;
 	BWT *pBWT, *pRBWT;
 	SampledSuffixArray* pSSA;
 
-    // Load indices
+    // Load indices
 	#pragma omp parallel
 	{
 		#pragma omp single nowait
 		{	//Initialization of large BWT takes some time, pass the disk to next job
-			std::cout << std::endl << "Loading BWT: " << opt::prefix + BWT_EXT << "\n";
+			std::cout << std::endl << "Loading BWT: " << opt::prefix + BWT_EXT << "\n";
 			pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
 		}
 		#pragma omp single nowait
 		{
 			std::cout << "Loading RBWT: " << opt::prefix + RBWT_EXT << "\n";
 			pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
-		}
+		}
 		#pragma omp single nowait
-		{
+		{
 			std::cout << "Loading Sampled Suffix Array: " << opt::prefix + SAI_EXT << "\n";
 			pSSA = new SampledSuffixArray(opt::prefix + SAI_EXT, SSA_FT_SAI);
 		}
@@ -142,7 +152,7 @@ int FMindexWalkMain(int argc, char** argv)
     indexSet.pBWT = pBWT;
     indexSet.pRBWT = pRBWT;
     indexSet.pSSA = pSSA;
-    ecParams.indices = indexSet;
+    ecParams.indices = indexSet;
 
 	// Sample 100000 kmer counts into KmerDistribution from reverse BWT 
 	// Don't sample from forward BWT as Illumina reads are bad at the 3' end
@@ -154,21 +164,23 @@ int FMindexWalkMain(int argc, char** argv)
 					<< "\t Repeat frequency cutoff: " << ecParams.kd.getRepeatKmerCutoff() << "\n";
 	
     // Open outfiles and start a timer
-    std::ostream* pWriter = createWriter(opt::outFile);
-    std::ostream* pDiscardWriter = (!opt::discardFile.empty() ? createWriter(opt::discardFile) : NULL);
+    Checkpoint* pCheckpoint = new Checkpoint(opt::outFile + CHECKPOINT_EXT, opt::bResume, opt::checkpointInterval);
+    std::ostream* pWriter = pCheckpoint->openOutput(opt::outFile);
+    std::ostream* pDiscardWriter = (!opt::discardFile.empty() ? pCheckpoint->openOutput(opt::discardFile) : NULL);
     Timer* pTimer = new Timer(PROGRAM_IDENT);
 
     ecParams.algorithm = opt::algorithm;
     ecParams.kmerLength = opt::kmerLength;
     ecParams.printOverlaps = opt::verbose > 0;
 	ecParams.maxLeaves = opt::maxLeaves;
-	ecParams.maxInsertSize = opt::maxInsertSize;
+	ecParams.maxInsertSize = opt::maxInsertSize;
     ecParams.minOverlap = opt::minOverlap;
     ecParams.maxOverlap = opt::maxOverlap;
 	
     // Setup post-processor
     FMIndexWalkPostProcess postProcessor(pWriter, pDiscardWriter, ecParams);
-
+    postProcessor.registerCheckpoint(pCheckpoint);
+
     std::cout << "Merge paired end reads into long reads for " << opt::readsFile << " using \n" 
 				<< "min overlap=" <<  ecParams.minOverlap << "\t"
 				<< "max overlap=" <<  ecParams.maxOverlap << "\t"
@@ -185,13 +197,13 @@ int FMindexWalkMain(int argc, char** argv)
         SequenceProcessFramework::processSequencesSerial<SequenceWorkItemPair,
                                                          FMIndexWalkResult,
                                                          FMIndexWalkProcess,
-                                                         FMIndexWalkPostProcess>(opt::readsFile, &processor, &postProcessor);
+                                                         FMIndexWalkPostProcess>(opt::readsFile, &processor, &postProcessor, pCheckpoint);
 
 		else
         SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
                                                          FMIndexWalkResult,
                                                          FMIndexWalkProcess,
-                                                         FMIndexWalkPostProcess>(opt::readsFile, &processor, &postProcessor);
+                                                         FMIndexWalkPostProcess>(opt::readsFile, &processor, &postProcessor, pCheckpoint);
     }
     else
     {
@@ -207,13 +219,13 @@ int FMindexWalkMain(int argc, char** argv)
         SequenceProcessFramework::processSequencesParallel<SequenceWorkItemPair,
                                                            FMIndexWalkResult,
                                                            FMIndexWalkProcess,
-                                                           FMIndexWalkPostProcess>(opt::readsFile, processorVector, &postProcessor);
+                                                           FMIndexWalkPostProcess>(opt::readsFile, processorVector, &postProcessor, pCheckpoint);
 
 		else
         SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
                                                            FMIndexWalkResult,
                                                            FMIndexWalkProcess,
-                                                           FMIndexWalkPostProcess>(opt::readsFile, processorVector, &postProcessor);
+                                                           FMIndexWalkPostProcess>(opt::readsFile, processorVector, &postProcessor, pCheckpoint);
 
         for(int i = 0; i < opt::numThreads; ++i)
         {
@@ -233,6 +245,10 @@ int FMindexWalkMain(int argc, char** argv)
     delete pWriter;
     if(pDiscardWriter != NULL)
         delete pDiscardWriter;
+
+    // The run is complete, the checkpoint is no longer needed
+    pCheckpoint->remove();
+    delete pCheckpoint;
 	
     return 0;
 }
@@ -264,6 +280,8 @@ void parseFMWalkOptions(int argc, char** argv)
             case 'm': arg >> opt::minOverlap; break;
             case 'M': arg >> opt::maxOverlap; break;
             case OPT_LEARN: opt::bLearnKmerParams = true; break;
+            case OPT_RESUME: opt::bResume = true; break;
+            case OPT_CHECKPOINT_INTERVAL: arg >> opt::checkpointInterval; break;
             case OPT_HELP:
                 std::cout << CORRECT_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -303,6 +321,12 @@ void parseFMWalkOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::checkpointInterval < 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid checkpoint interval: " << opt::checkpointInterval << "\n";
+        die = true;
+    }
+
     // Determine the correction algorithm to use
     if(!algo_str.empty())
     {
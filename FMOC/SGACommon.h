@@ -26,6 +26,7 @@
 #define RSAI_EXT ".rsai"
 #define SSA_EXT ".ssa"
 #define POPIDX_EXT ".popidx"
+#define CHECKPOINT_EXT ".ckpt"
 
 // Default values
 #define DEFAULT_MIN_OVERLAP 45
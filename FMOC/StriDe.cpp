@@ -17,6 +17,7 @@
 #include "subgraph.h"
 #include "filter.h"
 #include "fm-merge.h"
+#include "merge-shards.h"
 #include "kmerfreq.h"
 #include "grep.h"
 #include "FMIndexWalk.h"
@@ -39,13 +40,14 @@ static const char *STRIDE_USAGE_MESSAGE =
 //"All-in-one Commands:\n"
 //"      all	  Perform error correction, long-read generation, overlap computation, and assembly in one run\n"
 //"\nStep-by-step Commands:\n"
-"      preprocess  filter and quality-trim reads\n"
-"      index       build FM-index for a set of reads\n"
-"      correct     correct sequencing errors in reads \n"
-//"      fmwalk      merge paired reads into long reads via FM-index walk\n"
-//"      filter      remove redundant reads from a data set\n"
-//"      overlap     compute overlaps between reads\n"
-//"      assemble    generate contigs from an assembly graph\n"
+"      preprocess    filter and quality-trim reads\n"
+"      index         build FM-index for a set of reads\n"
+"      correct       correct sequencing errors in reads \n"
+"      merge-shards  merge the outputs of a sharded correct run in input order\n"
+//"      fmwalk        merge paired reads into long reads via FM-index walk\n"
+//"      filter        remove redundant reads from a data set\n"
+//"      overlap       compute overlaps between reads\n"
+//"      assemble      generate contigs from an assembly graph\n"
 //"\nOther Commands:\n"
 //"      merge	merge multiple BWT/FM-index files into a single index\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
@@ -85,6 +87,8 @@ int main(int argc, char** argv)
             overlapMain(argc - 1, argv + 1);
         else if(command == "correct")
             correctMain(argc - 1, argv + 1);
+        else if(command == "merge-shards")
+            mergeShardsMain(argc - 1, argv + 1);
         else if(command == "assemble")
             assembleMain(argc - 1, argv + 1);
         else if(command == "subgraph")
@@ -14,8 +14,10 @@
 #include "Util.h"
 #include "assemble.h"
 #include "SGUtil.h"
+#include "BinaryGraphFile.h"
 #include "SGAlgorithms.h"
 #include "SGVisitors.h"
+#include "CGVisitors.h"
 #include "Timer.h"
 #include "EncodedString.h"
 #include "SuffixArray.h"
@@ -37,7 +39,7 @@ SUBPROGRAM " Version " PACKAGE_VERSION "\n"
 
 static const char *ASSEMBLE_USAGE_MESSAGE =
 "Usage: " PACKAGE_NAME " " SUBPROGRAM " [OPTION] ... ASQGFILE\n"
-"Create contigs from the assembly graph ASQGFILE.\n"
+"Create contigs from the assembly graph ASQGFILE, which may also be a binary graph (.sgb) written by overlap.\n"
 "\nMandatory arguments:\n"
 "      -r, --read-length=LEN            original read length\n"
 "      -i,  --insert-size               insert size of the paired-end library\n"
@@ -71,8 +73,8 @@ namespace opt
 	static std::string outSimpleBubblesFile;
 	static std::string outFilePrefix = "StriDe" ;
 
-	static unsigned int minOverlap=30;
-	static size_t maxEdges = 512;
+	static unsigned int minOverlap=ASSEMBLE_MIN_OVERLAP;
+	static size_t maxEdges = ASSEMBLE_MAX_EDGES;
 
 	//kmer frequence parameters
 	static size_t kmerLength = 31;
@@ -89,8 +91,8 @@ namespace opt
 	BWTIndexSet indices;
 	static BWT* pBWT =NULL;
     static BWT* pRBWT =NULL;
-    static SampledSuffixArray* pSSA = NULL;
-
+    static SampledSuffixArray* pSSA = NULL;
+
     //Visitor parameters
 	static size_t readLength = 0 ;
 	static double minOverlapRatio=0.8;
@@ -129,7 +131,7 @@ static const struct option longopts[] = {
 //
 // Main
 //
-int assembleMain(int argc, char** argv)
+int assembleMain(int argc, char** argv, StringGraph* pGraph)
 {
 	Timer* pTimer = new Timer("StriDe assembly");
 	parseAssembleOptions(argc, argv);
@@ -142,21 +144,28 @@ int assembleMain(int argc, char** argv)
 	std::cout << "Reliable Overlap Length: " << opt::credibleOverlapLength <<std::endl;
 	std::cout << "Insert Size            : " << opt::insertSize << std::endl;
 
-	assemble();
+	assemble(pGraph);
 	delete pTimer;
 
 	return 0;
 }
 
-int assemble()
+int assemble(StringGraph* pInputGraph)
 {
-	StringGraph* pGraph;
+	StringGraph* pGraph = pInputGraph;
+	CompactGraph* pCompactGraph = NULL;
+	VertexPtrVec readVertices;
+	bool bBinaryGraph = isBinaryGraph(opt::asqgFile);
 	#pragma omp parallel
 	{
 		#pragma omp single nowait
+		if(pInputGraph == NULL)
 		{
 			std::cout << "\n[ Loading string graph: " << opt::asqgFile <<  " ]\n";
-			pGraph=SGUtil::loadASQGVertex(opt::asqgFile, opt::minOverlap, true, opt::maxEdges);
+			if(bBinaryGraph)
+				pCompactGraph=SGUtil::loadCompactGraph(opt::asqgFile, opt::minOverlap);
+			else
+				pGraph=SGUtil::loadASQGVertex(opt::asqgFile, opt::minOverlap, true, opt::maxEdges, &readVertices);
 		}
 		#pragma omp single nowait
 		{
@@ -178,27 +187,59 @@ int assemble()
     opt::indices.pRBWT = opt::pRBWT;
     opt::indices.pSSA = opt::pSSA;
 	
-	pGraph=SGUtil::loadASQGEdge(opt::asqgFile, opt::minOverlap, true, opt::maxEdges, pGraph);
-
-	if(opt::bExact)
-		pGraph->setExactMode(true);
-	//pGraph->printMemSize();
+	// The graph built by the overlap stage of the same process, or loaded from a snapshot, already has its edges
+	if(pInputGraph == NULL && !bBinaryGraph)
+	{
+		pGraph=SGUtil::loadASQGEdge(opt::asqgFile, opt::minOverlap, true, opt::maxEdges, pGraph, &readVertices);
+		VertexPtrVec().swap(readVertices);
+	}
 
-	// // Pre-assembly graph stats
 	SGGraphStatsVisitor statsVisit;
-	std::cout << "[Stats] Input graph:\n";
-	pGraph->visitP(statsVisit);
-	
-	int phase = 0 ;
-
-	// Remove containments from the graph
-	std::cout << "Removing contained vertices from graph\n";
 	SGContainRemoveVisitor containVisit;
-	if(pGraph->hasContainment())
-		pGraph->visit(containVisit);
+	if(pCompactGraph != NULL)
+	{
+		if(opt::bExact)
+			pCompactGraph->setExactMode(true);
+
+		// Pre-assembly graph stats
+		CGGraphStatsVisitor cgStatsVisit;
+		std::cout << "[Stats] Input graph:\n";
+		pCompactGraph->visitP(cgStatsVisit);
+
+		// In exact mode, or in a transitive graph, contained vertices are deleted without remodelling
+		// their neighbours, so they are removed from the compact core before it is expanded into the
+		// string graph. This is the only pass before the first merge, every later visitor runs on the
+		// string graph
+		std::cout << "Removing contained vertices from graph\n";
+		CGContainRemoveVisitor cgContainVisit;
+		if(pCompactGraph->hasContainment() && (pCompactGraph->hasTransitive() || pCompactGraph->isExactMode()))
+			pCompactGraph->visitP(cgContainVisit);
+
+		pGraph = pCompactGraph->releaseToBigraph();
+		delete pCompactGraph;
+		if(pGraph->hasContainment())
+			pGraph->visit(containVisit);
+	}
+	else
+	{
+		if(opt::bExact)
+			pGraph->setExactMode(true);
+		//pGraph->printMemSize();
+
+		// // Pre-assembly graph stats
+		std::cout << "[Stats] Input graph:\n";
+		pGraph->visitP(statsVisit);
+
+		// Remove containments from the graph
+		std::cout << "Removing contained vertices from graph\n";
+		if(pGraph->hasContainment())
+			pGraph->visit(containVisit);
+	}
+
+	int phase = 0 ;
 
 	/*---Remove Transitive Edges---*/
-	//std::cout << "Removing transitive edges\n";
+	//std::cout << "Removing transitive edges\n";
 	//SGTransitiveReductionVisitor trVisit;
 	//pGraph->visit(trVisit);
 	/*---Remove Transitive Edges---*/
@@ -209,7 +250,7 @@ int assemble()
 	std::cout << "[Stats] Simplified graph:\n";
 	pGraph->visitP(statsVisit);
 
-
+
 	/**********************Compute overlap raio and diff (for debug)**************
 	std::ofstream ssol  ("simpleOverlapLength.histo", std::ofstream::out);
 	std::map<size_t,int> simpleStats = pGraph->getCountMap() ;
@@ -249,12 +290,12 @@ int assemble()
 			 trimLen=trimLen+stepsize;
     }
 
-	/*** Pop Bubbles ***/
+	/*** Pop Bubbles ***/
 	std::cout << "\n[ Remove bubbles and tips ]\n";
 	graphTrimAndSmooth (pGraph, opt::maxChimeraLength);
 	// outputGraphAndFasta(pGraph,"popBubbles",++phase);
-
-	/*** Remove small chimeric vertices ***/
+
+	/*** Remove small chimeric vertices ***/
 	std::cout << "\n[ Remove small chimera vertices ]\n";
 	for (size_t threshold=2; threshold<=opt::kmerThreshold; threshold++)
 		RemoveVertexWithBothShortEdges (pGraph, opt::readLength, opt::credibleOverlapLength, opt::pBWT, opt::kmerLength, threshold);
@@ -330,7 +371,7 @@ int assemble()
 	pGraph->renameVertices("");
 
 	/******* Re-join broken islands/tips due to high-GC errors ********/
-	size_t min_size_of_islandtip=opt::maxChimeraLength;
+	size_t min_size_of_islandtip=opt::maxChimeraLength;
 
     /***************** 1. Trim bad ends of island/tip *****************/
 	SGFastaErosionVisitor eFAVisit (opt::pBWT, opt::kmerLength, opt::kmerThreshold, min_size_of_islandtip);
@@ -341,13 +382,12 @@ int assemble()
 	outputGraphAndFasta(pGraph,"", ++phase);
     
     /*** 2. Collect read IDs mapped to large island/tip with size > min_size_of_islandtip ***/
-	ThreadSafeListVector tslv;
-	tslv.resize(opt::pSSA->getNumberOfReads());
-    SGIslandCollectVisitor sgicv(&tslv, opt::indices, opt::insertSize, 51, min_size_of_islandtip);
-    pGraph->visitP(sgicv);
+	ReadContigMap readContigs;
+    SGIslandCollectVisitor sgicv(&readContigs, opt::indices, opt::insertSize, 51, min_size_of_islandtip);
+    pGraph->visitP(sgicv);
     
 	/*** 3. Join islands/tips with PE support using FM-index walk (depth,leaves,minoverlap)=(150, 2000, 19) ***/
-	SGJoinIslandVisitor sgjiv(100, 4000, opt::kmerLength/2+4, min_size_of_islandtip, &tslv, opt::indices, 3);
+	SGJoinIslandVisitor sgjiv(100, 4000, opt::kmerLength/2+4, min_size_of_islandtip, &readContigs, opt::indices, 3);
 	pGraph->visitProgress(sgjiv);
 	graphTrimAndSmooth (pGraph, opt::maxChimeraLength, false);
 
@@ -451,8 +491,8 @@ void parseAssembleOptions(int argc, char** argv)
 		opt::credibleOverlapLength = opt::readLength * opt::minOverlapRatio ;
 	}
 }
-
-
+
+
 void graphTrimAndSmooth (StringGraph* pGraph, size_t trimLength, bool bIsGapPrecent)
 {
 	pGraph->simplify();
@@ -484,7 +524,7 @@ void graphTrimAndSmooth (StringGraph* pGraph, size_t trimLength, bool bIsGapPrec
 	// }
 	
 }
-
+
 void RemoveVertexWithBothShortEdges (StringGraph* pGraph ,size_t vertexLength ,size_t overlapLength, BWT* pBWT , size_t kmerLength, float threshold )
 {
 	if (pBWT !=NULL)
@@ -521,7 +561,7 @@ void RemoveSmallOverlapRatioEdges ( StringGraph* pGraph, size_t chimeraLength)
         graphTrimAndSmooth (pGraph, opt::maxChimeraLength);
 
 }
-
+
 void outputGraphAndFasta(StringGraph* pGraph , std::string  name , int phase)
 {
 	std::cout << "\n<Printing the fasta & ASQG file>" << std::endl;
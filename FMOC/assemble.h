@@ -13,10 +13,16 @@
 #include "Bigraph.h"
 #include "SGVisitors.h"
 
+// The default filter of the edges the assembler loads. A graph built in memory
+// by the overlap stage for the assembler is filtered the same way.
+const unsigned int ASSEMBLE_MIN_OVERLAP = 30;
+const size_t ASSEMBLE_MAX_EDGES = 512;
+
 // functions
-int assembleMain(int argc, char** argv);
+// If pGraph is given it is assembled instead of the graph of the ASQG file, and is deleted
+int assembleMain(int argc, char** argv, StringGraph* pGraph = NULL);
 void parseAssembleOptions(int argc, char** argv);
-int assemble();
+int assemble(StringGraph* pInputGraph = NULL);
 
 void outputGraphAndFasta(StringGraph* pGraph , std::string  name , int phase = -1);
 void graphTrimAndSmooth (StringGraph* pGraph, size_t trimLength = 400, bool bIsGapPrecent=false);
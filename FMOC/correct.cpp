@@ -25,10 +25,16 @@
 #include "CorrectionThresholds.h"
 #include "KmerDistribution.h"
 #include "BWTIntervalCache.h"
+#include "BWTCARopebwt.h"
+#include "PackedReadTable.h"
+#include "NUMA.h"
 //#include "LRAlignment.h"
 
 // Functions
 int learnKmerParameters(const BWT* pBWT);
+int learnSolidThreshold(const BWT* pBWT);
+std::vector<BWTIndexSet> placeIndicesOnNodes(const BWTIndexSet& indexSet);
+void deleteIndexReplicas(std::vector<BWTIndexSet>& nodeIndices);
 
 //
 // Getopt
@@ -49,7 +55,22 @@ static const char *CORRECT_USAGE_MESSAGE =
 "      -v, --verbose                    display verbose output\n"
 "      -p, --prefix=PREFIX              use PREFIX for the names of the index files (default: prefix of the input file)\n"
 "      -o, --outfile=FILE               write the corrected reads to FILE (default: READSFILE.ec.fa)\n"
+"                                       If FILE ends in .prd the reads are written packed into 2 bits per base\n"
 "      -t, --threads=NUM                use NUM threads for the computation (default: 1)\n"
+"      --reorder                        correct the reads in an order that improves FM-index cache locality\n"
+"                                       the corrected reads are still written in input order\n"
+"      --reorder-window=N               sort the reads in windows of N reads when --reorder is used (default: 1000000)\n"
+"      --correct-rounds=N               perform N rounds of correction. Between rounds the corrected reads are kept\n"
+"                                       in memory and the FM-index is rebuilt from them without writing to disk (default: 1)\n"
+"      --shard=I/N                      only correct the reads whose index modulo N is I (0 <= I < N). The outputs of\n"
+"                                       the N shards can be combined in input order with " PACKAGE_NAME " merge-shards\n"
+"                                       (default output: READSFILE.shardI.ec.fa)\n"
+"      --resume                         continue an interrupted run from its last checkpoint. The other options must be\n"
+"                                       the same as in the interrupted run. Cannot be used with --reorder or --correct-rounds\n"
+"      --checkpoint-interval=N          write a checkpoint every N seconds, 0 disables checkpoints (default: 600)\n"
+"      --numa                           place the worker threads and the FM-index on the nodes of a NUMA machine. The BWTs\n"
+"                                       are copied to every node if there is enough free memory, otherwise the pages of\n"
+"                                       the indices are interleaved over the nodes\n"
 //"      -a, --algorithm=STR              specify the correction algorithm to use. STR must be one of kmer, hybrid, overlap. (default: kmer)\n"
 "\nKmer correction parameters:\n"
 "      -K, --kmer-size=N                The length of the kmer to use. (default: 31)\n"
@@ -89,13 +110,22 @@ namespace opt
     static int numKmerRounds = 10;
     static bool bLearnKmerParams = false;
 	static bool diploid = false;
+    static bool bReorder = false;
+    static size_t reorderWindow = LocalityReorder::DEFAULT_WINDOW_SIZE;
+    static int numCorrectRounds = 1;
+    static size_t shardIdx = 0;
+    static size_t numShards = 1;
+    static bool bResume = false;
+    static int checkpointInterval = Checkpoint::DEFAULT_INTERVAL;
+    static bool bNuma = false;
 
     static ErrorCorrectAlgorithm algorithm = ECA_FMEXTEND;
 }
 
 static const char* shortopts = "p:m:d:e:t:l:s:o:r:b:a:c:k:K:x:i:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN, OPT_DIPLOID };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN, OPT_DIPLOID, OPT_REORDER, OPT_REORDER_WINDOW, OPT_CORRECT_ROUNDS, OPT_SHARD,
+       OPT_RESUME, OPT_CHECKPOINT_INTERVAL, OPT_NUMA };
 
 static const struct option longopts[] = {
     { "verbose",       no_argument,       NULL, 'v' },
@@ -121,9 +151,78 @@ static const struct option longopts[] = {
     { "version",       no_argument,       NULL, OPT_VERSION },
     { "metrics",       required_argument, NULL, OPT_METRICS },
 	{ "diploid",       no_argument, NULL, OPT_DIPLOID },
+    { "reorder",       no_argument,       NULL, OPT_REORDER },
+    { "reorder-window",required_argument, NULL, OPT_REORDER_WINDOW },
+    { "correct-rounds",required_argument, NULL, OPT_CORRECT_ROUNDS },
+    { "shard",         required_argument, NULL, OPT_SHARD },
+    { "resume",        no_argument,       NULL, OPT_RESUME },
+    { "checkpoint-interval", required_argument, NULL, OPT_CHECKPOINT_INTERVAL },
+    { "numa",          no_argument,       NULL, OPT_NUMA },
     { NULL, 0, NULL, 0 }
 };
 
+// Run the processors over every work item of generator, serially or in parallel.
+// If nodeIndices is not empty, each thread uses the indices of the NUMA node it runs on.
+template<class Generator, class PostProcessor>
+void dispatchCorrection(Generator& generator, const ErrorCorrectParameters& ecParams, PostProcessor* pPostProcessor,
+                        Checkpoint* pCheckpoint, const std::vector<BWTIndexSet>& nodeIndices)
+{
+    if(opt::numThreads <= 1)
+    {
+        // Serial mode
+        ErrorCorrectProcess processor(ecParams);
+        SequenceProcessFramework::processWorkSerial<SequenceWorkItem,
+                                                    ErrorCorrectResult,
+                                                    Generator,
+                                                    ErrorCorrectProcess,
+                                                    PostProcessor>(generator, &processor, pPostProcessor, -1, pCheckpoint);
+    }
+    else
+    {
+        // Parallel mode
+        std::vector<ErrorCorrectProcess*> processorVector;
+        for(int i = 0; i < opt::numThreads; ++i)
+        {
+            ErrorCorrectParameters threadParams = ecParams;
+            if(!nodeIndices.empty())
+                threadParams.indices = nodeIndices[NUMA::getNodeForThread(i)];
+            ErrorCorrectProcess* pProcessor = new ErrorCorrectProcess(threadParams);
+            processorVector.push_back(pProcessor);
+        }
+
+        SequenceProcessFramework::processWorkParallelStealing<SequenceWorkItem,
+                                                              ErrorCorrectResult,
+                                                              Generator,
+                                                              ErrorCorrectProcess,
+                                                              PostProcessor>(generator, processorVector, pPostProcessor, -1, pCheckpoint);
+
+        for(int i = 0; i < opt::numThreads; ++i)
+        {
+            delete processorVector[i];
+        }
+    }
+}
+
+// Correct the reads produced by generator, in FM-index locality order if requested.
+// Checkpoints are only taken in input order, pCheckpoint must be NULL when reordering.
+template<class Generator>
+void correctReads(Generator& generator, const ErrorCorrectParameters& ecParams, ErrorCorrectPostProcess* pPostProcessor,
+                  const std::vector<BWTIndexSet>& nodeIndices, Checkpoint* pCheckpoint = NULL)
+{
+    if(opt::bReorder)
+    {
+        assert(pCheckpoint == NULL);
+        typedef ReorderPostProcess<SequenceWorkItem, ErrorCorrectResult, ErrorCorrectPostProcess> ReorderPostProcessor;
+        LocalityWorkItemGenerator<Generator> localityGenerator(&generator, LocalityReorder::DEFAULT_KMER_SIZE, opt::reorderWindow);
+        ReorderPostProcessor reorderPostProcessor(pPostProcessor);
+        dispatchCorrection(localityGenerator, ecParams, &reorderPostProcessor, (Checkpoint*)NULL, nodeIndices);
+    }
+    else
+    {
+        dispatchCorrection(generator, ecParams, pPostProcessor, pCheckpoint, nodeIndices);
+    }
+}
+
 //
 // Main
 //
@@ -132,6 +231,8 @@ int correctMain(int argc, char** argv)
     parseCorrectOptions(argc, argv);
 
     std::cout << "Correcting sequencing errors for " << opt::readsFile << "\n";
+    if(opt::bNuma)
+        std::cout << "[numa] found " << NUMA::enable() << " node(s)\n";
 
     // Set the error correction parameters
     ErrorCorrectParameters ecParams;
@@ -143,46 +244,36 @@ int correctMain(int argc, char** argv)
     BWT* pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
     BWT* pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);;
     SampledSuffixArray* pSSA = NULL;
-    if(opt::algorithm == ECA_OVERLAP || opt::algorithm == ECA_HYBRID||opt::algorithm ==ECA_FMEXTEND)
+    bool bUseSSA = opt::algorithm == ECA_OVERLAP || opt::algorithm == ECA_HYBRID||opt::algorithm ==ECA_FMEXTEND;
+    if(bUseSSA)
         pSSA = new SampledSuffixArray(opt::prefix + SAI_EXT, SSA_FT_SAI);
 
-    BWTIndexSet indexSet;
-    indexSet.pBWT = pBWT;
-    indexSet.pRBWT = pRBWT;
-    indexSet.pSSA = pSSA;
-
-    ecParams.indices = indexSet;
+    if(opt::verbose > 0)
+    {
+        pBWT->printHugePageInfo("BWT");
+        pRBWT->printHugePageInfo("RBWT");
+        if(pSSA != NULL)
+            pSSA->printHugePageInfo("SSA");
+    }
 
-    // Learn the parameters of the kmer corrector
-    if(opt::bLearnKmerParams)
+    // Open outfiles and start a timer. A single round in input order can be
+    // checkpointed, then the outputs are opened through the checkpoint.
+    Checkpoint* pCheckpoint = NULL;
+    std::ostream* pWriter;
+    std::ostream* pDiscardWriter = NULL;
+    if(!opt::bReorder && opt::numCorrectRounds == 1)
     {
-        int threshold = learnKmerParameters(pBWT);
-        if(threshold != -1)
-            CorrectionThresholds::Instance().setBaseMinSupport(threshold);
+        pCheckpoint = new Checkpoint(opt::outFile + CHECKPOINT_EXT, opt::bResume, opt::checkpointInterval);
+        pWriter = pCheckpoint->openOutput(opt::outFile);
+        if(!opt::discardFile.empty())
+            pDiscardWriter = pCheckpoint->openOutput(opt::discardFile);
     }
-	
-	size_t n_samples = 10000;
-	KmerDistribution kmerDistribution;
-    int k = opt::kmerLength;
-    for(size_t i = 0; i < n_samples; ++i)
+    else
     {
-        std::string s = BWTAlgorithms::sampleRandomString(pBWT);
-        int n = s.size();
-        int nk = n - k + 1;
-        for(int j = 0; j < nk; ++j)
-        {
-            std::string kmer = s.substr(j, k);
-            int count = BWTAlgorithms::countSequenceOccurrences(kmer, pBWT);
-            kmerDistribution.add(count);
-        }
+        pWriter = createWriter(opt::outFile);
+        if(!opt::discardFile.empty())
+            pDiscardWriter = createWriter(opt::discardFile);
     }
-	kmerDistribution.computeKDAttributes();
-	//printf("The kmer median = %d\n",(int)kmerDistribution.getMedian());
-	ecParams.solid_threshold=(int)kmerDistribution.getMedian();
-
-    // Open outfiles and start a timer
-    std::ostream* pWriter = createWriter(opt::outFile);
-    std::ostream* pDiscardWriter = (!opt::discardFile.empty() ? createWriter(opt::discardFile) : NULL);
     Timer* pTimer = new Timer(PROGRAM_IDENT);
 
     ecParams.pOverlapper = NULL;
@@ -199,50 +290,101 @@ int correctMain(int argc, char** argv)
     ecParams.printOverlaps = opt::verbose > 0;
 	ecParams.isDiploid = opt::diploid;
 
-    std::cout <<"Perform error correction using" << std::endl
-              <<"kmer size=" << ecParams.kmerLength << std::endl
-			  <<"Check kmer size=" << ecParams.check_kmerLength << std::endl
-              <<"kmer threshold=" << opt::kmerThreshold <<std::endl
-			  <<"overlap rounds=" << opt::numOverlapRounds <<std::endl;
-    // Setup post-processor
+    // The reads corrected in the previous round, when more than one round is performed
+    PackedReadTable* pReadTable = NULL;
     bool bCollectMetrics = !opt::metricsFile.empty();
-    ErrorCorrectPostProcess postProcessor(pWriter, pDiscardWriter, bCollectMetrics);
 
-    if(opt::numThreads <= 1)
+    for(int round = 1; round <= opt::numCorrectRounds; ++round)
     {
-        // Serial mode
-        ErrorCorrectProcess processor(ecParams);
-        SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
-                                                         ErrorCorrectResult,
-                                                         ErrorCorrectProcess,
-                                                         ErrorCorrectPostProcess>(opt::readsFile, &processor, &postProcessor);
-    }
-    else
-    {
-        // Parallel mode
-        std::vector<ErrorCorrectProcess*> processorVector;
-        for(int i = 0; i < opt::numThreads; ++i)
+        bool bLastRound = round == opt::numCorrectRounds;
+        if(round > 1)
         {
-            ErrorCorrectProcess* pProcessor = new ErrorCorrectProcess(ecParams);
-            processorVector.push_back(pProcessor);
+            // Replace the indices with ones built from the corrected reads
+            std::cout << "Building index for correction round " << round << " in memory using RopeBWT2\n";
+            delete pBWT;
+            delete pRBWT;
+            pBWT = BWTCA::runRopebwt2(pReadTable, opt::numThreads, false, opt::sampleRate);
+            pRBWT = BWTCA::runRopebwt2(pReadTable, opt::numThreads, true, opt::sampleRate);
+
+            if(pSSA != NULL)
+            {
+                delete pSSA;
+                pSSA = new SampledSuffixArray();
+                pSSA->buildLexicoIndex(pBWT, opt::numThreads);
+            }
         }
 
-        SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
-                                                           ErrorCorrectResult,
-                                                           ErrorCorrectProcess,
-                                                           ErrorCorrectPostProcess>(opt::readsFile, processorVector, &postProcessor);
+        BWTIndexSet indexSet;
+        indexSet.pBWT = pBWT;
+        indexSet.pRBWT = pRBWT;
+        indexSet.pSSA = pSSA;
 
-        for(int i = 0; i < opt::numThreads; ++i)
+        ecParams.indices = indexSet;
+
+        // The indices used by the threads of each node when NUMA placement is on
+        std::vector<BWTIndexSet> nodeIndices;
+        if(opt::bNuma && opt::numThreads > 1)
+            nodeIndices = placeIndicesOnNodes(indexSet);
+
+        // Learn the parameters of the kmer corrector
+        if(opt::bLearnKmerParams)
         {
-            delete processorVector[i];
+            int threshold = learnKmerParameters(pBWT);
+            if(threshold != -1)
+                CorrectionThresholds::Instance().setBaseMinSupport(threshold);
         }
-    }
+        ecParams.solid_threshold = learnSolidThreshold(pBWT);
+
+        std::cout <<"Perform error correction using" << std::endl
+                  <<"kmer size=" << ecParams.kmerLength << std::endl
+                  <<"Check kmer size=" << ecParams.check_kmerLength << std::endl
+                  <<"kmer threshold=" << opt::kmerThreshold <<std::endl
+                  <<"overlap rounds=" << opt::numOverlapRounds <<std::endl;
+        if(opt::numCorrectRounds > 1)
+            std::cout << "correction round=" << round << "/" << opt::numCorrectRounds << std::endl;
+
+        // Setup post-processor. Only the last round writes the corrected reads to disk,
+        // the earlier rounds keep them in memory for the next index. Metrics are
+        // collected for the last round only.
+        PackedReadTable* pCorrectedTable = bLastRound ? NULL : new PackedReadTable;
+        ErrorCorrectPostProcess* pPostProcessor = bLastRound ?
+                                                  new ErrorCorrectPostProcess(pWriter, pDiscardWriter, bCollectMetrics) :
+                                                  new ErrorCorrectPostProcess(pCorrectedTable, pDiscardWriter, false);
+        if(pCheckpoint != NULL)
+            pPostProcessor->registerCheckpoint(pCheckpoint);
+
+        if(round == 1)
+        {
+            SeqReader reader(opt::readsFile);
+            WorkItemGenerator<SequenceWorkItem> generator(&reader);
+            if(opt::numShards > 1)
+            {
+                std::cout << "Correcting shard " << opt::shardIdx << " of " << opt::numShards << "\n";
+                ShardWorkItemGenerator<WorkItemGenerator<SequenceWorkItem> > shardGenerator(&generator, opt::shardIdx, opt::numShards);
+                correctReads(shardGenerator, ecParams, pPostProcessor, nodeIndices, pCheckpoint);
+            }
+            else
+            {
+                correctReads(generator, ecParams, pPostProcessor, nodeIndices, pCheckpoint);
+            }
+        }
+        else
+        {
+            PackedReadTableGenerator generator(pReadTable);
+            correctReads(generator, ecParams, pPostProcessor, nodeIndices);
+        }
+        deleteIndexReplicas(nodeIndices);
 
-    if(bCollectMetrics)
-    {
-        std::ostream* pMetricsWriter = createWriter(opt::metricsFile);
-        postProcessor.writeMetrics(pMetricsWriter);
-        delete pMetricsWriter;
+        if(bLastRound && bCollectMetrics)
+        {
+            std::ostream* pMetricsWriter = createWriter(opt::metricsFile);
+            pPostProcessor->writeMetrics(pMetricsWriter);
+            delete pMetricsWriter;
+        }
+        delete pPostProcessor;
+
+        delete pReadTable;
+        pReadTable = pCorrectedTable;
     }
 
     delete pBWT;
@@ -259,10 +401,94 @@ int correctMain(int argc, char** argv)
     delete pWriter;
     if(pDiscardWriter != NULL)
         delete pDiscardWriter;
+
+    // The run is complete, the checkpoint is no longer needed
+    if(pCheckpoint != NULL)
+    {
+        pCheckpoint->remove();
+        delete pCheckpoint;
+    }
 		
     return 0;
 }
 
+// Decide how the indices are placed on the NUMA nodes. If a copy of both
+// BWTs fits in half of the free memory for every extra node, each node gets
+// its own copy, allocated by a thread bound to that node so the pages are
+// local. Otherwise the pages of the indices are interleaved over the nodes.
+// The suffix array is used far less than the BWTs and is always interleaved.
+// Returns the indices to use on each node.
+std::vector<BWTIndexSet> placeIndicesOnNodes(const BWTIndexSet& indexSet)
+{
+    int numNodes = NUMA::getNumNodes();
+    std::vector<BWTIndexSet> nodeIndices(numNodes, indexSet);
+    if(numNodes < 2)
+        return nodeIndices;
+
+    if(indexSet.pSSA != NULL)
+        indexSet.pSSA->interleaveMemory();
+
+    size_t bwtSize = indexSet.pBWT->getMemoryUsage() + indexSet.pRBWT->getMemoryUsage();
+    size_t replicaSize = bwtSize * (numNodes - 1);
+    if(replicaSize < NUMA::getAvailableMemory() / 2)
+    {
+        printf("[numa] copying the BWTs (%.1lf MB) to %d nodes\n", bwtSize / (1024.0 * 1024.0), numNodes);
+
+        // Node 0 keeps the loaded indices
+        for(int i = 1; i < numNodes; ++i)
+        {
+            NUMA::bindThreadToNode(i);
+            nodeIndices[i].pBWT = new BWT(*indexSet.pBWT);
+            nodeIndices[i].pRBWT = new BWT(*indexSet.pRBWT);
+        }
+        NUMA::unbindThread();
+    }
+    else
+    {
+        printf("[numa] interleaving the BWTs (%.1lf MB) over %d nodes\n", bwtSize / (1024.0 * 1024.0), numNodes);
+        indexSet.pBWT->interleaveMemory();
+        indexSet.pRBWT->interleaveMemory();
+    }
+    return nodeIndices;
+}
+
+// Free the copies made by placeIndicesOnNodes
+void deleteIndexReplicas(std::vector<BWTIndexSet>& nodeIndices)
+{
+    for(size_t i = 1; i < nodeIndices.size(); ++i)
+    {
+        if(nodeIndices[i].pBWT != nodeIndices[0].pBWT)
+            delete nodeIndices[i].pBWT;
+        if(nodeIndices[i].pRBWT != nodeIndices[0].pRBWT)
+            delete nodeIndices[i].pRBWT;
+    }
+    nodeIndices.clear();
+}
+
+// Sample kmers from the BWT and return the median kmer count, which
+// is used as the solid kmer threshold of the FM-index extension corrector
+int learnSolidThreshold(const BWT* pBWT)
+{
+	size_t n_samples = 10000;
+	KmerDistribution kmerDistribution;
+    int k = opt::kmerLength;
+    for(size_t i = 0; i < n_samples; ++i)
+    {
+        std::string s = BWTAlgorithms::sampleRandomString(pBWT);
+        int n = s.size();
+        int nk = n - k + 1;
+        for(int j = 0; j < nk; ++j)
+        {
+            std::string kmer = s.substr(j, k);
+            int count = BWTAlgorithms::countSequenceOccurrences(kmer, pBWT);
+            kmerDistribution.add(count);
+        }
+    }
+	kmerDistribution.computeKDAttributes();
+	//printf("The kmer median = %d\n",(int)kmerDistribution.getMedian());
+	return (int)kmerDistribution.getMedian();
+}
+
 // Learn parameters of the kmer corrector
 int learnKmerParameters(const BWT* pBWT)
 {
@@ -319,6 +545,7 @@ void parseCorrectOptions(int argc, char** argv)
 {
 	optind=1;
     std::string algo_str;
+    std::string shard_str;
     bool bDiscardReads = false;
     bool die = false;
     for (char c; (c = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1;)
@@ -349,6 +576,13 @@ void parseCorrectOptions(int argc, char** argv)
             case OPT_DISCARD: bDiscardReads = true; break;
             case OPT_METRICS: arg >> opt::metricsFile; break;
 			case OPT_DIPLOID: opt::diploid = true; break;
+            case OPT_REORDER: opt::bReorder = true; break;
+            case OPT_REORDER_WINDOW: arg >> opt::reorderWindow; break;
+            case OPT_CORRECT_ROUNDS: arg >> opt::numCorrectRounds; break;
+            case OPT_SHARD: arg >> shard_str; break;
+            case OPT_RESUME: opt::bResume = true; break;
+            case OPT_CHECKPOINT_INTERVAL: arg >> opt::checkpointInterval; break;
+            case OPT_NUMA: opt::bNuma = true; break;
             case OPT_HELP:
                 std::cout << CORRECT_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -381,6 +615,12 @@ void parseCorrectOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::numCorrectRounds <= 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid number of correction rounds: " << opt::numCorrectRounds << ", must be at least 1\n";
+        die = true;
+    }
+
     if(opt::numKmerRounds <= 0)
     {
         std::cerr << SUBPROGRAM ": invalid number of kmer rounds: " << opt::numKmerRounds << ", must be at least 1\n";
@@ -405,6 +645,55 @@ void parseCorrectOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::reorderWindow == 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid reorder window: " << opt::reorderWindow << ", must be greater than zero\n";
+        die = true;
+    }
+
+    // Parse the shard specification I/N
+    if(!shard_str.empty())
+    {
+        char sep = '\0';
+        int shard_idx = -1;
+        int num_shards = 0;
+        std::istringstream shard_parser(shard_str);
+        shard_parser >> shard_idx >> sep >> num_shards;
+        if(shard_parser.fail() || !shard_parser.eof() || sep != '/' || num_shards <= 0 || shard_idx < 0 || shard_idx >= num_shards)
+        {
+            std::cerr << SUBPROGRAM ": invalid shard: " << shard_str << ", must be I/N with 0 <= I < N\n";
+            die = true;
+        }
+        else
+        {
+            opt::shardIdx = shard_idx;
+            opt::numShards = num_shards;
+        }
+    }
+
+    if(opt::numShards > 1 && opt::numCorrectRounds > 1)
+    {
+        // Later rounds would index the reads of a single shard only
+        std::cerr << SUBPROGRAM ": --shard cannot be used with --correct-rounds\n";
+        die = true;
+    }
+
+    if(opt::checkpointInterval < 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid checkpoint interval: " << opt::checkpointInterval << "\n";
+        die = true;
+    }
+
+    if(opt::bResume && (opt::bReorder || opt::numCorrectRounds > 1))
+    {
+        // Reordered and in-memory rounds do not have a point where all earlier reads are written
+        std::cerr << SUBPROGRAM ": --resume cannot be used with --reorder or --correct-rounds\n";
+        die = true;
+    }
+
+    if(opt::bResume && !opt::metricsFile.empty())
+        std::cerr << SUBPROGRAM ": warning: the metrics only cover the reads corrected after resuming\n";
+
     // Determine the correction algorithm to use
     if(!algo_str.empty())
     {
@@ -462,6 +751,13 @@ void parseCorrectOptions(int argc, char** argv)
     CorrectionThresholds::Instance().setBaseMinSupport(opt::kmerThreshold);
 
     std::string out_prefix = stripFilename(opt::readsFile);
+    if(opt::numShards > 1)
+    {
+        std::stringstream shard_ss;
+        shard_ss << out_prefix << ".shard" << opt::shardIdx;
+        out_prefix = shard_ss.str();
+    }
+
     if(opt::outFile.empty())
     {
         opt::outFile = out_prefix + ".ec.fa";
@@ -22,8 +22,8 @@
 #include "gzstream.h"
 #include "SequenceProcessFramework.h"
 #include "QCProcess.h"
-#include "BitVector.h"
-#include "BWTCARopebwt.h"
+#include "AtomicBitVector.h"
+#include "BWTCARopebwt.h"
 
 
 // Defines
@@ -56,17 +56,24 @@ static const char *FILTER_USAGE_MESSAGE =
 "      -v, --verbose                    display verbose output\n"
 "      -p, --prefix=PREFIX              use PREFIX for the names of the index files (default: prefix of the input file)\n"
 "      -o, --outfile=FILE               write the qc-passed reads to FILE (default: READSFILE.filter.pass.fa)\n"
+"                                       If FILE ends in .prd the reads are written packed into 2 bits per base\n"
 "      -t, --threads=NUM                use NUM threads to compute the overlaps (default: 1)\n"
 "      -d, --sample-rate=N              use occurrence array sample rate of N in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
 "      --no-duplicate-check             turn off duplicate removal\n"
 "      --substring-only                 when removing duplicates, only remove substring sequences, not full-length matches\n"
+"      --duplicate-marks=FILE           keep the marks of the reads seen by the duplicate check in FILE mapped into memory\n"
+"                                       instead of in anonymous memory. The file is removed when the run finishes\n"
 "      --no-kmer-check                  turn off the kmer check\n"
 "      --homopolymer-check              check reads for hompolymer run length sequencing errors\n"
-"      --low-complexity-check           filter out low complexity reads\n"
+"      --low-complexity-check           filter out low complexity reads\n"
 "\nK-mer filter options:\n"
 "      -k, --kmer-size=N                The length of the kmer to use. (default: 31)\n"
 "      -x, --kmer-threshold=N           Require at least N kmer coverage for each kmer in a read. (default: 3)\n"
+"\nCheckpoint options:\n"
+"          --resume                     continue an interrupted run from its last checkpoint. The other options must be\n"
+"                                       the same as in the interrupted run\n"
+"          --checkpoint-interval=N      write a checkpoint every N seconds, 0 disables checkpoints (default: 600)\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 static const char* PROGRAM_IDENT =
@@ -83,6 +90,7 @@ namespace opt
     static int sampleRate = BWT::DEFAULT_SAMPLE_RATE_SMALL;
 
     static bool dupCheck = true;
+    static std::string duplicateMarksFile;
     static bool substringOnly = false;
     static bool kmerCheck = false;
     static bool hpCheck = false;
@@ -90,11 +98,15 @@ namespace opt
 
     static int kmerLength = 31;
     static int kmerThreshold = 3;
+
+    static bool bResume = false;
+    static int checkpointInterval = Checkpoint::DEFAULT_INTERVAL;
 }
 
 static const char* shortopts = "p:d:t:o:k:x:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_SUBSTRING_ONLY, OPT_NO_RMDUP, OPT_NO_KMER, OPT_CHECK_HPRUNS, OPT_CHECK_COMPLEXITY };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_SUBSTRING_ONLY, OPT_NO_RMDUP, OPT_NO_KMER, OPT_CHECK_HPRUNS, OPT_CHECK_COMPLEXITY,
+       OPT_RESUME, OPT_CHECKPOINT_INTERVAL, OPT_DUPLICATE_MARKS };
 
 static const struct option longopts[] = {
     { "verbose",               no_argument,       NULL, 'v' },
@@ -111,6 +123,9 @@ static const struct option longopts[] = {
     { "homopolymer-check",     no_argument,       NULL, OPT_CHECK_HPRUNS },
     { "low-complexity-check",  no_argument,       NULL, OPT_CHECK_COMPLEXITY },
     { "substring-only",        no_argument,       NULL, OPT_SUBSTRING_ONLY },
+    { "duplicate-marks",       required_argument, NULL, OPT_DUPLICATE_MARKS },
+    { "resume",                no_argument,       NULL, OPT_RESUME },
+    { "checkpoint-interval",   required_argument, NULL, OPT_CHECKPOINT_INTERVAL },
     { NULL, 0, NULL, 0 }
 };
 
@@ -127,15 +142,24 @@ int filterMain(int argc, char** argv)
     BWT* pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
     //pBWT->printInfo();
 
-    std::ostream* pWriter = createWriter(opt::outFile);
-    std::ostream* pDiscardWriter = createWriter(opt::discardFile);
+    Checkpoint* pCheckpoint = new Checkpoint(opt::outFile + CHECKPOINT_EXT, opt::bResume, opt::checkpointInterval);
+    std::ostream* pWriter = pCheckpoint->openOutput(opt::outFile);
+    std::ostream* pDiscardWriter = pCheckpoint->openOutput(opt::discardFile);
     QCPostProcess* pPostProcessor = new QCPostProcess(pWriter, pDiscardWriter);
+    pPostProcessor->registerCheckpoint(pCheckpoint);
 
     // If performing duplicate check, create a bitvector to record
-    // which reads are duplicates
-    BitVector* pSharedBV = NULL;
+    // which reads are duplicates. It is part of the checkpoint as the
+    // remaining reads are checked against the reads seen so far.
+    AtomicBitVector* pSharedBV = NULL;
     if(opt::dupCheck)
-        pSharedBV = new BitVector(pBWT->getNumStrings());
+    {
+        if(opt::duplicateMarksFile.empty())
+            pSharedBV = new AtomicBitVector(pBWT->getNumStrings());
+        else
+            pSharedBV = new AtomicBitVector(pBWT->getNumStrings(), opt::duplicateMarksFile);
+        pCheckpoint->addBitVector("duplicates", pSharedBV);
+    }
 
     // Set up QC parameters
     QCParameters params;
@@ -163,7 +187,7 @@ int filterMain(int argc, char** argv)
     {
         // Serial mode
         QCProcess processor(params);
-        PROCESS_FILTER_SERIAL(opt::readsFile, &processor, pPostProcessor);
+        PROCESS_FILTER_SERIAL(opt::readsFile, &processor, pPostProcessor, pCheckpoint);
     }
     else
     {
@@ -175,7 +199,7 @@ int filterMain(int argc, char** argv)
             processorVector.push_back(pProcessor);
         }
 
-        PROCESS_FILTER_PARALLEL(opt::readsFile, processorVector, pPostProcessor);
+        PROCESS_FILTER_PARALLEL(opt::readsFile, processorVector, pPostProcessor, pCheckpoint);
 
         for(int i = 0; i < opt::numThreads; ++i)
             delete processorVector[i];
@@ -190,17 +214,17 @@ int filterMain(int argc, char** argv)
 
     if(pSharedBV != NULL)
         delete pSharedBV;
-
-    std::cout << "RE-building index for " << opt::outFile << " in memory using ropebwt2\n";
-    std::string prefix=stripFilename(opt::outFile);
+
+    std::cout << "RE-building index for " << opt::outFile << " in memory using ropebwt2\n";
+    std::string prefix=stripFilename(opt::outFile);
         //BWT *pBWT, *pRBWT;
 		#pragma omp parallel
 		{
 			#pragma omp single nowait
 			{	
 			    std::string bwt_filename = prefix + BWT_EXT;
-				BWTCA::runRopebwt2(opt::outFile, bwt_filename, opt::numThreads, false);
-				std::cout << "\t done bwt construction, generating .sai file\n";
+				BWTCA::runRopebwt2(opt::outFile, bwt_filename, opt::numThreads, false);
+				std::cout << "\t done bwt construction, generating .sai file\n";
 				pBWT = new BWT(bwt_filename);
 			}
 			#pragma omp single nowait
@@ -210,22 +234,26 @@ int filterMain(int argc, char** argv)
 				std::cout << "\t done rbwt construction, generating .rsai file\n";
 				pRBWT = new BWT(rbwt_filename);
 			}
-		}
+		}
         std::string sai_filename = prefix + SAI_EXT;
-		SampledSuffixArray ssa;
-        ssa.buildLexicoIndex(pBWT, opt::numThreads);
-        ssa.writeLexicoIndex(sai_filename);
-        delete pBWT;
-
-        std::string rsai_filename = prefix + RSAI_EXT;
-        SampledSuffixArray rssa;
-        rssa.buildLexicoIndex(pRBWT, opt::numThreads);
-        rssa.writeLexicoIndex(rsai_filename);
-        delete pRBWT;
+		SampledSuffixArray ssa;
+        ssa.buildLexicoIndex(pBWT, opt::numThreads);
+        ssa.writeLexicoIndex(sai_filename);
+        delete pBWT;
+
+        std::string rsai_filename = prefix + RSAI_EXT;
+        SampledSuffixArray rssa;
+        rssa.buildLexicoIndex(pRBWT, opt::numThreads);
+        rssa.writeLexicoIndex(rsai_filename);
+        delete pRBWT;
 
     // Cleanup
     delete pTimer;
 
+    // The run is complete, the checkpoint is no longer needed
+    pCheckpoint->remove();
+    delete pCheckpoint;
+
     return 0;
 }
 
@@ -252,7 +280,10 @@ void parseFilterOptions(int argc, char** argv)
             case OPT_NO_KMER: opt::kmerCheck = false; break;
             case OPT_CHECK_HPRUNS: opt::hpCheck = true; break;
             case OPT_CHECK_COMPLEXITY: opt::lowComplexityCheck = true; break;
-            case OPT_SUBSTRING_ONLY: opt::substringOnly = true; break;
+            case OPT_SUBSTRING_ONLY: opt::substringOnly = true; break;
+            case OPT_DUPLICATE_MARKS: arg >> opt::duplicateMarksFile; break;
+            case OPT_RESUME: opt::bResume = true; break;
+            case OPT_CHECKPOINT_INTERVAL: arg >> opt::checkpointInterval; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
             case OPT_HELP:
@@ -293,6 +324,12 @@ void parseFilterOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::checkpointInterval < 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid checkpoint interval: " << opt::checkpointInterval << "\n";
+        die = true;
+    }
+
     if (die)
     {
         std::cout << "\n" << FILTER_USAGE_MESSAGE;
@@ -95,7 +95,7 @@ int FMMergeMain(int argc, char** argv)
     // Construct a bitvector indicating what reads have been used
     // All the processes read from this vector and only the post processor
     // writes to it.
-    BitVector markedReads(pBWT->getNumStrings());
+    AtomicBitVector markedReads(pBWT->getNumStrings());
 
     std::ostream* pWriter = createWriter(opt::outFile);
     FMMergePostProcess postProcessor(pWriter, &markedReads);
@@ -133,13 +133,10 @@ int FMMergeMain(int argc, char** argv)
     }
 
     // Check that every bit was set in the bit vector
-    size_t numSet = 0;
+    size_t numSet = markedReads.count();
     size_t numTotal = pBWT->getNumStrings();
-    for(size_t i = 0; i < numTotal; ++i)
-    {
-        if(markedReads.test(i))
-            ++numSet;
-    }
+    if(opt::verbose > 0)
+        printf("[%s] %zu of %zu reads were marked as used\n", PROGRAM_IDENT, numSet, numTotal);
 
     // Get the number of strings in the BWT, this is used to pre-allocated the read table
     delete pOverlapper;
@@ -0,0 +1,207 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// merge-shards - Combine the outputs of a sharded run
+// back into the order of the input reads
+//
+#include <iostream>
+#include <fstream>
+#include "Util.h"
+#include "merge-shards.h"
+#include "SeqReader.h"
+#include "Timer.h"
+
+//
+// Getopt
+//
+#define SUBPROGRAM "merge-shards"
+static const char *MERGESHARDS_VERSION_MESSAGE =
+SUBPROGRAM " Version " PACKAGE_VERSION "\n"
+"Copyright 2014 National Chung Cheng University\n";
+
+static const char *MERGESHARDS_USAGE_MESSAGE =
+"Usage: " PACKAGE_NAME " " SUBPROGRAM " [OPTION] ... READSFILE SHARD0 SHARD1 ... SHARDN-1\n"
+"Merge the outputs of N shards, e.g. from correct --shard=I/N, into the order of the reads in READSFILE.\n"
+"SHARDI must be the output of shard I. Reads that a shard did not output are skipped.\n"
+"Read IDs must be unique.\n"
+"\n"
+"      --help                           display this help and exit\n"
+"      -v, --verbose                    display verbose output\n"
+"      -o, --outfile=FILE               write the merged reads to FILE (default: READSFILE.merged.fa)\n"
+"                                       If FILE ends in .prd the reads are written packed into 2 bits per base\n"
+"      -d, --discard=FILE               the discarded reads of the next shard, e.g. from correct --discard. Give it once\n"
+"                                       per shard, in shard order, to merge the discarded reads as well\n"
+"          --discard-outfile=FILE       write the merged discarded reads to FILE (default: READSFILE.merged.discard.fa)\n"
+"\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
+
+static const char* PROGRAM_IDENT =
+PACKAGE_NAME "::" SUBPROGRAM;
+
+namespace opt
+{
+    static unsigned int verbose;
+    static std::string readsFile;
+    static std::string outFile;
+    static std::string discardOutFile;
+    static StringVector shardFiles;
+    static StringVector discardFiles;
+}
+
+static const char* shortopts = "o:d:v";
+
+enum { OPT_HELP = 1, OPT_VERSION, OPT_DISCARD_OUTFILE };
+
+static const struct option longopts[] = {
+    { "verbose",       no_argument,       NULL, 'v' },
+    { "outfile",       required_argument, NULL, 'o' },
+    { "discard",       required_argument, NULL, 'd' },
+    { "discard-outfile", required_argument, NULL, OPT_DISCARD_OUTFILE },
+    { "help",          no_argument,       NULL, OPT_HELP },
+    { "version",       no_argument,       NULL, OPT_VERSION },
+    { NULL, 0, NULL, 0 }
+};
+
+// Merge the shard files into outFile in the order of the input reads.
+// Returns false if some shard record was not found in the input.
+static bool mergeShards(const StringVector& shardFiles, const std::string& outFile)
+{
+    // The shard outputs are read back as they were written
+    const uint32_t reader_flags = SRF_NO_VALIDATION | SRF_KEEP_CASE;
+    size_t numShards = shardFiles.size();
+
+    std::vector<SeqReader*> shardReaders(numShards);
+    std::vector<SeqRecord> nextRecords(numShards);
+    std::vector<bool> hasNext(numShards);
+    for(size_t i = 0; i < numShards; ++i)
+    {
+        shardReaders[i] = new SeqReader(shardFiles[i], reader_flags);
+        hasNext[i] = shardReaders[i]->get(nextRecords[i]);
+    }
+
+    // Read idx was assigned to shard idx % N, and each shard writes its reads
+    // in input order. Walk the input and take the next record of the owning
+    // shard whenever its id matches the input read.
+    SeqReader inputReader(opt::readsFile, SRF_NO_VALIDATION | SRF_KEEP_CASE);
+    std::ostream* pWriter = createWriter(outFile);
+
+    SeqRecord inputRecord;
+    size_t numInput = 0;
+    size_t numWritten = 0;
+    while(inputReader.get(inputRecord))
+    {
+        size_t shard = numInput % numShards;
+        ++numInput;
+
+        if(!hasNext[shard] || nextRecords[shard].id != inputRecord.id)
+        {
+            if(opt::verbose > 0)
+                std::cout << "Read " << inputRecord.id << " is not in " << shardFiles[shard] << "\n";
+            continue;
+        }
+
+        nextRecords[shard].write(*pWriter);
+        ++numWritten;
+        hasNext[shard] = shardReaders[shard]->get(nextRecords[shard]);
+    }
+
+    // Every shard record must have been matched against an input read
+    bool matched = true;
+    for(size_t i = 0; i < numShards; ++i)
+    {
+        if(hasNext[i])
+        {
+            std::cerr << SUBPROGRAM ": read " << nextRecords[i].id << " of " << shardFiles[i]
+                      << " was not found in " << opt::readsFile << " at the expected position\n";
+            matched = false;
+        }
+        delete shardReaders[i];
+    }
+
+    std::cout << "Merged " << numWritten << " reads from " << numShards << " shards into " << outFile << " ("
+              << numInput - numWritten << " of " << numInput << " input reads were not in the shards)\n";
+
+    delete pWriter;
+    return matched;
+}
+
+//
+// Main
+//
+int mergeShardsMain(int argc, char** argv)
+{
+    parseMergeShardsOptions(argc, argv);
+    Timer* pTimer = new Timer(PROGRAM_IDENT);
+
+    bool matched = mergeShards(opt::shardFiles, opt::outFile);
+
+    // The discarded reads of each shard are in input order too
+    if(!opt::discardFiles.empty())
+        matched = mergeShards(opt::discardFiles, opt::discardOutFile) && matched;
+
+    delete pTimer;
+
+    if(!matched)
+    {
+        std::cerr << SUBPROGRAM ": the shards do not match the reads file or were given in the wrong order\n";
+        exit(EXIT_FAILURE);
+    }
+    return 0;
+}
+
+//
+// Handle command line arguments
+//
+void parseMergeShardsOptions(int argc, char** argv)
+{
+	optind=1;
+    bool die = false;
+    for (char c; (c = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1;)
+    {
+        std::istringstream arg(optarg != NULL ? optarg : "");
+        switch (c)
+        {
+            case 'o': arg >> opt::outFile; break;
+            case 'd': opt::discardFiles.push_back(arg.str()); break;
+            case OPT_DISCARD_OUTFILE: arg >> opt::discardOutFile; break;
+            case '?': die = true; break;
+            case 'v': opt::verbose++; break;
+            case OPT_HELP:
+                std::cout << MERGESHARDS_USAGE_MESSAGE;
+                exit(EXIT_SUCCESS);
+            case OPT_VERSION:
+                std::cout << MERGESHARDS_VERSION_MESSAGE;
+                exit(EXIT_SUCCESS);
+        }
+    }
+
+    if (argc - optind < 2)
+    {
+        std::cerr << SUBPROGRAM ": missing arguments\n";
+        die = true;
+    }
+
+    if (!opt::discardFiles.empty() && opt::discardFiles.size() != (size_t)(argc - optind - 1))
+    {
+        std::cerr << SUBPROGRAM ": --discard must be given once for each shard\n";
+        die = true;
+    }
+
+    if (die)
+    {
+        std::cout << "\n" << MERGESHARDS_USAGE_MESSAGE;
+        exit(EXIT_FAILURE);
+    }
+
+    // Parse the input filenames
+    opt::readsFile = argv[optind++];
+    while(optind < argc)
+        opt::shardFiles.push_back(argv[optind++]);
+
+    if(opt::outFile.empty())
+        opt::outFile = stripFilename(opt::readsFile) + ".merged.fa";
+
+    if(opt::discardOutFile.empty())
+        opt::discardOutFile = stripFilename(opt::readsFile) + ".merged.discard.fa";
+}
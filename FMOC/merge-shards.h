@@ -0,0 +1,17 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// merge-shards - Combine the outputs of a sharded run
+// back into the order of the input reads
+//
+#ifndef MERGESHARDS_H
+#define MERGESHARDS_H
+#include <getopt.h>
+#include "config.h"
+
+int mergeShardsMain(int argc, char** argv);
+void parseMergeShardsOptions(int argc, char** argv);
+
+#endif
@@ -24,6 +24,10 @@
 #include "SequenceProcessFramework.h"
 #include "OverlapProcess.h"
 #include "ReadInfoTable.h"
+#include "MinimizerIndex.h"
+#include "SGUtil.h"
+#include "SGVisitors.h"
+#include "BinaryGraphFile.h"
 #include <sys/stat.h>
 
 /*Tatsuki include */
@@ -52,15 +56,139 @@ enum OutputType
 };
 
 // Functions
-size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile, const OverlapAlgorithm* pOverlapper, int minOverlap, StringVector& filenameVec, std::ostream* pASQGWriter);
+void removeStaleHitFiles(const std::string& prefix, size_t numFiles);
 
-size_t computeHitsParallel(int numThreads, const std::string& prefix, const std::string& readsFile, const OverlapAlgorithm* pOverlapper, int minOverlap, StringVector& filenameVec, std::ostream* pASQGWriter);
+size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile, const OverlapAlgorithm* pOverlapper, int minOverlap, StringVector& filenameVec, std::ostream* pASQGWriter, Checkpoint* pCheckpoint);
+
+size_t computeHitsParallel(int numThreads, const std::string& prefix, const std::string& readsFile, const OverlapAlgorithm* pOverlapper, int minOverlap, StringVector& filenameVec, std::ostream* pASQGWriter, Checkpoint* pCheckpoint);
+
+size_t markContainedReads(const std::string& readsFile, const OverlapAlgorithm* pOverlapper, AtomicBitVector* pContained);
+
+StringGraph* computeGraph(int numThreads, const std::string& readsFile, const OverlapAlgorithm* pOverlapper, int minOverlap,
+                          unsigned int graphMinOverlap, size_t graphMaxEdges);
 
 //
-void convertHitsToASQG(const std::string& indexPrefix, const StringVector& hitsFilenames, std::ostream* pASQGWriter, DenseHashSet < std::string, StringHasher > *SuperRepeatVertices);
+void convertHitsToASQG(const StringVector& hitsFilenames, const OverlapAlgorithm* pOverlapper, std::ostream* pASQGWriter, std::ostream* pDiscardWriter);
+
+void resolveHits(size_t queryIdx, const OverlapHitVector& hits, const OverlapAlgorithm* pOverlapper, OverlapVector& outVector);
+
+void flushEdgeBuffer(std::ostringstream& buffer, std::ostream* pWriter, bool force);
+
+void writePairedEdges(const OverlapVector& ov1, const OverlapVector& ov2, std::ostream& edgeWriter, std::ostream& discardWriter);
 
-void convertHitsToASQGedgeParallel(const std::string hitsFilename, std::ostream* pASQGWriter ,std::ostream* pDiscardEdgeWriter, 
-	SuffixArray* pFwdSAI ,SuffixArray* pRevSAI , ReadInfoTable* pQueryRIT , ReadInfoTable* pTargetRIT, DenseHashSet < std::string, StringHasher > *SuperRepeatVertices);
+// Edges to super repeat reads are only kept if the overlap is at least this long
+static const int SUPER_REPEAT_MIN_OVERLAP = 81;
+
+// Size of the edge records a thread buffers before appending them to the output
+static const size_t EDGE_BUFFER_SIZE = 1 << 22;
+
+// Number of reads loaded at a time to check for containment
+static const size_t CONTAIN_BATCH_SIZE = 1 << 16;
+
+// Number of read pairs decoded from the hit files at a time in paired-overlap mode
+static const size_t HIT_PAIR_BATCH_SIZE = 1 << 16;
+
+// The hits of the two mates of a read pair, the reads firstIdx and firstIdx + 1
+struct HitPair
+{
+	size_t firstIdx;
+	OverlapHitVector hits[2];
+};
+typedef std::vector<HitPair> HitPairVector;
+
+// Read the groups of a hit file as read pairs. The overlap workers take the reads in
+// chunks of an even size and write the groups of a chunk in order, so the groups of two
+// mates are adjacent in one file. A mate without hits has no group.
+class HitPairReader
+{
+	public:
+		HitPairReader(const std::string& filename) : m_reader(filename), m_bPending(false), m_pendingIdx(0) {}
+
+		// Read the next pair, returns false at the end of the file
+		bool read(HitPair& pair)
+		{
+			if(!m_bPending && !m_reader.read(m_pendingIdx, m_pendingHits))
+				return false;
+			m_bPending = false;
+
+			size_t mate = m_pendingIdx % 2;
+			pair.firstIdx = m_pendingIdx - mate;
+			pair.hits[mate].swap(m_pendingHits);
+			pair.hits[1 - mate].clear();
+
+			// The next group is either the second mate or the start of the next pair
+			if(mate == 0 && m_reader.read(m_pendingIdx, m_pendingHits))
+			{
+				if(m_pendingIdx == pair.firstIdx + 1)
+					pair.hits[1].swap(m_pendingHits);
+				else
+					m_bPending = true;
+			}
+			return true;
+		}
+
+	private:
+		OverlapHitReader m_reader;
+		bool m_bPending;
+		size_t m_pendingIdx;
+		OverlapHitVector m_pendingHits;
+};
+
+// Add the hits of each read to the string graph as they are computed,
+// instead of writing them to a hit file that the assembler loads again
+class OverlapGraphProcess
+{
+	public:
+		OverlapGraphProcess(StringGraph* pGraph, const VertexPtrVec* pReadVertices,
+		                    const OverlapAlgorithm* pOverlapper, int minOverlap,
+		                    unsigned int graphMinOverlap, size_t graphMaxEdges) : m_pGraph(pGraph),
+		                                                                          m_pReadVertices(pReadVertices),
+		                                                                          m_overlapProcess(pOverlapper, minOverlap),
+		                                                                          m_graphMinOverlap(graphMinOverlap),
+		                                                                          m_graphMaxEdges(graphMaxEdges) {}
+
+		OverlapResult process(const SequenceWorkItem& item)
+		{
+			OverlapResult result = m_overlapProcess.computeHits(item, m_hits);
+			SGUtil::addHitEdges(m_pGraph, *m_pReadVertices, item.idx, m_hits, m_graphMinOverlap, true, m_graphMaxEdges);
+			return result;
+		}
+
+	private:
+		StringGraph* m_pGraph;
+		const VertexPtrVec* m_pReadVertices;
+		OverlapProcess m_overlapProcess;
+		OverlapHitVector m_hits;
+
+		// The filter of the edges added to the graph
+		unsigned int m_graphMinOverlap;
+		size_t m_graphMaxEdges;
+};
+
+// Set the flags of the vertices that the VT records of the ASQG file would carry
+class OverlapGraphPostProcess
+{
+	public:
+		OverlapGraphPostProcess(StringGraph* pGraph, const VertexPtrVec* pReadVertices) : m_pGraph(pGraph),
+		                                                                                 m_pReadVertices(pReadVertices) {}
+
+		void process(const SequenceWorkItem& item, const OverlapResult& result)
+		{
+			Vertex* pVertex = (*m_pReadVertices)[item.idx];
+			assert(pVertex->getID() == item.read.id);
+			if(result.isSubstring)
+			{
+				pVertex->setContained(true);
+				m_pGraph->setContainmentFlag(true);
+			}
+			if(result.isSuperRepeat)
+				pVertex->setSuperRepeat(true);
+		}
+
+	private:
+		StringGraph* m_pGraph;
+		const VertexPtrVec* m_pReadVertices;
+};
 
 //
 // Getopt
@@ -81,8 +209,15 @@ static const char *OVERLAP_USAGE_MESSAGE =
 "      -t, --threads=NUM                use NUM worker threads to compute the overlaps (default: no threading)\n"
 "      -e, --error-rate                 the maximum error rate allowed to consider two sequences aligned (default: exact matches only)\n"
 "      -m, --min-overlap=LEN            minimum overlap required between two reads (default: 45)\n"
-"      -f, --target-file=FILE           perform the overlap queries against the reads in FILE\n"
-"      -p, --paired-overlap             output only paired overlaps\n"
+"      -f, --target-file=FILE           perform the overlap queries against the reads in FILE. Requires --write-edges\n"
+"      -p, --paired-overlap             output only paired overlaps, the other edges are written to a .discard.edges.gz file\n"
+"                                       This implies --write-edges\n"
+"          --write-edges                write the edges into the ASQG file instead of the binary hit files read\n"
+"                                       by the assembler. Only in this mode are the edges to reads found to be\n"
+"                                       super repeats dropped when their overlap is shorter than 81 bases\n"
+"          --binary-graph               build the string graph in memory and write it as a binary graph (.sgb)\n"
+"                                       instead of the ASQG and hit files. The assembler loads it in parallel.\n"
+"                                       An output file given with -o must have the .sgb extension\n"
 "      -x, --exhaustive                 output all overlaps, including transitive edges\n"
 "          --exact                      force the use of the exact-mode irreducible block algorithm. This is faster\n"
 "                                       but requires that no substrings are present in the input set.\n"
@@ -92,8 +227,18 @@ static const char *OVERLAP_USAGE_MESSAGE =
 "                                       missing edges, this option may be preferable for some data sets.\n"
 "      -s, --seed-stride=LEN            force the seed stride to be LEN. This parameter will be ignored unless --seed-length\n"
 "                                       is specified (see above). This parameter defaults to the same value as --seed-length\n"
+"          --minimizer-filter           with --error-rate, only extend the seeds in the regions of a read that share\n"
+"                                       minimizers with other reads. This only prunes the seeds no other read supports,\n"
+"                                       so it saves little time on reads without repeats, and overlaps supported by a\n"
+"                                       single minimizer are missed\n"
+"          --skip-contained             do not compute the overlaps of the reads that are substrings or duplicates of\n"
+"                                       other reads, nor the overlaps to them. Their vertices are marked as substrings\n"
+"                                       and are removed by the assembler. Not available with --target-file\n"
 "      -d, --sample-rate=N              sample the symbol counts every N symbols in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
+"          --resume                     continue an interrupted run from its last checkpoint. The other options must be\n"
+"                                       the same as in the interrupted run\n"
+"          --checkpoint-interval=N      write a checkpoint every N seconds, 0 disables checkpoints (default: 600)\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 static const char* PROGRAM_IDENT =
@@ -116,11 +261,17 @@ namespace opt
 	static bool bIrreducibleOnly = true;
 	static bool bExactIrreducible = false;
 	static bool bIsPairedOverlapOnly  = false;
+	static bool bWriteEdges = false;
+	static bool bBinaryGraph = false;
+	static bool bMinimizerFilter = false;
+	static bool bSkipContained = false;
+	static bool bResume = false;
+	static int checkpointInterval = Checkpoint::DEFAULT_INTERVAL;
 }
 
 static const char* shortopts = "m:d:e:t:l:s:o:f:vixp";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_EXACT };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_EXACT, OPT_RESUME, OPT_CHECKPOINT_INTERVAL, OPT_WRITE_EDGES, OPT_MINIMIZER_FILTER, OPT_SKIP_CONTAINED, OPT_BINARY_GRAPH };
 
 static const struct option longopts[] = {
 	{ "verbose",     no_argument,       NULL, 'v' },
@@ -136,6 +287,12 @@ static const struct option longopts[] = {
 	{ "exhaustive",  no_argument,       NULL, 'x' },
 	{ "paired-overlap",no_argument,     NULL, 'p' },
 	{ "exact",       no_argument,       NULL, OPT_EXACT },
+	{ "resume",      no_argument,       NULL, OPT_RESUME },
+	{ "checkpoint-interval", required_argument, NULL, OPT_CHECKPOINT_INTERVAL },
+	{ "write-edges", no_argument,       NULL, OPT_WRITE_EDGES },
+	{ "binary-graph", no_argument,      NULL, OPT_BINARY_GRAPH },
+	{ "minimizer-filter", no_argument,  NULL, OPT_MINIMIZER_FILTER },
+	{ "skip-contained", no_argument,    NULL, OPT_SKIP_CONTAINED },
 	{ "help",        no_argument,       NULL, OPT_HELP },
 	{ "version",     no_argument,       NULL, OPT_VERSION },
 	{ NULL, 0, NULL, 0 }
@@ -144,24 +301,39 @@ static const struct option longopts[] = {
 //
 // Main
 //
-int overlapMain(int argc, char** argv)
+int overlapMain(int argc, char** argv, StringGraph** ppGraph, unsigned int graphMinOverlap, size_t graphMaxEdges)
 {
 	parseOverlapOptions(argc, argv);
 
 	// Prepare the output ASQG file
 	assert(opt::outputType == OT_ASQG);
 
-	// Open output file
-	std::ostream* pASQGWriter = createWriter(opt::outFile);
+	// The in-memory graph is not checkpointed, it is either returned or written as a binary graph
+	bool bBuildGraph = ppGraph != NULL || opt::bBinaryGraph;
+	if(bBuildGraph && (opt::bResume || opt::bWriteEdges || !opt::targetFile.empty()))
+	{
+		std::cerr << SUBPROGRAM ": the string graph can only be built in memory for a plain overlap of the reads\n";
+		exit(EXIT_FAILURE);
+	}
 
-	// Build and write the ASQG header
-	ASQG::HeaderRecord headerRecord;
-	headerRecord.setOverlapTag(opt::minOverlap);
-	headerRecord.setErrorRateTag(opt::errorRate);
-	headerRecord.setInputFileTag(opt::readsFile);
-	headerRecord.setContainmentTag(false); // containments are always present
-	headerRecord.setTransitiveTag(!opt::bIrreducibleOnly);
-	headerRecord.write(*pASQGWriter);
+	// Open output file. When resuming, the header is already in the file.
+	Checkpoint* pCheckpoint = NULL;
+	std::ostream* pASQGWriter = NULL;
+	if(!bBuildGraph)
+	{
+		pCheckpoint = new Checkpoint(opt::outFile + CHECKPOINT_EXT, opt::bResume, opt::checkpointInterval);
+		pASQGWriter = pCheckpoint->openOutput(opt::outFile);
+
+		// Build and write the ASQG header
+		ASQG::HeaderRecord headerRecord;
+		headerRecord.setOverlapTag(opt::minOverlap);
+		headerRecord.setErrorRateTag(opt::errorRate);
+		headerRecord.setInputFileTag(opt::readsFile);
+		headerRecord.setContainmentTag(false); // containments are always present
+		headerRecord.setTransitiveTag(!opt::bIrreducibleOnly);
+		if(!pCheckpoint->isResuming())
+			headerRecord.write(*pASQGWriter);
+	}
 
 	// Compute the overlap hits
 	StringVector hitsFilenames;
@@ -207,9 +379,39 @@ int overlapMain(int argc, char** argv)
 		pTargetRIT = pQueryRIT;
 
 	OverlapAlgorithm* pOverlapper = new OverlapAlgorithm(pBWT, pRBWT, pFwdSAI, pRevSAI, pQueryRIT, pTargetRIT);
+	if(pCheckpoint != NULL)
+		pCheckpoint->addBitVector("superRepeats", pOverlapper->getSuperRepeats());
+
+	// Allow differences in the overlaps if an error rate was given
+	MinimizerIndex* pMinimizerIndex = NULL;
+	if(opt::errorRate > 0)
+	{
+		pOverlapper->setInexactParameters(opt::errorRate, opt::seedLength, opt::seedStride);
+		pOverlapper->setExactModeOverlap(false);
+		pOverlapper->setExactModeIrreducible(opt::bExactIrreducible);
+
+		if(opt::bMinimizerFilter)
+		{
+			std::string targetFile = !opt::targetFile.empty() ? opt::targetFile : opt::readsFile;
+			pMinimizerIndex = new MinimizerIndex(targetFile);
+			pMinimizerIndex->setSkipSelf(pTargetRIT == pQueryRIT);
+			pOverlapper->setMinimizerIndex(pMinimizerIndex);
+			printf("[%s] sketched %zu reads with %zu minimizers\n", PROGRAM_IDENT, pMinimizerIndex->getNumReads(), pMinimizerIndex->getNumEntries());
+		}
+	}
 	
 	Timer* pTimer = new Timer(PROGRAM_IDENT);
 
+	// Find the contained reads before the overlaps so the overlaps to them are skipped too
+	AtomicBitVector* pContainedReads = NULL;
+	if(opt::bSkipContained)
+	{
+		pContainedReads = new AtomicBitVector(pQueryRIT->getCount());
+		size_t numContained = markContainedReads(opt::readsFile, pOverlapper, pContainedReads);
+		pOverlapper->setContainedReads(pContainedReads);
+		printf("[%s] %zu of %zu reads are contained in other reads and are skipped\n", PROGRAM_IDENT, numContained, pQueryRIT->getCount());
+	}
+
 	// Make a prefix for the hit edges files
 	std::string outPrefix;
 	outPrefix = stripFilename(opt::readsFile);
@@ -222,42 +424,109 @@ int overlapMain(int argc, char** argv)
 	time_t now = time(NULL);	
 	std::cout << "\n# start time of overlapping: " << asctime(localtime(&now))<<std::endl;
 	
-	if(opt::numThreads <= 1)
+	if(bBuildGraph)
+	{
+		printf("[%s] building the string graph in memory with %d threads\n", PROGRAM_IDENT, opt::numThreads);
+		StringGraph* pGraph = computeGraph(opt::numThreads, opt::readsFile, pOverlapper, opt::minOverlap, graphMinOverlap, graphMaxEdges);
+		if(ppGraph != NULL)
+		{
+			*ppGraph = pGraph;
+		}
+		else
+		{
+			printf("[%s] writing the binary graph to %s\n", PROGRAM_IDENT, opt::outFile.c_str());
+			if(!BinaryGraphFile::write(pGraph, opt::outFile))
+				exit(EXIT_FAILURE);
+			delete pGraph;
+		}
+	}
+	else if(opt::numThreads <= 1)
 	{
 		printf("[%s] starting serial-mode overlap computation\n", PROGRAM_IDENT);
-		computeHitsSerial(outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+		computeHitsSerial(outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter, pCheckpoint);
 	}
 	else
 	{
 		printf("[%s] starting parallel-mode overlap computation with %d threads\n", PROGRAM_IDENT, opt::numThreads);
-		computeHitsParallel(opt::numThreads, outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+		computeHitsParallel(opt::numThreads, outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter, pCheckpoint);
+	}
+
+	if(opt::verbose > 0)
+		printf("[%s] %zu reads were found to be super repeats\n", PROGRAM_IDENT, pOverlapper->getSuperRepeats()->count());
+
+	// Resolve the hits to edges of the ASQG file for the tools that need a complete graph.
+	// The hit files are removed so the assembler does not load the edges twice.
+	if(opt::bWriteEdges)
+	{
+		std::ostream* pDiscardWriter = NULL;
+		if(opt::bIsPairedOverlapOnly)
+			pDiscardWriter = createWriter(outPrefix + ".discard" + HITS_EXT + GZIP_EXT);
+
+		printf("[%s] converting the hits to edges\n", PROGRAM_IDENT);
+		convertHitsToASQG(hitsFilenames, pOverlapper, pASQGWriter, pDiscardWriter);
+		delete pDiscardWriter;
+
+		for(StringVector::const_iterator iter = hitsFilenames.begin(); iter != hitsFilenames.end(); ++iter)
+			unlink(iter->c_str());
 	}
 
 	delete pOverlapper;
+	delete pContainedReads;
+	delete pMinimizerIndex;
 	delete pBWT; 
 	delete pRBWT;
 	delete pASQGWriter;
 	delete pTimer;
 
+	// The run is complete, the checkpoint is no longer needed
+	if(pCheckpoint != NULL)
+		pCheckpoint->remove();
+	delete pCheckpoint;
+
 	return 0;
 }
 
+// Remove the hit files of an earlier run with more threads, and the text edge files
+// of older versions, otherwise the assembler would load inconsistent edges
+void removeStaleHitFiles(const std::string& prefix, size_t numFiles)
+{
+	struct stat buffer;
+	for(size_t fileIdx = 0; ; ++fileIdx)
+	{
+		std::stringstream hitSS;
+		hitSS << prefix << "-thread" << fileIdx << OVERLAP_HITS_EXT;
+		std::stringstream edgeSS;
+		edgeSS << prefix << "-thread" << fileIdx << HITS_EXT << GZIP_EXT;
+
+		bool hitExists = stat(hitSS.str().c_str(), &buffer) == 0;
+		bool edgeExists = stat(edgeSS.str().c_str(), &buffer) == 0;
+		if(!hitExists && !edgeExists && fileIdx >= numFiles)
+			break;
+
+		if(hitExists && fileIdx >= numFiles)
+			remove(hitSS.str().c_str());
+		if(edgeExists)
+			remove(edgeSS.str().c_str());
+	}
+}
+
 // Compute the hits for each read in the input file without threading
 // Return the number of reads processed
 size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile, const OverlapAlgorithm* pOverlapper, int minOverlap, 
-						StringVector& filenameVec, std::ostream* pASQGWriter)
+						StringVector& filenameVec, std::ostream* pASQGWriter, Checkpoint* pCheckpoint)
 {
-	std::string filename = prefix + "-thread0" +HITS_EXT + GZIP_EXT;
+	std::string filename = prefix + "-thread0" + OVERLAP_HITS_EXT;
 	filenameVec.push_back(filename);
+	removeStaleHitFiles(prefix, 1);
 
-	OverlapProcess processor(filename, pOverlapper, minOverlap);
+	OverlapProcess processor(filename, pOverlapper, minOverlap, pCheckpoint);
 	OverlapPostProcess postProcessor(pASQGWriter, pOverlapper);
 
 	size_t numProcessed = 
 	SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
 	OverlapResult, 
 	OverlapProcess, 
-	OverlapPostProcess>(readsFile, &processor, &postProcessor);
+	OverlapPostProcess>(readsFile, &processor, &postProcessor, pCheckpoint);
 	return numProcessed;
 }
 
@@ -268,7 +537,7 @@ size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile
 // The number of reads processsed is returned
 size_t computeHitsParallel(int numThreads, const std::string& prefix, const std::string& readsFile, 
 											const OverlapAlgorithm* pOverlapper, int minOverlap, 
-											StringVector& filenameVec, std::ostream* pASQGWriter)
+											StringVector& filenameVec, std::ostream* pASQGWriter, Checkpoint* pCheckpoint)
 {
 	//std::string filename = prefix + HITS_EXT + GZIP_EXT;
 
@@ -276,29 +545,17 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
 	for(int i = 0; i < numThreads; ++i)
 	{
 		std::stringstream ss;
-		ss << prefix << "-thread" << i << HITS_EXT << GZIP_EXT;
+		ss << prefix << "-thread" << i << OVERLAP_HITS_EXT;
 		std::string outfile = ss.str();
 		filenameVec.push_back(outfile);
-		OverlapProcess* pProcessor = new OverlapProcess(outfile, pOverlapper, minOverlap);
+		OverlapProcess* pProcessor = new OverlapProcess(outfile, pOverlapper, minOverlap, pCheckpoint);
 		processorVector.push_back(pProcessor);
 	}
 
 	//Remove previous edge files generated by larger threads, otherwise, subsequent assembly may load inconsistent edges files
-	std::stringstream ss;
-	size_t fileIdx=numThreads;
-	ss << prefix << "-thread" << fileIdx << HITS_EXT << GZIP_EXT;
-	std::string edgefile = ss.str();
-	
-	struct stat buffer;   
-	while(stat (edgefile.c_str(), &buffer) == 0)
-	{
-		remove(edgefile.c_str());
-		//search for next edge file
-		ss.str("");
-		fileIdx++;
-		ss << prefix << "-thread" << fileIdx << HITS_EXT << GZIP_EXT;
-		edgefile = ss.str();
-	}
+	//A resumed run has checked that the thread count matches the checkpoint before getting here
+	pCheckpoint->validate();
+	removeStaleHitFiles(prefix, numThreads);
 	/*
 	std::istream* pistream = createReader(edgefile);
 	while(pistream->peek()!=std::istream::traits_type::eof())
@@ -321,7 +578,7 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
 	SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
 	OverlapResult, 
 	OverlapProcess, 
-	OverlapPostProcess>(readsFile, processorVector, &postProcessor);
+	OverlapPostProcess>(readsFile, processorVector, &postProcessor, pCheckpoint);
 
 	for(int i = 0; i < numThreads; ++i)
 		delete processorVector[i];
@@ -329,143 +586,262 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
 	return numProcessed;
 }
 
-//
-// void convertHitsToASQG(const std::string& indexPrefix, const StringVector& hitsFilenames, std::ostream* pASQGWriter, 
-										// DenseHashSet < std::string, StringHasher > *SuperRepeatVertices)
-// {
-	// // Load the suffix array index and the reverse suffix array index
-	// // Note these are not the full suffix arrays
-	// SuffixArray* pFwdSAI = new SuffixArray(indexPrefix + SAI_EXT);
-	// SuffixArray* pRevSAI = new SuffixArray(indexPrefix + RSAI_EXT);
-
-	// // Load the ReadInfoTable for the queries to look up the ID and lengths of the hits
-	// ReadInfoTable* pQueryRIT = new ReadInfoTable(opt::readsFile);
-
-	// // If the target file is not the query file, load its ReadInfoTable
-	// ReadInfoTable* pTargetRIT;
-	// if(!opt::targetFile.empty() && opt::targetFile != opt::readsFile)
-	// pTargetRIT = new ReadInfoTable(opt::targetFile);
-	// else
-	// pTargetRIT = pQueryRIT;
-
-	// bool bIsSelfCompare = pTargetRIT == pQueryRIT;
-	
-	// // Convert the hits to overlaps and write them to the asqg file as initial edges
-	// for(StringVector::const_iterator iter = hitsFilenames.begin(); iter != hitsFilenames.end(); ++iter)
-	// {
-		// printf("[%s] parsing file %s\n", PROGRAM_IDENT, iter->c_str());
-		// std::istream* pReader = createReader(*iter);
-		
-		// // Read each hit sequentially, converting it to an overlap
-		// std::string line;
-		// while(getline(*pReader, line))
-		// {
-			// size_t readIdx;
-			// size_t totalEntries;
-			// bool isSubstring;
-			// OverlapVector ov;
-			// OverlapCommon::parseHitsString(line, pQueryRIT, pTargetRIT, pFwdSAI, pRevSAI, bIsSelfCompare, readIdx, totalEntries, ov, isSubstring, SuperRepeatVertices);
-			// for(OverlapVector::iterator iter = ov.begin(); iter != ov.end(); ++iter)
-			// {
-				// ASQG::EdgeRecord edgeRecord(*iter);
-				// edgeRecord.write(*pASQGWriter);
-			// }
-		// }
-		// delete pReader;
-
-		// // delete the hits file
-		// unlink(iter->c_str());
-	// }
-
-	// // Deallocate data
-	// if(pTargetRIT != pQueryRIT)
-	// delete pTargetRIT;
-	// delete pFwdSAI;
-	// delete pRevSAI;
-	// delete pQueryRIT;
-// }
-
-/************************************************************************************************************************************************/
-
-// void convertHitsToASQGedgeParallel(const std::string hitsFilename, std::ostream* pASQGWriter ,std::ostream* pDiscardEdgeWriter
-	// ,SuffixArray* pFwdSAI ,SuffixArray* pRevSAI , ReadInfoTable* pQueryRIT , ReadInfoTable* pTargetRIT, DenseHashSet < std::string, StringHasher > *SuperRepeatVertices)
-// {
-
-
-	// bool bIsSelfCompare = pTargetRIT == pQueryRIT;
-
-	// // Convert the hits to overlaps and write them to the asqg file as initial edges
-
-	// printf("[%s] parsing file %s\n", PROGRAM_IDENT, hitsFilename.c_str());
-	// std::istream* pReader = createReader(hitsFilename);
-
-	// // paired-overlap mode
-
-	// std::string line,line2;
-	// while(getline(*pReader, line) && getline(*pReader, line2) )
-	// {
-		// size_t readIdx;
-		// size_t totalEntries;
-		// bool isSubstring;
-
-		// OverlapVector ov1;
-		// OverlapCommon::parseHitsString(line, pQueryRIT, pTargetRIT, pFwdSAI, pRevSAI, bIsSelfCompare, readIdx, totalEntries, ov1, isSubstring, SuperRepeatVertices);
-
-		// OverlapVector ov2;
-		// OverlapCommon::parseHitsString(line2, pQueryRIT, pTargetRIT, pFwdSAI, pRevSAI, bIsSelfCompare, readIdx, totalEntries, ov2, isSubstring, SuperRepeatVertices);
-
-		// ReadHashSet ov2_set;
-		// ReadHashSet intersection;
-		// ov2_set.set_empty_key("");
-		// intersection.set_empty_key("");
-		
-		// for(OverlapVector::iterator iter = ov2.begin(); iter != ov2.end(); ++iter)
-		// {
-			// Overlap r2=*iter;
-			// if (!r2.match.isReverse) 
-			// ov2_set.insert (r2.id[1].substr(0,r2.id[1].find_last_of("/")));
-		// }			
-
-		
-		// for(OverlapVector::iterator iter = ov1.begin(); iter != ov1.end(); ++iter)
-		// {
-			// ASQG::EdgeRecord edgeRecord(*iter);
-			// Overlap r1=*iter;
-			// if (r1.match.isReverse) {  edgeRecord.write (*pDiscardEdgeWriter); continue; }
-			// std::string mainName=r1.id[1].substr(0,r1.id[1].find_last_of("/"));
-			// ReadHashSetIter RHSiter = ov2_set.find (mainName);
-			// if (RHSiter != ov2_set.end()) 
-			// {
-				// intersection.insert (mainName);	
-				// edgeRecord.write(*pASQGWriter);	
-			// }
-			// else edgeRecord.write (*pDiscardEdgeWriter);
-		// }
-		
-
-		// for(OverlapVector::iterator iter = ov2.begin(); iter != ov2.end(); ++iter)
-		// {
-			// ASQG::EdgeRecord edgeRecord(*iter);
-			// Overlap r2=*iter;
-			// if (r2.match.isReverse) { edgeRecord.write (*pDiscardEdgeWriter); continue; }
-			// ReadHashSetIter RHSiter = intersection.find (r2.id[1].substr(0,r2.id[1].find_last_of("/")));
-			// if (RHSiter != intersection.end()) edgeRecord.write(*pASQGWriter);
-			// else edgeRecord.write (*pDiscardEdgeWriter);
-		// }
-		
-	// }
-	
+// Compute the overlaps of the reads and add them as edges of the string graph as the
+// workers produce them. The vertices are created beforehand in read order, as the vertex
+// table of the graph cannot be modified concurrently, and each worker then adds its
+// edges under the locks of the two vertices.
+StringGraph* computeGraph(int numThreads, const std::string& readsFile, const OverlapAlgorithm* pOverlapper, int minOverlap,
+                          unsigned int graphMinOverlap, size_t graphMaxEdges)
+{
+	VertexPtrVec readVertices;
+	StringGraph* pGraph = SGUtil::loadFASTA(readsFile, &readVertices);
+	assert(readVertices.size() == pOverlapper->getQueryRIT()->getCount());
 
-	// delete pReader;
+	// The properties the ASQG header would carry
+	pGraph->setMinOverlap(minOverlap);
+	pGraph->setErrorRate(opt::errorRate);
+	pGraph->setContainmentFlag(false);
+	pGraph->setTransitiveFlag(!opt::bIrreducibleOnly);
 
-	// // delete the hits file
-	// unlink(hitsFilename.c_str());
-	
-// }
+	std::vector<OverlapGraphProcess*> processorVector;
+	for(int i = 0; i < numThreads; ++i)
+		processorVector.push_back(new OverlapGraphProcess(pGraph, &readVertices, pOverlapper, minOverlap, graphMinOverlap, graphMaxEdges));
+	OverlapGraphPostProcess postProcessor(pGraph, &readVertices);
 
+	if(numThreads <= 1)
+	{
+		SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
+		OverlapResult, 
+		OverlapGraphProcess, 
+		OverlapGraphPostProcess>(readsFile, processorVector.front(), &postProcessor);
+	}
+	else
+	{
+		SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
+		OverlapResult, 
+		OverlapGraphProcess, 
+		OverlapGraphPostProcess>(readsFile, processorVector, &postProcessor);
+	}
+
+	for(int i = 0; i < numThreads; ++i)
+		delete processorVector[i];
 
+	// Remove any duplicate edges, as the assembler does after loading the hit files
+	SGDuplicateVisitor dupVisit;
+	pGraph->visit(dupVisit);
+	return pGraph;
+}
+
+// Mark the reads that are contained in other reads. The reads are checked in
+// batches so only a part of the reads file is in memory.
+size_t markContainedReads(const std::string& readsFile, const OverlapAlgorithm* pOverlapper, AtomicBitVector* pContained)
+{
+	SeqReader reader(readsFile, SRF_NO_VALIDATION);
+	SeqRecord record;
+	StringVector batch;
+	size_t batchStart = 0;
+	size_t numContained = 0;
+	bool bDone = false;
+	while(!bDone)
+	{
+		batch.clear();
+		while(batch.size() < CONTAIN_BATCH_SIZE && !bDone)
+		{
+			bDone = !reader.get(record);
+			if(!bDone)
+				batch.push_back(record.seq.toString());
+		}
+
+		#pragma omp parallel for schedule(dynamic, 256) num_threads(opt::numThreads) reduction(+:numContained)
+		for(int64_t i = 0; i < (int64_t)batch.size(); ++i)
+		{
+			if(pOverlapper->checkContainedRead(batch[i], batchStart + i))
+			{
+				pContained->testAndSet(batchStart + i);
+				++numContained;
+			}
+		}
+		batchStart += batch.size();
+	}
+	return numContained;
+}
+
+// Resolve the hits of a query read to overlaps between the read ids
+void resolveHits(size_t queryIdx, const OverlapHitVector& hits, const OverlapAlgorithm* pOverlapper, OverlapVector& outVector)
+{
+	// The read tables are only read here so they are shared by all threads
+	const ReadInfoTable* pQueryRIT = pOverlapper->getQueryRIT();
+	const ReadInfoTable* pTargetRIT = pOverlapper->getTargetRIT();
+	bool bIsSelfCompare = pQueryRIT == pTargetRIT;
+	std::string queryID = pQueryRIT->getReadID(queryIdx);
+	int queryLength = pQueryRIT->getReadLength(queryIdx);
+
+	for(OverlapHitVector::const_iterator iter = hits.begin(); iter != hits.end(); ++iter)
+	{
+		Overlap o = iter->toOverlap(queryID, queryLength, pTargetRIT->getReadID(iter->targetIdx), pTargetRIT->getReadLength(iter->targetIdx));
+
+		//Don't push edges of target of super repeat vertices and small overlap.
+		//The repeats are only known for the query reads.
+		if(bIsSelfCompare && o.match.getMinOverlapLength() < SUPER_REPEAT_MIN_OVERLAP && pOverlapper->isSuperRepeatRead(iter->targetIdx))
+			continue;
+
+		outVector.push_back(o);
+	}
+}
+
+// Append the buffered edge records of a thread to the output once the buffer is large,
+// or whenever force is set
+void flushEdgeBuffer(std::ostringstream& buffer, std::ostream* pWriter, bool force)
+{
+	if(!force && buffer.tellp() < (std::streampos)EDGE_BUFFER_SIZE)
+		return;
+
+	#pragma omp critical (EdgeWriter)
+	{
+		*pWriter << buffer.str();
+	}
+	buffer.str("");
+}
+
+// Write the edges of a read pair. Only forward edges to a pair of reads
+// that overlaps both mates are kept, the others are discarded
+void writePairedEdges(const OverlapVector& ov1, const OverlapVector& ov2, std::ostream& edgeWriter, std::ostream& discardWriter)
+{
+	ReadHashSet ov2_set;
+	ReadHashSet intersection;
+	ov2_set.set_empty_key("");
+	intersection.set_empty_key("");
+
+	for(OverlapVector::const_iterator iter = ov2.begin(); iter != ov2.end(); ++iter)
+	{
+		if(!iter->match.isReverse)
+			ov2_set.insert(iter->id[1].substr(0, iter->id[1].find_last_of("/")));
+	}
+
+	for(OverlapVector::const_iterator iter = ov1.begin(); iter != ov1.end(); ++iter)
+	{
+		ASQG::EdgeRecord edgeRecord(*iter);
+		if(iter->match.isReverse)
+		{
+			edgeRecord.write(discardWriter);
+			continue;
+		}
+
+		std::string mainName = iter->id[1].substr(0, iter->id[1].find_last_of("/"));
+		if(ov2_set.find(mainName) != ov2_set.end())
+		{
+			intersection.insert(mainName);
+			edgeRecord.write(edgeWriter);
+		}
+		else
+			edgeRecord.write(discardWriter);
+	}
+
+	for(OverlapVector::const_iterator iter = ov2.begin(); iter != ov2.end(); ++iter)
+	{
+		ASQG::EdgeRecord edgeRecord(*iter);
+		if(!iter->match.isReverse && intersection.find(iter->id[1].substr(0, iter->id[1].find_last_of("/"))) != intersection.end())
+			edgeRecord.write(edgeWriter);
+		else
+			edgeRecord.write(discardWriter);
+	}
+}
+
+// Convert the hit files into edge records of the ASQG file. The files are decoded
+// concurrently and each thread collects its edges in a buffer that is appended to the
+// output in large blocks. In paired-overlap mode the edges that are not supported
+// by both mates of a pair are written to pDiscardWriter.
+void convertHitsToASQG(const StringVector& hitsFilenames, const OverlapAlgorithm* pOverlapper, 
+						std::ostream* pASQGWriter, std::ostream* pDiscardWriter)
+{
+	if(!opt::bIsPairedOverlapOnly)
+	{
+		#pragma omp parallel for schedule(dynamic) num_threads(opt::numThreads)
+		for(size_t i = 0; i < hitsFilenames.size(); ++i)
+		{
+			OverlapHitReader reader(hitsFilenames[i]);
+			std::ostringstream edgeBuffer;
+			size_t queryIdx;
+			OverlapHitVector hits;
+			OverlapVector ov;
+			while(reader.read(queryIdx, hits))
+			{
+				ov.clear();
+				resolveHits(queryIdx, hits, pOverlapper, ov);
+				for(OverlapVector::iterator iter = ov.begin(); iter != ov.end(); ++iter)
+				{
+					ASQG::EdgeRecord edgeRecord(*iter);
+					edgeRecord.write(edgeBuffer);
+				}
+				flushEdgeBuffer(edgeBuffer, pASQGWriter, false);
+			}
+			flushEdgeBuffer(edgeBuffer, pASQGWriter, true);
+		}
+		return;
+	}
+
+	// The files are decoded a batch of pairs at a time, in parallel over the files,
+	// and the pairs of the batch are then resolved in parallel
+	assert(pDiscardWriter != NULL);
+	std::vector<HitPairReader*> readers;
+	for(size_t i = 0; i < hitsFilenames.size(); ++i)
+		readers.push_back(new HitPairReader(hitsFilenames[i]));
+
+	size_t pairsPerFile = HIT_PAIR_BATCH_SIZE / std::max<size_t>(readers.size(), 1) + 1;
+	std::vector<HitPairVector> batches(readers.size());
+	std::vector<HitPair*> pairs;
+	while(true)
+	{
+		#pragma omp parallel for schedule(dynamic) num_threads(opt::numThreads)
+		for(size_t i = 0; i < readers.size(); ++i)
+		{
+			batches[i].resize(pairsPerFile);
+			size_t numPairs = 0;
+			while(numPairs < pairsPerFile && readers[i]->read(batches[i][numPairs]))
+				++numPairs;
+			batches[i].resize(numPairs);
+		}
+
+		pairs.clear();
+		for(size_t i = 0; i < batches.size(); ++i)
+		{
+			for(size_t j = 0; j < batches[i].size(); ++j)
+				pairs.push_back(&batches[i][j]);
+		}
+		if(pairs.empty())
+			break;
+
+		#pragma omp parallel num_threads(opt::numThreads)
+		{
+			std::ostringstream edgeBuffer;
+			std::ostringstream discardBuffer;
+			OverlapVector ov[2];
+
+			#pragma omp for schedule(dynamic, 256)
+			for(int64_t i = 0; i < (int64_t)pairs.size(); ++i)
+			{
+				// A mate without hits may also be a last read without a mate,
+				// so only the mates with hits are looked up
+				for(size_t j = 0; j < 2; ++j)
+				{
+					ov[j].clear();
+					if(!pairs[i]->hits[j].empty())
+						resolveHits(pairs[i]->firstIdx + j, pairs[i]->hits[j], pOverlapper, ov[j]);
+				}
+
+				writePairedEdges(ov[0], ov[1], edgeBuffer, discardBuffer);
+				flushEdgeBuffer(edgeBuffer, pASQGWriter, false);
+				flushEdgeBuffer(discardBuffer, pDiscardWriter, false);
+			}
+			flushEdgeBuffer(edgeBuffer, pASQGWriter, true);
+			flushEdgeBuffer(discardBuffer, pDiscardWriter, true);
+		}
+	}
+
+	for(size_t i = 0; i < readers.size(); ++i)
+		delete readers[i];
+}
 
-/*************************************************************************************************************************************************/
 // 
 // Handle command line arguments
 //
@@ -487,8 +863,14 @@ void parseOverlapOptions(int argc, char** argv)
 		case 'd': arg >> opt::sampleRate; break;
 		case 'f': arg >> opt::targetFile; break;
 		case OPT_EXACT: opt::bExactIrreducible = true; break;
+		case OPT_RESUME: opt::bResume = true; break;
+		case OPT_CHECKPOINT_INTERVAL: arg >> opt::checkpointInterval; break;
+		case OPT_WRITE_EDGES: opt::bWriteEdges = true; break;
+		case OPT_BINARY_GRAPH: opt::bBinaryGraph = true; break;
+		case OPT_MINIMIZER_FILTER: opt::bMinimizerFilter = true; break;
+		case OPT_SKIP_CONTAINED: opt::bSkipContained = true; break;
 		case 'x': opt::bIrreducibleOnly = false; break;
-		case 'p': opt::bIsPairedOverlapOnly = true;  opt::bIrreducibleOnly = false; break;
+		case 'p': opt::bIsPairedOverlapOnly = true;  opt::bIrreducibleOnly = false; opt::bWriteEdges = true; break;
 		case '?': die = true; break;
 		case 'v': opt::verbose++; break;
 		case OPT_HELP:
@@ -523,6 +905,33 @@ void parseOverlapOptions(int argc, char** argv)
 		die = true;
 	}
 
+	if(opt::checkpointInterval < 0)
+	{
+		std::cerr << SUBPROGRAM ": invalid checkpoint interval: " << opt::checkpointInterval << "\n";
+		die = true;
+	}
+
+	if(opt::bSkipContained && !opt::targetFile.empty())
+	{
+		std::cerr << SUBPROGRAM ": --skip-contained cannot be used with --target-file\n";
+		die = true;
+	}
+
+	// The hit files refer to the targets by their index in the reads file, which only
+	// the edges resolved here can map back to the target reads
+	if(!opt::targetFile.empty() && !opt::bWriteEdges && !opt::bBinaryGraph)
+	{
+		std::cerr << SUBPROGRAM ": --target-file requires --write-edges, the hit files read by the assembler cannot refer to the target reads\n";
+		die = true;
+	}
+
+	// assemble and subgraph pick the graph loader by the extension
+	if(opt::bBinaryGraph && !opt::outFile.empty() && !isBinaryGraph(opt::outFile))
+	{
+		std::cerr << SUBPROGRAM ": the output file of --binary-graph must have the " BINARY_GRAPH_EXT " extension, got: " << opt::outFile << "\n";
+		die = true;
+	}
+
 	if (die) 
 	{
 		std::cout << "\n" << OVERLAP_USAGE_MESSAGE;
@@ -550,6 +959,6 @@ void parseOverlapOptions(int argc, char** argv)
 			prefix.append(1,'.');
 			prefix.append(stripFilename(opt::targetFile));
 		}
-		opt::outFile = prefix + ASQG_EXT + GZIP_EXT;
+		opt::outFile = prefix + (opt::bBinaryGraph ? BINARY_GRAPH_EXT : ASQG_EXT GZIP_EXT);
 	}
 }
@@ -14,11 +14,20 @@
 #include "Match.h"
 #include "BWTAlgorithms.h"
 #include "OverlapAlgorithm.h"
+#include "SGUtil.h"
 
 // functions
 
-//
-int overlapMain(int argc, char** argv);
+// Maximum number of edges of a vertex of a graph built in memory, unless the caller gives its own
+const size_t GRAPH_MAX_EDGES = 512;
+
+// If ppGraph is given, the string graph is built in memory and returned
+// through it instead of writing the ASQG and hit files. The caller gives
+// the filter the assembler would apply when loading the edges: overlaps
+// shorter than graphMinOverlap are dropped, and no edges are added to a
+// vertex that has more than graphMaxEdges.
+int overlapMain(int argc, char** argv, StringGraph** ppGraph = NULL,
+                unsigned int graphMinOverlap = 0, size_t graphMaxEdges = GRAPH_MAX_EDGES);
 
 // options
 void parseOverlapOptions(int argc, char** argv);
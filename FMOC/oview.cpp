@@ -15,6 +15,7 @@
 #include "SuffixArray.h"
 #include "BWT.h"
 #include "SGUtil.h"
+#include "BinaryGraphFile.h"
 #include "MultiOverlap.h"
 
 void detectMisalignments(const ReadTable* pRT, const OverlapMap* pOM);
@@ -33,7 +34,7 @@ SUBPROGRAM " Version " PACKAGE_VERSION "\n"
 
 static const char *OVIEW_USAGE_MESSAGE =
 "Usage: " PACKAGE_NAME " " SUBPROGRAM " [OPTION] ... ASQGFILE\n"
-"Draw overlaps in ASQGFILE\n"
+"Draw overlaps in ASQGFILE, which may also be a binary graph (.sgb)\n"
 "\n"
 "  -v, --verbose                        display verbose output\n"
 "      --help                           display this help and exit\n"
@@ -78,7 +79,10 @@ int oviewMain(int argc, char** argv)
     ReadTable* pRT = new ReadTable();
     OverlapMap* pOM = new OverlapMap;
 
-    parseASQG(opt::asqgFile, pRT, pOM);
+    if(isBinaryGraph(opt::asqgFile))
+        parseBinaryGraph(opt::asqgFile, pRT, pOM);
+    else
+        parseASQG(opt::asqgFile, pRT, pOM);
     pRT->indexReadsByID();
 
     // draw mode
@@ -188,6 +192,38 @@ void parseASQG(std::string filename, ReadTable* pRT, OverlapMap* pOM)
     delete pReader;
 }
 
+// Read the vertices and overlaps from a binary graph without building the graph.
+// Both edges of an overlap are stored so only the ones writeASQG would write are used.
+void parseBinaryGraph(std::string filename, ReadTable* pRT, OverlapMap* pOM)
+{
+    BinaryGraphFile file(filename);
+    std::string seq;
+    for(size_t i = 0; i < file.getNumVertices(); ++i)
+    {
+        SeqItem si;
+        file.getID(i, si.id);
+        file.getSequence(i, seq);
+        si.seq = seq;
+        pRT->addRead(si);
+    }
+
+    for(size_t i = 0; i < file.getNumVertices(); ++i)
+    {
+        const BinaryGraphVertex& vertex = file.getVertex(i);
+        for(uint64_t j = vertex.firstEdge; j < vertex.firstEdge + vertex.numEdges; ++j)
+        {
+            Overlap ovr = file.getOverlap(i, j);
+            if(ovr.id[0] > ovr.id[1] || (ovr.isContainment() && (file.getEdge(j).flags & BEF_ANTISENSE)))
+                continue;
+
+            if(opt::readFilter.empty() || ovr.id[0] == opt::readFilter || ovr.id[1] == opt::readFilter)
+            {
+                (*pOM)[ovr.id[0]].push_back(ovr);
+                (*pOM)[ovr.id[1]].push_back(ovr);
+            }
+        }
+    }
+}
 
 // 
 // Handle command line arguments
@@ -39,6 +39,7 @@ void drawAlignment(std::string rootID, const ReadTable* pRT, const OverlapMap* p
 
 
 void parseASQG(std::string filename, ReadTable* pRT, OverlapMap* pOM);
+void parseBinaryGraph(std::string filename, ReadTable* pRT, OverlapMap* pOM);
 void parseOviewOptions(int argc, char** argv);
 
 #endif
@@ -11,11 +11,71 @@
 #include <getopt.h>
 #include "config.h"
 #include "Quality.h"
+#include "SequenceWorkItem.h"
+
+// The outcome of preprocessing one read. The counters are kept per read
+// so the threads do not share any state; they are summed in input order
+// by the post processor.
+struct PreprocessResult
+{
+    PreprocessResult() : passed(false), numBasesRead(0), failedPrimer(false), failedDust(false) {}
+
+    SeqRecord record;
+    bool passed;
+    size_t numBasesRead;
+    bool failedPrimer;
+    bool failedDust;
+
+    // Verbose output for this read, printed when the read is written
+    std::string log;
+};
+
+struct PreprocessPairResult
+{
+    PreprocessResult first;
+    PreprocessResult second;
+};
+
+// Trim and filter reads or read pairs
+class PreprocessProcess
+{
+    public:
+        PreprocessProcess() {}
+
+        PreprocessResult process(const SequenceWorkItem& item);
+        PreprocessPairResult process(const SequenceWorkItemPair& item);
+};
+
+// Write the reads that passed in input order and collect the statistics
+class PreprocessPostProcess
+{
+    public:
+        PreprocessPostProcess(std::ostream* pWriter, std::ostream* pOrphanWriter);
+
+        void process(const SequenceWorkItem& item, const PreprocessResult& result);
+        void process(const SequenceWorkItemPair& item, const PreprocessPairResult& result);
+
+        void printStats() const;
+
+    private:
+        void addStats(const PreprocessResult& result);
+
+        std::ostream* m_pWriter;
+        std::ostream* m_pOrphanWriter;
+
+        int64_t m_numReadsRead;
+        int64_t m_numReadsKept;
+        int64_t m_numBasesRead;
+        int64_t m_numBasesKept;
+        int64_t m_numReadsPrimer;
+        int64_t m_numInvalidPE;
+        int64_t m_numFailedDust;
+};
 
 // functions
 int preprocessMain(int argc, char** argv);
 void parsePreprocessOptions(int argc, char** argv);
-bool processRead(SeqRecord& record);
+bool processRead(PreprocessResult& result);
 bool samplePass();
 void softClip(int qualTrim, std::string& seq, std::string& qual);
 int countLowQuality(const std::string& seq, const std::string& qual);
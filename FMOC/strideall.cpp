@@ -49,6 +49,8 @@ static const char *STRIDE_USAGE_MESSAGE =
 "      -k, --kmer-size=N                length of kmer (default: 31)\n"
 "      -c, --kmer-threshold=N           kmer frequency cutoff (default: 3)\n"
 "      -m, --min-overlap=LEN            minimum reliable overlap length (default: read length * 0.8)\n"
+"          --in-memory-graph            build the string graph in memory during the overlap stage and assemble it\n"
+"                                       directly, without writing and re-loading the ASQG and hit files\n"
 "      --help                           display this help and exit\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
@@ -63,13 +65,14 @@ namespace opt
 	static size_t kmerLength = 31;
 	static size_t kmerThreshold = 3;			//3 is good for 100x coverage 
 	static size_t minOverlap = 0;				//0.8 is good for 100x coverage 
+	static bool bInMemoryGraph = false;
 
 }
 
 
 static const char* shortopts = "k:c:r:m:i:t:v";
 
-enum { OPT_HELP = 1, OPT_VERSION};
+enum { OPT_HELP = 1, OPT_VERSION, OPT_IN_MEMORY_GRAPH };
 
 static const struct option longopts[] = {
 	{ "verbose",               no_argument,       NULL, 'v' },
@@ -80,6 +83,7 @@ static const struct option longopts[] = {
 	{ "kmer-length",           required_argument, NULL, 'k' },
 	{ "kmer-threshold",        required_argument, NULL, 'c' },
 	{ "min-overlap",      required_argument, NULL, 'm' },
+	{ "in-memory-graph",       no_argument,       NULL, OPT_IN_MEMORY_GRAPH },
 	{ "help",                  no_argument,       NULL, OPT_HELP },
 	{ "version",               no_argument,       NULL, OPT_VERSION },
 	{ NULL, 0, NULL, 0 }
@@ -91,14 +95,14 @@ int StrideMain(int argc, char** argv)
     Timer* pTimer = new Timer("Stride all-in-one");
     parseStrideOptions(argc, argv);
 
-	//$Stride preprocess --discard-quality -p 1 insert_180_1.fastq insert_180_2.fastq -o reads.fa
+	//$Stride preprocess --discard-quality -p 1 insert_180_1.fastq insert_180_2.fastq -o reads.prd
 	std::vector <std::string> vec;
 	vec.push_back("preprocess");
 	vec.push_back("--discard-quality");
 	vec.push_back("-p");
 	vec.push_back("1");
 	vec.push_back("-o");
-	vec.push_back("reads.fa");
+	vec.push_back("reads.prd");
 
 	while(optind < argc)
     {
@@ -134,14 +138,14 @@ int StrideMain(int argc, char** argv)
 
 	std::cout << "\n\n\t [ Stage I: Error correction ] \n\n";
 
-	//$Stride index -a ropebwt -t $thread reads.fa
+	//$Stride index -a ropebwt -t $thread reads.prd
 	std::vector <std::string> vec1;
 	vec1.push_back("index");
 	vec1.push_back("-t");
 	std::stringstream ssnumthread;
 	ssnumthread << opt::numthread;
 	vec1.push_back(ssnumthread.str());
-	vec1.push_back("reads.fa");
+	vec1.push_back("reads.prd");
 
 	char ** arr1 = new char*[vec1.size()];
 	for(size_t i = 0; i < vec1.size(); i++){
@@ -151,7 +155,7 @@ int StrideMain(int argc, char** argv)
     indexMain(vec1.size(), arr1);
 	free(arr1);
 
-	//$Stride correct -a overlap -r 11 -t $thread -k $kmersize -x $kmerthreshold reads.fa -o READ.ECOLr.fasta
+	//$Stride correct -a overlap -r 11 -t $thread -k $kmersize -x $kmerthreshold reads.prd -o READ.ECOLr.prd
 	std::vector <std::string> vec2;
 	vec2.push_back("correct");
 	vec2.push_back("-a");
@@ -169,8 +173,8 @@ int StrideMain(int argc, char** argv)
 	sskmerThreshold << opt::kmerThreshold;
 	vec2.push_back(sskmerThreshold.str());
 	vec2.push_back("-o");
-	vec2.push_back("READ.ECOLr.fasta");
-	vec2.push_back("reads.fa");
+	vec2.push_back("READ.ECOLr.prd");
+	vec2.push_back("reads.prd");
 
 	char ** arr2 = new char*[vec2.size()];
 	for(size_t i = 0; i < vec2.size(); i++){
@@ -182,12 +186,12 @@ int StrideMain(int argc, char** argv)
 
 	std::cout << "\n\n\t [ Stage II: merge paired-end reads into long reads and kmerize error-prone reads ] \n\n";
 
-	//$Stride index -a ropebwt -t $thread READ.ECOLr.fasta
+	//$Stride index -a ropebwt -t $thread READ.ECOLr.prd
 	std::vector <std::string> vec3;
 	vec3.push_back("index");
 	vec3.push_back("-t");
 	vec3.push_back(ssnumthread.str());
-	vec3.push_back("READ.ECOLr.fasta");
+	vec3.push_back("READ.ECOLr.prd");
 	char ** arr3 = new char*[vec3.size()];
 	for(size_t i = 0; i < vec3.size(); i++){
 		arr3[i] = new char[vec3[i].size() + 1];
@@ -196,7 +200,7 @@ int StrideMain(int argc, char** argv)
     indexMain(vec3.size(), arr3);
 	free(arr3);
 
-	//Stride fmwalk -m 80 -t $thread -L $MaxBFSLeaves -I $BFSSearchDepth -x $kmerthreshold -k $kmersize READ.ECOLr.fasta
+	//Stride fmwalk -m 80 -t $thread -L $MaxBFSLeaves -I $BFSSearchDepth -x $kmerthreshold -k $kmersize READ.ECOLr.prd
 	std::vector <std::string> vec4;
 	vec4.push_back("fmwalk");
 	vec4.push_back("-m");
@@ -215,7 +219,7 @@ int StrideMain(int argc, char** argv)
 	vec4.push_back(sskmerLength.str());
 	vec4.push_back("-x");
 	vec4.push_back(sskmerThreshold.str());
-	vec4.push_back("READ.ECOLr.fasta");
+	vec4.push_back("READ.ECOLr.prd");
 
 	char ** arr4 = new char*[vec4.size()];
 	for(size_t i = 0; i < vec4.size(); i++){
@@ -289,7 +293,10 @@ int StrideMain(int argc, char** argv)
 		arr7[i] = new char[vec7[i].size() + 1];
 		strcpy(arr7[i], vec7[i].c_str());
 	}
-    overlapMain(vec7.size(), arr7);
+	// The in-memory graph is handed to the assembler without the ASQG and hit files,
+	// its edges are filtered as the assembler filters the edges of the hit files
+	StringGraph* pGraph = NULL;
+    overlapMain(vec7.size(), arr7, opt::bInMemoryGraph ? &pGraph : NULL, ASSEMBLE_MIN_OVERLAP, ASSEMBLE_MAX_EDGES);
 	free(arr7);
 	unlink("merged.discard.fa");
 
@@ -319,7 +326,7 @@ int StrideMain(int argc, char** argv)
 		arr8[i] = new char[vec8[i].size() + 1];
 		strcpy(arr8[i], vec8[i].c_str());
 	}
-	assembleMain(vec8.size(), arr8);
+	assembleMain(vec8.size(), arr8, pGraph);
 	free(arr8);
 	
     delete pTimer;
@@ -346,6 +353,7 @@ void parseStrideOptions(int argc, char** argv)
 		case 'r': arg >> opt::readLength; break;
         case 'i': arg >> opt::insertSize; break;
 		case 'v': opt::verbose++; break;
+		case OPT_IN_MEMORY_GRAPH: opt::bInMemoryGraph = true; break;
 		case '?': die = true; break;
 		case OPT_HELP:
 			std::cout << STRIDE_USAGE_MESSAGE;
@@ -32,7 +32,7 @@ SUBPROGRAM " Version " PACKAGE_VERSION "\n"
 
 static const char *SUBGRAPH_USAGE_MESSAGE =
 "Usage: " PACKAGE_NAME " " SUBPROGRAM " [OPTION] ... ID ASQGFILE\n"
-"Extract the subgraph around the sequence with ID from an asqg file.\n"
+"Extract the subgraph around the sequence with ID from an asqg file or a binary graph (.sgb).\n"
 "\n"
 "  -v, --verbose                        display verbose output\n"
 "      --help                           display this help and exit\n"
@@ -32,6 +32,7 @@ static char TRANSITIVE_TAG[] = "TE"; // 1 if the graph has transitive edges
 
 // Vertex tags
 static char SUBSTRING_TAG[] = "SS";
+static char SUPER_REPEAT_TAG[] = "SR"; // 1 if the read overlaps too many other reads
 
 //
 // Header Record
@@ -181,6 +182,12 @@ void VertexRecord::setSubstringTag(bool b)
     m_substringTag.set(b);
 }
 
+//
+void VertexRecord::setSuperRepeatTag(bool b)
+{
+    m_superRepeatTag.set(b);
+}
+
 //
 void VertexRecord::write(std::ostream& out)
 {
@@ -191,6 +198,8 @@ void VertexRecord::write(std::ostream& out)
 
     if(m_substringTag.isInitialized())
         fields.push_back(m_substringTag.toTagString(SUBSTRING_TAG));
+    if(m_superRepeatTag.isInitialized())
+        fields.push_back(m_superRepeatTag.toTagString(SUPER_REPEAT_TAG));
 
     writeFields(out, fields);
 }
@@ -230,6 +239,8 @@ void VertexRecord::parse(const std::string& record)
     {
         if(tokens[i].compare(0, FIELD_TAG_SIZE, SUBSTRING_TAG) == 0)
             m_substringTag.fromString(tokens[i]);
+        else if(tokens[i].compare(0, FIELD_TAG_SIZE, SUPER_REPEAT_TAG) == 0)
+            m_superRepeatTag.fromString(tokens[i]);
     }    
 }
 
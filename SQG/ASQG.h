@@ -67,10 +67,12 @@ namespace ASQG
             VertexRecord(const std::string& i, const std::string& s) : m_id(i), m_seq(s) {}
 
             void setSubstringTag(bool b);
+            void setSuperRepeatTag(bool b);
             
             const std::string& getID() const { return m_id; }
             const std::string& getSeq() const { return m_seq; }
             const SQG::IntTag& getSubstringTag() const { return m_substringTag; }
+            const SQG::IntTag& getSuperRepeatTag() const { return m_superRepeatTag; }
 
             void write(std::ostream& out);
             void parse(const std::string& record);
@@ -80,6 +82,7 @@ namespace ASQG
             std::string m_id;
             std::string m_seq;
             SQG::IntTag m_substringTag;
+            SQG::IntTag m_superRepeatTag;
     };
 
     // An edge record is just an overlap object and tag:values
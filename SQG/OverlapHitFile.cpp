@@ -0,0 +1,155 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// OverlapHitFile - Binary file of the overlaps found by
+// the overlap stage
+//
+#include <stdlib.h>
+#include "OverlapHitFile.h"
+#include "Util.h"
+
+// Append value to out as an unsigned LEB128 varint
+static inline void putVarint(std::string& out, uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        out.push_back((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+//
+bool isOverlapHits(const std::string& filename)
+{
+    size_t suffixLength = sizeof(OVERLAP_HITS_EXT) - 1;
+    return filename.length() >= suffixLength && suffix(filename, suffixLength) == OVERLAP_HITS_EXT;
+}
+
+//
+OverlapHit::OverlapHit(size_t target, const Match& match) : targetIdx(target), isRC(match.isRC()), numDiff(match.getNumDiffs())
+{
+    for(size_t i = 0; i < 2; ++i)
+    {
+        start[i] = match.coord[i].interval.start;
+        end[i] = match.coord[i].interval.end;
+    }
+}
+
+//
+Overlap OverlapHit::toOverlap(const std::string& queryID, int queryLength,
+                              const std::string& targetID, int targetLength) const
+{
+    return Overlap(queryID, start[0], end[0], queryLength,
+                   targetID, start[1], end[1], targetLength, isRC, numDiff);
+}
+
+//
+OverlapHitWriter::OverlapHitWriter(std::ostream* pWriter, bool writeHeader) : m_pWriter(pWriter)
+{
+    if(writeHeader)
+        m_pWriter->write((const char*)&OVERLAP_HITS_MAGIC, sizeof(OVERLAP_HITS_MAGIC));
+}
+
+//
+void OverlapHitWriter::write(size_t queryIdx, const OverlapHitVector& hits)
+{
+    if(hits.empty())
+        return;
+
+    // Encode the whole group first so a checkpoint never sees part of it
+    m_buffer.clear();
+    putVarint(m_buffer, queryIdx);
+    putVarint(m_buffer, hits.size());
+    for(OverlapHitVector::const_iterator iter = hits.begin(); iter != hits.end(); ++iter)
+    {
+        putVarint(m_buffer, iter->targetIdx);
+        putVarint(m_buffer, iter->isRC ? HF_REVERSE_COMPLEMENT : 0);
+        putVarint(m_buffer, iter->start[0]);
+        putVarint(m_buffer, iter->end[0]);
+        putVarint(m_buffer, iter->start[1]);
+        putVarint(m_buffer, iter->end[1]);
+        putVarint(m_buffer, iter->numDiff);
+    }
+    m_pWriter->write(m_buffer.data(), m_buffer.size());
+}
+
+//
+OverlapHitReader::OverlapHitReader(const std::string& filename) : m_filename(filename),
+                                                                  m_buffer(BUFFER_SIZE),
+                                                                  m_pos(0),
+                                                                  m_end(0)
+{
+    m_pFile = fopen(filename.c_str(), "rb");
+    if(m_pFile == NULL)
+    {
+        std::cerr << "Error: could not open " << filename << " for read\n";
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t magic = 0;
+    if(fread(&magic, sizeof(magic), 1, m_pFile) != 1 || magic != OVERLAP_HITS_MAGIC)
+    {
+        std::cerr << "Error: " << filename << " is not an overlap hit file\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+OverlapHitReader::~OverlapHitReader()
+{
+    fclose(m_pFile);
+}
+
+//
+bool OverlapHitReader::fill()
+{
+    m_pos = 0;
+    m_end = fread(&m_buffer[0], 1, m_buffer.size(), m_pFile);
+    if(m_end == 0 && ferror(m_pFile))
+    {
+        std::cerr << "Error: could not read " << m_filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+    return m_end > 0;
+}
+
+//
+uint64_t OverlapHitReader::getField()
+{
+    uint64_t value;
+    if(!getVarint(value))
+    {
+        std::cerr << "Error: " << m_filename << " is truncated\n";
+        exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+//
+bool OverlapHitReader::read(size_t& queryIdx, OverlapHitVector& hits)
+{
+    hits.clear();
+
+    // The file may only end between groups, a group cut short is an error
+    if(m_pos == m_end && !fill())
+        return false;
+
+    queryIdx = getField();
+    size_t numHits = getField();
+    hits.resize(numHits);
+    for(size_t i = 0; i < numHits; ++i)
+    {
+        OverlapHit& hit = hits[i];
+        hit.targetIdx = getField();
+        hit.isRC = (getField() & HF_REVERSE_COMPLEMENT) != 0;
+        hit.start[0] = getField();
+        hit.end[0] = getField();
+        hit.start[1] = getField();
+        hit.end[1] = getField();
+        hit.numDiff = getField();
+    }
+    return true;
+}
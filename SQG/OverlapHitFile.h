@@ -0,0 +1,120 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// OverlapHitFile - Binary file of the overlaps found by
+// the overlap stage, passed to the assembler in place of
+// text ED records. Reads are referred to by their index
+// in the reads file, which is also the order of their VT
+// records in the ASQG file, so no ids are written.
+//
+// File layout:
+//   header      OVERLAP_HITS_MAGIC, uint64_t little endian
+//   groups      the hits of one query read each
+//
+// A group is a sequence of unsigned LEB128 varints:
+//   query index, number of hits, then for each hit
+//   target index, flags, start and end of the overlap on
+//   the query, start and end on the target, number of
+//   differences. The flags hold HF_REVERSE_COMPLEMENT.
+//
+// Every value is a small coordinate or a read index so
+// most hits take 8 to 12 bytes.
+//
+#ifndef OVERLAPHITFILE_H
+#define OVERLAPHITFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Match.h"
+
+#define OVERLAP_HITS_EXT ".hits"
+
+// "FMOCHIT1"
+const uint64_t OVERLAP_HITS_MAGIC = 0x31544948434F4D46ULL;
+
+// Hit flags
+const uint64_t HF_REVERSE_COMPLEMENT = 1;
+
+// One overlap between a query read and the target read targetIdx
+struct OverlapHit
+{
+    OverlapHit() : targetIdx(0), isRC(false), numDiff(0) { start[0] = end[0] = start[1] = end[1] = 0; }
+    OverlapHit(size_t target, const Match& match);
+
+    // Build the overlap given the ids and lengths of the two reads
+    Overlap toOverlap(const std::string& queryID, int queryLength,
+                      const std::string& targetID, int targetLength) const;
+
+    size_t targetIdx;
+    int start[2];
+    int end[2];
+    bool isRC;
+    int numDiff;
+};
+typedef std::vector<OverlapHit> OverlapHitVector;
+
+// Encodes the hits of each query read onto a stream
+class OverlapHitWriter
+{
+    public:
+        // The header is written unless the stream is being appended to
+        OverlapHitWriter(std::ostream* pWriter, bool writeHeader = true);
+
+        // Write the hits of the query read as one group. Nothing is written if there are none.
+        void write(size_t queryIdx, const OverlapHitVector& hits);
+
+    private:
+        std::ostream* m_pWriter;
+        std::string m_buffer;
+};
+
+// Streams the groups back from a hit file in large blocks
+class OverlapHitReader
+{
+    public:
+        OverlapHitReader(const std::string& filename);
+        ~OverlapHitReader();
+
+        // Read the next group. Returns false at the end of the file, exits if the file is truncated.
+        bool read(size_t& queryIdx, OverlapHitVector& hits);
+
+    private:
+
+        static const size_t BUFFER_SIZE = 1 << 20;
+
+        // Refill the buffer, returns false if the file is exhausted
+        bool fill();
+
+        inline bool getVarint(uint64_t& value)
+        {
+            value = 0;
+            for(int shift = 0; shift < 64; shift += 7)
+            {
+                if(m_pos == m_end && !fill())
+                    return false;
+                uint8_t byte = m_buffer[m_pos++];
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if((byte & 0x80) == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        // Read a value in the middle of a group, where the end of the file is an error
+        uint64_t getField();
+
+        std::string m_filename;
+        FILE* m_pFile;
+        std::vector<uint8_t> m_buffer;
+        size_t m_pos;
+        size_t m_end;
+};
+
+// Returns true if the filename is a binary hit file
+bool isOverlapHits(const std::string& filename);
+
+#endif
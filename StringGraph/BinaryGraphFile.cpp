@@ -0,0 +1,281 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// BinaryGraphFile - Binary snapshot of a string graph
+//
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include "BinaryGraphFile.h"
+#include "Alphabet.h"
+
+// The four bases held by each byte of the packed codes, lowest bits first
+struct GraphBaseTable
+{
+    GraphBaseTable()
+    {
+        for(int i = 0; i < 256; ++i)
+        {
+            for(int j = 0; j < 4; ++j)
+                bases[i][j] = "ACGT"[(i >> (2 * j)) & 3];
+        }
+    }
+
+    char bases[256][4];
+};
+
+static const GraphBaseTable s_baseTable;
+
+static const size_t BASES_PER_WORD = 32;
+
+// Number of 8 byte words needed to hold n bytes
+static inline size_t toWords(size_t n)
+{
+    return (n + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+}
+
+// Pointers paired with their index in the file, sorted by address
+typedef std::pair<const void*, uint64_t> AddressIndex;
+typedef std::vector<AddressIndex> AddressIndexVector;
+
+static inline uint64_t findIndex(const AddressIndexVector& index, const void* ptr)
+{
+    AddressIndexVector::const_iterator iter = std::lower_bound(index.begin(), index.end(), AddressIndex(ptr, 0));
+    assert(iter != index.end() && iter->first == ptr);
+    return iter->second;
+}
+
+//
+bool isBinaryGraph(const std::string& filename)
+{
+    size_t suffixLength = sizeof(BINARY_GRAPH_EXT) - 1;
+    return filename.length() >= suffixLength && suffix(filename, suffixLength) == BINARY_GRAPH_EXT;
+}
+
+//
+BinaryGraphFile::BinaryGraphFile(const std::string& filename) : m_filename(filename), m_pData(NULL), m_size(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error: could not open " << filename << " for read\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_size = st.st_size;
+    if(m_size >= sizeof(BinaryGraphHeader))
+        m_pData = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(m_pData == NULL || m_pData == MAP_FAILED)
+    {
+        std::cerr << "Error: could not map " << filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_pHeader = (const BinaryGraphHeader*)m_pData;
+    if(m_pHeader->magic != BINARY_GRAPH_MAGIC || m_pHeader->version != BINARY_GRAPH_VERSION)
+    {
+        std::cerr << "Error: " << filename << " is not a binary graph file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // Find the start of each section
+    m_pVertices = (const BinaryGraphVertex*)(m_pHeader + 1);
+    m_pEdges = (const BinaryGraphEdge*)(m_pVertices + m_pHeader->numVertices);
+    m_pBases = (const uint64_t*)(m_pEdges + m_pHeader->numEdges);
+    m_pIDPool = (const char*)(m_pBases + m_pHeader->numWords);
+
+    size_t expectedSize = (m_pIDPool - (const char*)m_pData) + m_pHeader->idPoolSize;
+    if(m_size < expectedSize)
+    {
+        std::cerr << "Error: " << filename << " is truncated (" << m_size << " of " << expectedSize << " bytes)\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+BinaryGraphFile::~BinaryGraphFile()
+{
+    munmap(m_pData, m_size);
+}
+
+//
+void BinaryGraphFile::getID(size_t idx, std::string& out) const
+{
+    const BinaryGraphVertex& vertex = getVertex(idx);
+    out.assign(m_pIDPool + vertex.idOffset, vertex.idLength);
+}
+
+//
+void BinaryGraphFile::getSequence(size_t idx, std::string& out) const
+{
+    const BinaryGraphVertex& vertex = getVertex(idx);
+    size_t length = vertex.seqLength;
+    out.resize(length);
+
+    // Each sequence starts on a word so four bases are decoded per byte
+    const uint8_t* pBytes = (const uint8_t*)(m_pBases + vertex.seqWord);
+    size_t pos = 0;
+    for(; pos + 4 <= length; pos += 4)
+        memcpy(&out[pos], s_baseTable.bases[pBytes[pos / 4]], 4);
+
+    for(; pos < length; ++pos)
+        out[pos] = "ACGT"[(pBytes[pos / 4] >> (2 * (pos % 4))) & 3];
+}
+
+//
+SeqCoord BinaryGraphFile::getMatchCoord(size_t idx) const
+{
+    const BinaryGraphEdge& edge = getEdge(idx);
+    SeqCoord coord;
+    coord.interval.start = edge.matchStart;
+    coord.interval.end = edge.matchEnd;
+    coord.seqlen = edge.seqLength;
+    return coord;
+}
+
+//
+Overlap BinaryGraphFile::getOverlap(size_t startIdx, size_t idx) const
+{
+    const BinaryGraphEdge& edge = getEdge(idx);
+    std::string startID;
+    std::string endID;
+    getID(startIdx, startID);
+    getID(edge.endIdx, endID);
+
+    // The same match as Edge::getMatch
+    Match match(getMatchCoord(idx), getMatchCoord(edge.twinIdx), (edge.flags & BEF_REVERSE) != 0, 0);
+    return Overlap(startID, endID, match);
+}
+
+// Write the graph. The records are built in parallel, one vertex per iteration,
+// then each section is written with a single call.
+bool BinaryGraphFile::write(const Bigraph* pGraph, const std::string& filename)
+{
+    VertexPtrVec vertices = pGraph->getAllVertices();
+    int64_t numVertices = vertices.size();
+
+    std::vector<BinaryGraphVertex> vertexRecords(numVertices);
+    std::vector<EdgePtrVec> edgeLists(numVertices);
+    #pragma omp parallel for
+    for(int64_t i = 0; i < numVertices; ++i)
+        edgeLists[i] = vertices[i]->getEdges();
+
+    // Place the edges, sequence and id of each vertex
+    BinaryGraphHeader header;
+    memset(&header, 0, sizeof(header));
+    for(int64_t i = 0; i < numVertices; ++i)
+    {
+        const Vertex* pVertex = vertices[i];
+        BinaryGraphVertex& record = vertexRecords[i];
+        memset(&record, 0, sizeof(record));
+
+        record.idOffset = header.idPoolSize;
+        record.idLength = pVertex->getID().length();
+        header.idPoolSize += record.idLength;
+
+        record.seqWord = header.numWords;
+        record.seqLength = pVertex->getSeqLen();
+        header.numWords += (record.seqLength + BASES_PER_WORD - 1) / BASES_PER_WORD;
+
+        record.firstEdge = header.numEdges;
+        record.numEdges = edgeLists[i].size();
+        header.numEdges += record.numEdges;
+    }
+
+    // The end and twin of each edge are found by their address
+    AddressIndexVector vertexIndex(numVertices);
+    AddressIndexVector edgeIndex(header.numEdges);
+    #pragma omp parallel for
+    for(int64_t i = 0; i < numVertices; ++i)
+    {
+        vertexIndex[i] = AddressIndex(vertices[i], i);
+        for(size_t j = 0; j < edgeLists[i].size(); ++j)
+        {
+            uint64_t edgeIdx = vertexRecords[i].firstEdge + j;
+            edgeIndex[edgeIdx] = AddressIndex(edgeLists[i][j], edgeIdx);
+        }
+    }
+    std::sort(vertexIndex.begin(), vertexIndex.end());
+    std::sort(edgeIndex.begin(), edgeIndex.end());
+
+    std::vector<BinaryGraphEdge> edgeRecords(header.numEdges);
+    std::vector<uint64_t> bases(header.numWords, 0);
+    std::string idPool(header.idPoolSize, '\0');
+    #pragma omp parallel for
+    for(int64_t i = 0; i < numVertices; ++i)
+    {
+        const Vertex* pVertex = vertices[i];
+        BinaryGraphVertex& record = vertexRecords[i];
+        record.originLength[ED_SENSE] = pVertex->getOriginLength(ED_SENSE);
+        record.originLength[ED_ANTISENSE] = pVertex->getOriginLength(ED_ANTISENSE);
+        record.coverage = pVertex->getCoverage();
+        record.color = pVertex->getColor();
+        record.flags = (pVertex->isContained() ? BVF_CONTAINED : 0) | (pVertex->isSuperRepeat() ? BVF_SUPER_REPEAT : 0);
+
+        std::string id = pVertex->getID();
+        if(!id.empty())
+            memcpy(&idPool[record.idOffset], id.data(), id.length());
+
+        std::string seq = pVertex->getStr();
+        uint64_t* pWords = bases.empty() ? NULL : &bases[record.seqWord];
+        for(size_t j = 0; j < seq.length(); ++j)
+            pWords[j / BASES_PER_WORD] |= (uint64_t)(DNA_ALPHABET::getBaseRank(seq[j]) & 3) << (2 * (j % BASES_PER_WORD));
+
+        for(size_t j = 0; j < edgeLists[i].size(); ++j)
+        {
+            const Edge* pEdge = edgeLists[i][j];
+            BinaryGraphEdge& edgeRecord = edgeRecords[record.firstEdge + j];
+            memset(&edgeRecord, 0, sizeof(edgeRecord));
+            edgeRecord.endIdx = findIndex(vertexIndex, pEdge->getEnd());
+            edgeRecord.twinIdx = findIndex(edgeIndex, pEdge->getTwin());
+
+            const SeqCoord& coord = pEdge->getMatchCoord();
+            edgeRecord.matchStart = coord.interval.start;
+            edgeRecord.matchEnd = coord.interval.end;
+            edgeRecord.seqLength = coord.seqlen;
+            edgeRecord.flags = (pEdge->getDir() == ED_ANTISENSE ? BEF_ANTISENSE : 0) |
+                               (pEdge->getComp() == EC_REVERSE ? BEF_REVERSE : 0) |
+                               (pEdge->isTrusted ? BEF_TRUSTED : 0);
+            edgeRecord.color = pEdge->getColor();
+        }
+    }
+
+    header.magic = BINARY_GRAPH_MAGIC;
+    header.version = BINARY_GRAPH_VERSION;
+    header.numVertices = numVertices;
+    header.flags = (pGraph->hasContainment() ? BGF_CONTAINMENT : 0) |
+                   (pGraph->hasTransitive() ? BGF_TRANSITIVE : 0) |
+                   (pGraph->isExactMode() ? BGF_EXACT_MODE : 0);
+    header.minOverlap = pGraph->getMinOverlap();
+    header.errorRate = pGraph->getErrorRate();
+
+    std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+    out.write((const char*)&header, sizeof(header));
+    if(numVertices > 0)
+        out.write((const char*)&vertexRecords[0], numVertices * sizeof(BinaryGraphVertex));
+    if(!edgeRecords.empty())
+        out.write((const char*)&edgeRecords[0], edgeRecords.size() * sizeof(BinaryGraphEdge));
+    if(!bases.empty())
+        out.write((const char*)&bases[0], bases.size() * sizeof(uint64_t));
+
+    // Pad the id pool to a multiple of 8 bytes
+    idPool.resize(toWords(idPool.size()) * sizeof(uint64_t), '\0');
+    out.write(idPool.data(), idPool.size());
+    out.close();
+
+    if(!out)
+    {
+        std::cerr << "Error: could not write " << filename << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,151 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// BinaryGraphFile - Binary snapshot of a string graph,
+// loaded in parallel in place of an ASQG file. Vertices
+// are referred to by their index in the file, so the
+// edges need no id lookups, and the records have fixed
+// sizes so the file can be mapped into memory and read
+// without parsing.
+//
+// File layout, all values are little endian and every
+// section starts on an 8 byte boundary:
+//   header      BinaryGraphHeader
+//   vertices    numVertices BinaryGraphVertex records
+//   edges       numEdges BinaryGraphEdge records, the edges of
+//               each vertex are stored together
+//   bases       numWords uint64_t words of 2-bit codes, the
+//               sequence of each vertex starts on a new word
+//   id pool     idPoolSize characters
+//
+// Both edges of an overlap are stored, each with the index
+// of its twin, so the adjacency lists are restored as is.
+//
+#ifndef BINARYGRAPHFILE_H
+#define BINARYGRAPHFILE_H
+
+#include <stdint.h>
+#include <string>
+#include "Bigraph.h"
+
+#define BINARY_GRAPH_EXT ".sgb"
+
+// "FMOCSGB1"
+const uint64_t BINARY_GRAPH_MAGIC = 0x31424753434F4D46ULL;
+const uint64_t BINARY_GRAPH_VERSION = 1;
+
+// Header flags
+const uint64_t BGF_CONTAINMENT = 1;
+const uint64_t BGF_TRANSITIVE = 2;
+const uint64_t BGF_EXACT_MODE = 4;
+
+// Vertex flags
+const uint8_t BVF_CONTAINED = 1;
+const uint8_t BVF_SUPER_REPEAT = 2;
+
+// Edge flags
+const uint8_t BEF_ANTISENSE = 1;
+const uint8_t BEF_REVERSE = 2;
+const uint8_t BEF_TRUSTED = 4;
+
+struct BinaryGraphHeader
+{
+    uint64_t magic;
+    uint64_t version;
+    uint64_t numVertices;
+    uint64_t numEdges;
+    uint64_t numWords;
+    uint64_t idPoolSize;
+    uint64_t flags;
+    int64_t minOverlap;
+    double errorRate;
+};
+
+struct BinaryGraphVertex
+{
+    uint64_t idOffset;
+    uint64_t seqWord;
+    uint64_t seqLength;
+    uint64_t firstEdge;
+    uint64_t originLength[ED_COUNT];
+    uint32_t idLength;
+    uint32_t numEdges;
+    uint32_t coverage;
+    uint8_t color;
+    uint8_t flags;
+    uint16_t padding;
+};
+
+// An edge starting at the vertex that holds it. The match
+// coordinates are on the start vertex, the twin edge has
+// the coordinates on the end vertex.
+struct BinaryGraphEdge
+{
+    uint64_t endIdx;
+    uint64_t twinIdx;
+    int32_t matchStart;
+    int32_t matchEnd;
+    int32_t seqLength;
+    uint8_t flags;
+    uint8_t color;
+    uint16_t padding;
+};
+
+// Returns true if the filename has the binary graph extension
+bool isBinaryGraph(const std::string& filename);
+
+// Read-only view of a binary graph file mapped into memory
+class BinaryGraphFile
+{
+    public:
+        BinaryGraphFile(const std::string& filename);
+        ~BinaryGraphFile();
+
+        inline const BinaryGraphHeader& getHeader() const { return *m_pHeader; }
+        inline size_t getNumVertices() const { return m_pHeader->numVertices; }
+        inline size_t getNumEdges() const { return m_pHeader->numEdges; }
+
+        inline const BinaryGraphVertex& getVertex(size_t idx) const
+        {
+            assert(idx < getNumVertices());
+            return m_pVertices[idx];
+        }
+
+        inline const BinaryGraphEdge& getEdge(size_t idx) const
+        {
+            assert(idx < getNumEdges());
+            return m_pEdges[idx];
+        }
+
+        // Decode the id and sequence of the vertex at idx, reusing the buffers of the strings
+        void getID(size_t idx, std::string& out) const;
+        void getSequence(size_t idx, std::string& out) const;
+
+        // The 2-bit codes of the sequence of the vertex at idx, 32 bases per word with the first base in the lowest bits
+        inline const uint64_t* getSequenceWords(size_t idx) const { return m_pBases + getVertex(idx).seqWord; }
+
+        // Build the match coordinate of the edge at idx
+        SeqCoord getMatchCoord(size_t idx) const;
+
+        // Build the overlap of the edge at idx, which starts at the vertex startIdx
+        Overlap getOverlap(size_t startIdx, size_t idx) const;
+
+        // Write pGraph into filename. Returns false if the file could not be written.
+        static bool write(const Bigraph* pGraph, const std::string& filename);
+
+    private:
+
+        std::string m_filename;
+        void* m_pData;
+        size_t m_size;
+
+        const BinaryGraphHeader* m_pHeader;
+        const BinaryGraphVertex* m_pVertices;
+        const BinaryGraphEdge* m_pEdges;
+        const uint64_t* m_pBases;
+        const char* m_pIDPool;
+};
+
+#endif
@@ -0,0 +1,98 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// CGVisitors - Visitors of the compact graph core
+//
+#include <stdio.h>
+#include <assert.h>
+#include "CGVisitors.h"
+
+//
+// CGGraphStatsVisitor - Collect summary stasitics
+// about the graph
+//
+void CGGraphStatsVisitor::previsit(CompactGraph* /*pGraph*/)
+{
+    num_straight = 0;
+    num_terminal = 0;
+    num_island = 0;
+    num_monobranch = 0;
+    num_dibranch = 0;
+    num_simple = 0;
+    num_edges = 0;
+    num_vertex = 0;
+}
+
+// The counters are shared by the threads of visitP
+bool CGGraphStatsVisitor::visit(CompactGraph* pGraph, VertexIdx v)
+{
+    int s_count = 0;
+    int as_count = 0;
+    for(EdgeIdx e = pGraph->getFirstEdge(v); e < pGraph->getLastEdge(v); ++e)
+    {
+        const CompactEdge& edge = pGraph->getEdge(e);
+        if(edge.isDeleted())
+            continue;
+        if(edge.getDir() == ED_SENSE)
+            ++s_count;
+        else
+            ++as_count;
+    }
+
+    if(s_count == 0 && as_count == 0)
+        __sync_fetch_and_add(&num_island, 1);
+    else if(s_count == 0 || as_count == 0)
+        __sync_fetch_and_add(&num_terminal, 1);
+
+    if(s_count > 1 && as_count > 1)
+        __sync_fetch_and_add(&num_dibranch, 1);
+    else if(s_count > 1 || as_count > 1)
+        __sync_fetch_and_add(&num_monobranch, 1);
+
+    if(s_count == 1 || as_count == 1)
+        __sync_fetch_and_add(&num_simple, 1);
+
+    if(s_count == 1 && as_count == 1)
+        __sync_fetch_and_add(&num_straight, 1);
+
+    __sync_fetch_and_add(&num_edges, s_count + as_count);
+    __sync_fetch_and_add(&num_vertex, 1);
+    return false;
+}
+
+//
+void CGGraphStatsVisitor::postvisit(CompactGraph* /*pGraph*/)
+{
+    printf("Vertices: %d Edges: %d Islands: %d Tips: %d Monobranch: %d Dibranch: %d Simple: %d Straight: %d\n",
+    num_vertex, num_edges, num_island, num_terminal, num_monobranch, num_dibranch, num_simple, num_straight);
+}
+
+//
+// CGContainRemoveVisitor - Removes contained
+// vertices from the graph
+//
+void CGContainRemoveVisitor::previsit(CompactGraph* pGraph)
+{
+    // SGContainRemoveVisitor only deletes edges in these graphs
+    assert(pGraph->hasTransitive() || pGraph->isExactMode());
+    pGraph->setContainmentFlag(false);
+}
+
+// The vertex and its edges are tombstoned, with the twins of the edges
+bool CGContainRemoveVisitor::visit(CompactGraph* pGraph, VertexIdx v)
+{
+    if(!pGraph->isContained(v))
+        return false;
+
+    pGraph->removeVertex(v);
+    return true;
+}
+
+//
+void CGContainRemoveVisitor::postvisit(CompactGraph* pGraph)
+{
+    // The tombstones of this pass are dropped now rather than left to the next compaction
+    pGraph->compact();
+}
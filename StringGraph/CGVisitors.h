@@ -0,0 +1,44 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// CGVisitors - Visitors of the compact graph core,
+// counterparts of the SGVisitors that assemble runs
+// before the core is expanded into a Bigraph
+//
+#ifndef CGVISITORS_H
+#define CGVISITORS_H
+
+#include "CompactGraph.h"
+
+// Compile summary statistics for the graph, as SGGraphStatsVisitor
+struct CGGraphStatsVisitor
+{
+    CGGraphStatsVisitor() {}
+    void previsit(CompactGraph* pGraph);
+    bool visit(CompactGraph* pGraph, VertexIdx v);
+    void postvisit(CompactGraph*);
+
+    int num_straight;
+    int num_terminal;
+    int num_island;
+    int num_monobranch;
+    int num_dibranch;
+    int num_simple;
+    int num_edges;
+    int num_vertex;
+};
+
+// Remove contained vertices from the graph, as SGContainRemoveVisitor.
+// The edges of the graph cannot be remodelled so the graph must be
+// transitive or built in exact mode. Thread-safe.
+struct CGContainRemoveVisitor
+{
+    CGContainRemoveVisitor() {}
+    void previsit(CompactGraph* pGraph);
+    bool visit(CompactGraph* pGraph, VertexIdx v);
+    void postvisit(CompactGraph*);
+};
+
+#endif
@@ -0,0 +1,97 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// ReadContigMap - Concurrent append-only multimap from
+// read SA indices to the vertices they are placed on
+//
+#include <assert.h>
+#include "ReadContigMap.h"
+
+//
+ReadContigMap::ReadContigMap()
+{
+    m_pShards = new Shard[NUM_SHARDS];
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+        omp_init_lock(&m_pShards[i].lock);
+}
+
+//
+ReadContigMap::~ReadContigMap()
+{
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+        omp_destroy_lock(&m_pShards[i].lock);
+    delete [] m_pShards;
+}
+
+//
+void ReadContigMap::add(int64_t readIdx, Vertex* pVertex, ReadOnContig roc)
+{
+    assert(readIdx >= 0);
+    Shard& shard = getShard(readIdx);
+    omp_set_lock(&shard.lock);
+
+    uint32_t nodeIdx = shard.nodes.size();
+    assert(nodeIdx != END_OF_LIST);
+
+    Node node;
+    node.pVertex = pVertex;
+    node.next = END_OF_LIST;
+    node.roc = roc;
+    shard.nodes.push_back(node);
+
+    ListMap::iterator iter = shard.lists.find(readIdx);
+    if(iter == shard.lists.end())
+    {
+        ListEnds ends;
+        ends.head = nodeIdx;
+        ends.tail = nodeIdx;
+        shard.lists.insert(std::make_pair(readIdx, ends));
+    }
+    else
+    {
+        shard.nodes[iter->second.tail].next = nodeIdx;
+        iter->second.tail = nodeIdx;
+    }
+
+    omp_unset_lock(&shard.lock);
+}
+
+//
+void ReadContigMap::get(int64_t readIdx, ReadPlacementVector& out) const
+{
+    out.clear();
+    Shard& shard = getShard(readIdx);
+    omp_set_lock(&shard.lock);
+
+    ListMap::const_iterator iter = shard.lists.find(readIdx);
+    if(iter != shard.lists.end())
+    {
+        for(uint32_t nodeIdx = iter->second.head; nodeIdx != END_OF_LIST; nodeIdx = shard.nodes[nodeIdx].next)
+        {
+            const Node& node = shard.nodes[nodeIdx];
+            out.push_back(std::make_pair(node.pVertex, (ReadOnContig)node.roc));
+        }
+    }
+
+    omp_unset_lock(&shard.lock);
+}
+
+//
+size_t ReadContigMap::getNumReads() const
+{
+    size_t count = 0;
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+        count += m_pShards[i].lists.size();
+    return count;
+}
+
+//
+size_t ReadContigMap::getNumPlacements() const
+{
+    size_t count = 0;
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+        count += m_pShards[i].nodes.size();
+    return count;
+}
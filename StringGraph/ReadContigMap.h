@@ -0,0 +1,81 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// ReadContigMap - Concurrent append-only multimap from
+// the SA index of a read to the vertices the read was
+// placed on. Only reads that are actually placed use
+// memory, so the table stays small when the islands
+// hold a tiny fraction of a large read set.
+//
+#ifndef READCONTIGMAP_H
+#define READCONTIGMAP_H
+
+#include <stdint.h>
+#include <vector>
+#include <omp.h>
+#include "Util.h"
+#include "HashMap.h"
+#include "Bigraph.h"
+
+typedef std::pair<Vertex*, ReadOnContig> ReadPlacement;
+typedef std::vector<ReadPlacement> ReadPlacementVector;
+
+class ReadContigMap
+{
+    public:
+        ReadContigMap();
+        ~ReadContigMap();
+
+        // Record that the read with SA index readIdx lies on pVertex.
+        // Safe to call from many threads at once.
+        void add(int64_t readIdx, Vertex* pVertex, ReadOnContig roc);
+
+        // Fill out with the placements of readIdx in the order they were added
+        void get(int64_t readIdx, ReadPlacementVector& out) const;
+
+        size_t getNumReads() const;
+        size_t getNumPlacements() const;
+
+    private:
+
+        // The placements of a shard are chained into linked lists held in
+        // one vector, with the head and tail of each read's list in a hash
+        struct Node
+        {
+            Vertex* pVertex;
+            uint32_t next;
+            uint32_t roc;
+        };
+
+        struct ListEnds
+        {
+            uint32_t head;
+            uint32_t tail;
+        };
+
+        typedef SparseHashMap<int64_t, ListEnds> ListMap;
+
+        struct Shard
+        {
+            ListMap lists;
+            std::vector<Node> nodes;
+            omp_lock_t lock;
+        };
+
+        // Reads are spread over the shards so that threads
+        // placing different reads rarely wait on the same lock
+        static const size_t NUM_SHARDS = 1024;
+        static const uint32_t END_OF_LIST = 0xFFFFFFFF;
+
+        inline Shard& getShard(int64_t readIdx) const { return m_pShards[readIdx % NUM_SHARDS]; }
+
+        // Not copyable
+        ReadContigMap(const ReadContigMap&);
+        ReadContigMap& operator=(const ReadContigMap&);
+
+        Shard* m_pShards;
+};
+
+#endif
@@ -98,8 +98,8 @@ Edge* SGAlgorithms::createEdgesFromOverlap(StringGraph* pGraph, const Overlap& o
         for(size_t idx = 0; idx < 2; ++idx)
         {
             const SeqCoord& coord = o.match.coord[idx];
-            pEdges[idx] = new(pGraph->getEdgeAllocator()) Edge(pVerts[1 - idx], ED_SENSE, comp, coord,c);
-            pEdges[idx + 2] = new(pGraph->getEdgeAllocator()) Edge(pVerts[1 - idx], ED_ANTISENSE, comp, coord,c);
+            pEdges[idx] = new Edge(pVerts[1 - idx], ED_SENSE, comp, coord,c);
+            pEdges[idx + 2] = new Edge(pVerts[1 - idx], ED_ANTISENSE, comp, coord,c);
         }
         
         // Twin the edges and add them to the graph
@@ -12,6 +12,9 @@
 #include "SGAlgorithms.h"
 #include "SGVisitors.h"
 #include "../FMOC/SGACommon.h"
+#include "BinaryGraphFile.h"
+#include <sys/stat.h>
+#include <new>
 
 StringGraph* SGUtil::loadASQG(const StringVector & filenameList, const unsigned int minOverlap, bool allowContainments , size_t maxEdges ,GraphColor c)
 {
@@ -81,6 +84,7 @@ StringGraph* SGUtil::loadASQG(const StringVector & filenameList, const unsigned
 
 					ASQG::VertexRecord vertexRecord(recordLine);
 					const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
+					const SQG::IntTag& srTag = vertexRecord.getSuperRepeatTag();
 
 					Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
 					if(ssTag.isInitialized() && ssTag.get() == 1)
@@ -89,6 +93,8 @@ StringGraph* SGUtil::loadASQG(const StringVector & filenameList, const unsigned
 						pVertex->setContained(true);
 						pGraph->setContainmentFlag(true);
 					}
+					if(srTag.isInitialized() && srTag.get() == 1)
+						pVertex->setSuperRepeat(true);
 					pGraph->addVertex(pVertex);
 					break;
 				}
@@ -129,7 +135,8 @@ StringGraph* SGUtil::loadASQG(const StringVector & filenameList, const unsigned
 	return pGraph;
 }
 
-StringGraph* SGUtil::loadASQGVertex(const std::string& filename, const unsigned int minOverlap, bool allowContainments, size_t maxEdges)
+StringGraph* SGUtil::loadASQGVertex(const std::string& filename, const unsigned int minOverlap, bool allowContainments, size_t maxEdges,
+                                    VertexPtrVec* pReadVertices)
 {
 	// Initialize graph
 	StringGraph* pGraph = new StringGraph;
@@ -195,6 +202,7 @@ StringGraph* SGUtil::loadASQGVertex(const std::string& filename, const unsigned
 
 				ASQG::VertexRecord vertexRecord(recordLine);
 				const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
+				const SQG::IntTag& srTag = vertexRecord.getSuperRepeatTag();
 
 				Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
 				if(ssTag.isInitialized() && ssTag.get() == 1)
@@ -203,7 +211,11 @@ StringGraph* SGUtil::loadASQGVertex(const std::string& filename, const unsigned
 					pVertex->setContained(true);
 					pGraph->setContainmentFlag(true);
 				}
+				if(srTag.isInitialized() && srTag.get() == 1)
+					pVertex->setSuperRepeat(true);
 				pGraph->addVertex(pVertex);
+				if(pReadVertices != NULL)
+					pReadVertices->push_back(pVertex);
 				break;
 			}
 			case ASQG::RT_EDGE:
@@ -234,27 +246,54 @@ StringGraph* SGUtil::loadASQGVertex(const std::string& filename, const unsigned
 	return pGraph;
 }
 
-StringGraph* SGUtil::loadASQGEdge(std::string ASQGFileName, const unsigned int minOverlap, bool allowContainments, size_t maxEdges, StringGraph* pGraph)
+StringGraph* SGUtil::loadASQGEdge(std::string ASQGFileName, const unsigned int minOverlap, bool allowContainments, size_t maxEdges, StringGraph* pGraph,
+                                  const VertexPtrVec* pReadVertices)
 {
 	std::string edgeFilePrefix = stripFilename(ASQGFileName);
-	std::vector<std::istream*> EdgeFileVec;
 
-	//search for the edges files named with xxxx-thread??.edges.gz, if existed
-	std::stringstream ss;
-	size_t fileIdx=0;
-	ss << edgeFilePrefix << "-thread" << fileIdx << HITS_EXT << GZIP_EXT;
-	std::string edgefile = ss.str();
-	std::istream* pistream = createReader(edgefile);
-	while(pistream->peek()!=std::istream::traits_type::eof())
+	//The overlap stage writes binary hit files named xxxx-thread??.hits
+	StringVector hitFileVec;
+	struct stat buffer;
+	for(size_t fileIdx = 0; ; ++fileIdx)
 	{
-		std::cout << edgefile << std::endl;
-		EdgeFileVec.push_back(pistream);
-		//search for next edge file
-		ss.str("");
-		fileIdx++;
+		std::stringstream ss;
+		ss << edgeFilePrefix << "-thread" << fileIdx << OVERLAP_HITS_EXT;
+		if(stat(ss.str().c_str(), &buffer) != 0)
+			break;
+		std::cout << ss.str() << std::endl;
+		hitFileVec.push_back(ss.str());
+	}
+
+	if(!hitFileVec.empty())
+	{
+		if(pReadVertices == NULL)
+		{
+			std::cerr << "Error: the vertices must be loaded in read order to load " << hitFileVec.front() << "\n";
+			exit(EXIT_FAILURE);
+		}
+
+		#pragma omp parallel for
+		for(size_t i = 0; i < hitFileVec.size(); i++)
+		{
+			OverlapHitReader reader(hitFileVec[i]);
+			size_t queryIdx;
+			OverlapHitVector hits;
+			while(reader.read(queryIdx, hits))
+				addHitEdges(pGraph, *pReadVertices, queryIdx, hits, minOverlap, allowContainments, maxEdges);
+		}
+	}
+
+	//search for the text edges files named with xxxx-thread??.edges.gz of older runs, if existed
+	std::vector<std::istream*> EdgeFileVec;
+	for(size_t fileIdx = 0; hitFileVec.empty(); ++fileIdx)
+	{
+		std::stringstream ss;
 		ss << edgeFilePrefix << "-thread" << fileIdx << HITS_EXT << GZIP_EXT;
-		edgefile = ss.str();
-		pistream = createReader(edgefile);		
+		std::string edgefile = ss.str();
+		if(stat(edgefile.c_str(), &buffer) != 0)
+			break;
+		std::cout << edgefile << std::endl;
+		EdgeFileVec.push_back(createReader(edgefile));
 	}
 
 	int line = 0;
@@ -294,6 +333,23 @@ StringGraph* SGUtil::loadASQGEdge(std::string ASQGFileName, const unsigned int m
 	return pGraph;
 }
 
+void SGUtil::addHitEdges(StringGraph* pGraph, const VertexPtrVec& readVertices, size_t queryIdx, const OverlapHitVector& hits,
+                         const unsigned int minOverlap, bool allowContainments, size_t maxEdges)
+{
+	assert(queryIdx < readVertices.size());
+	const Vertex* pQuery = readVertices[queryIdx];
+	for(OverlapHitVector::const_iterator iter = hits.begin(); iter != hits.end(); ++iter)
+	{
+		assert(iter->targetIdx < readVertices.size());
+		const Vertex* pTarget = readVertices[iter->targetIdx];
+		Overlap ovr = iter->toOverlap(pQuery->getID(), pQuery->getSeqLen(), pTarget->getID(), pTarget->getSeqLen());
+
+		// Add the edge to the graph
+		if(ovr.match.getMinOverlapLength() >= (int)minOverlap)
+			SGAlgorithms::createEdgesFromOverlap(pGraph, ovr, allowContainments, maxEdges);
+	}
+}
+
 StringGraph*  SGUtil::loadASQG_Parallel(const StringVector & filenameList, const unsigned int minOverlap, 
 bool allowContainments , size_t maxEdges ,GraphColor c)
 {
@@ -361,6 +417,7 @@ bool allowContainments , size_t maxEdges ,GraphColor c)
 					// progress the stage if we are done the header
 					ASQG::VertexRecord vertexRecord(decodeFiles[i][j]);
 					const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
+					const SQG::IntTag& srTag = vertexRecord.getSuperRepeatTag();
 
 					Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
 					if(ssTag.isInitialized() && ssTag.get() == 1)
@@ -369,6 +426,8 @@ bool allowContainments , size_t maxEdges ,GraphColor c)
 						pVertex->setContained(true);
 						pGraph->setContainmentFlag(true);
 					}
+					if(srTag.isInitialized() && srTag.get() == 1)
+						pVertex->setSuperRepeat(true);
 					pGraph->addVertex(pVertex);
 					break;
 				}
@@ -474,6 +533,9 @@ StringGraph* SGUtil::loadASQG_EDGE_Parallel(const StringVector & filenameList, c
 
 StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int minOverlap, bool allowContainments, size_t maxEdges)
 {
+	if(isBinaryGraph(filename))
+		return loadBinaryGraph(filename, minOverlap);
+
 	// Initialize graph
 	StringGraph* pGraph = new StringGraph;
 
@@ -540,6 +602,7 @@ StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int mi
 
 				ASQG::VertexRecord vertexRecord(recordLine);
 				const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
+				const SQG::IntTag& srTag = vertexRecord.getSuperRepeatTag();
 
 				Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
 				if(ssTag.isInitialized() && ssTag.get() == 1)
@@ -548,6 +611,8 @@ StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int mi
 					pVertex->setContained(true);
 					pGraph->setContainmentFlag(true);
 				}
+				if(srTag.isInitialized() && srTag.get() == 1)
+					pVertex->setSuperRepeat(true);
 				pGraph->addVertex(pVertex);
 				break;
 			}
@@ -594,8 +659,147 @@ StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int mi
 	return pGraph;
 }
 
+// Load a binary graph snapshot, see BinaryGraphFile.h for the layout
+StringGraph* SGUtil::loadBinaryGraph(const std::string& filename, const unsigned int minOverlap)
+{
+	BinaryGraphFile file(filename);
+	const BinaryGraphHeader& header = file.getHeader();
+	int64_t numVertices = file.getNumVertices();
+
+	StringGraph* pGraph = new StringGraph;
+	pGraph->setMinOverlap(header.minOverlap);
+	pGraph->setErrorRate(header.errorRate);
+	pGraph->setContainmentFlag((header.flags & BGF_CONTAINMENT) != 0);
+	pGraph->setTransitiveFlag((header.flags & BGF_TRANSITIVE) != 0);
+	pGraph->setExactMode((header.flags & BGF_EXACT_MODE) != 0);
+
+	// The vertex pool is not thread-safe so the memory of the vertices is taken
+	// from it first, then the vertices are decoded and constructed in parallel
+	std::vector<void*> vertexMemory(numVertices);
+	for(int64_t i = 0; i < numVertices; ++i)
+		vertexMemory[i] = pGraph->getVertexAllocator()->alloc();
+
+	VertexPtrVec vertices(numVertices);
+	#pragma omp parallel
+	{
+		std::string id;
+		std::string seq;
+		#pragma omp for
+		for(int64_t i = 0; i < numVertices; ++i)
+		{
+			const BinaryGraphVertex& record = file.getVertex(i);
+			file.getID(i, id);
+			file.getSequence(i, seq);
+
+			Vertex* pVertex = ::new(vertexMemory[i]) Vertex(id, seq);
+			pVertex->setContained((record.flags & BVF_CONTAINED) != 0);
+			pVertex->setSuperRepeat((record.flags & BVF_SUPER_REPEAT) != 0);
+			pVertex->setColor((GraphColor)record.color);
+			pVertex->setCoverage(record.coverage);
+			pVertex->setOriginLength(record.originLength[ED_SENSE], ED_SENSE);
+			pVertex->setOriginLength(record.originLength[ED_ANTISENSE], ED_ANTISENSE);
+			vertices[i] = pVertex;
+		}
+	}
+
+	for(int64_t i = 0; i < numVertices; ++i)
+		pGraph->addVertex(vertices[i]);
+
+	// Create the edges, an edge and its twin are dropped together as they have the same overlap
+	EdgePtrVec edges(file.getNumEdges(), NULL);
+	#pragma omp parallel for
+	for(int64_t i = 0; i < (int64_t)edges.size(); ++i)
+	{
+		const BinaryGraphEdge& record = file.getEdge(i);
+		SeqCoord coord = file.getMatchCoord(i);
+		if(std::min(coord.length(), file.getMatchCoord(record.twinIdx).length()) < (int)minOverlap)
+			continue;
+
+		EdgeDir dir = (record.flags & BEF_ANTISENSE) ? ED_ANTISENSE : ED_SENSE;
+		EdgeComp comp = (record.flags & BEF_REVERSE) ? EC_REVERSE : EC_SAME;
+		Edge* pEdge = new Edge(vertices[record.endIdx], dir, comp, coord, (GraphColor)record.color);
+		pEdge->isTrusted = (record.flags & BEF_TRUSTED) != 0;
+		edges[i] = pEdge;
+	}
+
+	// Twin the edges and fill the adjacency lists, each list is filled by one thread
+	#pragma omp parallel for
+	for(int64_t i = 0; i < numVertices; ++i)
+	{
+		const BinaryGraphVertex& record = file.getVertex(i);
+		for(uint64_t j = record.firstEdge; j < record.firstEdge + record.numEdges; ++j)
+		{
+			if(edges[j] == NULL)
+				continue;
+			edges[j]->setTwin(edges[file.getEdge(j).twinIdx]);
+			pGraph->addEdge(vertices[i], edges[j]);
+		}
+	}
+	return pGraph;
+}
+
+// The records of the snapshot already have the layout of the compact graph,
+// the vertices are copied in order and the edges in parallel
+CompactGraph* SGUtil::loadCompactGraph(const std::string& filename, const unsigned int minOverlap)
+{
+	BinaryGraphFile file(filename);
+	const BinaryGraphHeader& header = file.getHeader();
+	int64_t numVertices = file.getNumVertices();
+	int64_t numEdges = file.getNumEdges();
+
+	CompactGraph* pGraph = new CompactGraph;
+	pGraph->setMinOverlap(header.minOverlap);
+	pGraph->setErrorRate(header.errorRate);
+	pGraph->setContainmentFlag((header.flags & BGF_CONTAINMENT) != 0);
+	pGraph->setTransitiveFlag((header.flags & BGF_TRANSITIVE) != 0);
+	pGraph->setExactMode((header.flags & BGF_EXACT_MODE) != 0);
+
+	std::string id;
+	std::vector<uint32_t> degrees(numVertices);
+	for(int64_t i = 0; i < numVertices; ++i)
+	{
+		const BinaryGraphVertex& record = file.getVertex(i);
+		file.getID(i, id);
+		VertexIdx v = pGraph->addVertex(id, file.getSequenceWords(i), record.seqLength);
+		pGraph->setContained(v, (record.flags & BVF_CONTAINED) != 0);
+		pGraph->setSuperRepeat(v, (record.flags & BVF_SUPER_REPEAT) != 0);
+		pGraph->setColor(v, (GraphColor)record.color);
+		pGraph->setCoverage(v, record.coverage);
+		pGraph->setOriginLength(v, record.originLength[ED_SENSE], ED_SENSE);
+		pGraph->setOriginLength(v, record.originLength[ED_ANTISENSE], ED_ANTISENSE);
+		degrees[i] = record.numEdges;
+	}
+	pGraph->setDegrees(degrees);
+
+	#pragma omp parallel for
+	for(int64_t i = 0; i < numEdges; ++i)
+	{
+		const BinaryGraphEdge& record = file.getEdge(i);
+		CompactEdge& edge = pGraph->getEdge(i);
+		edge.end = record.endIdx;
+		edge.twin = record.twinIdx;
+		edge.matchStart = record.matchStart;
+		edge.matchEnd = record.matchEnd;
+		edge.flags = ((record.flags & BEF_ANTISENSE) ? CEF_ANTISENSE : 0) |
+		             ((record.flags & BEF_REVERSE) ? CEF_REVERSE : 0) |
+		             ((record.flags & BEF_TRUSTED) ? CEF_TRUSTED : 0);
+		edge.color = record.color;
+	}
+
+	// An edge and its twin are dropped together as they have the same overlap
+	#pragma omp parallel for
+	for(int64_t i = 0; i < numEdges; ++i)
+	{
+		const CompactEdge& edge = pGraph->getEdge(i);
+		if(std::min(edge.getMatchLength(), pGraph->getEdge(edge.twin).getMatchLength()) < (int)minOverlap)
+			pGraph->removeEdge(i);
+	}
+	pGraph->compact();
+	return pGraph;
+}
+
 // Load a graph (with no edges) from a fasta file
-StringGraph* SGUtil::loadFASTA(const std::string& filename)
+StringGraph* SGUtil::loadFASTA(const std::string& filename, VertexPtrVec* pReadVertices)
 {
 	StringGraph* pGraph = new StringGraph;
 	SeqReader reader(filename);
@@ -605,6 +809,8 @@ StringGraph* SGUtil::loadFASTA(const std::string& filename)
 	{
 		Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(record.id, record.seq.toString());
 		pGraph->addVertex(pVertex);
+		if(pReadVertices != NULL)
+			pReadVertices->push_back(pVertex);
 	}
 	return pGraph;
 }
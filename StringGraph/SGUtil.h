@@ -12,6 +12,8 @@
 
 #include "Bigraph.h"
 #include "ASQG.h"
+#include "OverlapHitFile.h"
+#include "CompactGraph.h"
 
 // typedefs
 typedef Bigraph StringGraph;
@@ -21,20 +23,38 @@ namespace SGUtil
 	// Main string graph loading function
 	// The allowContainments flag forces the string graph to retain identical vertices
 	// Vertices that are substrings of other vertices (SS flag = 1) are never kept
+	// A binary graph snapshot is loaded as is, apart from the minOverlap filter
 	StringGraph* loadASQG(const std::string& filename, const unsigned int minOverlap, bool allowContainments = false, size_t maxEdges = -1);
 	StringGraph* loadASQG(const StringVector & filenameList, const unsigned int minOverlap, bool allowContainments = false, size_t maxEdges = -1,GraphColor c =GC_WHITE);
 
 	//Parallel loading asqg by YTH
-	StringGraph* loadASQGVertex(const std::string& filename, const unsigned int minOverlap, bool allowContainments = false, size_t maxEdges=-1);
-	StringGraph* loadASQGEdge(std::string ASQGFileName, const unsigned int minOverlap, bool allowContainments, size_t maxEdges, StringGraph* pGraph);
+	//If pReadVertices is given it is filled with the vertices in the order of their VT records,
+	//which is the read index used by the binary hit files of the overlap stage
+	StringGraph* loadASQGVertex(const std::string& filename, const unsigned int minOverlap, bool allowContainments = false, size_t maxEdges=-1,
+	                            VertexPtrVec* pReadVertices = NULL);
+	StringGraph* loadASQGEdge(std::string ASQGFileName, const unsigned int minOverlap, bool allowContainments, size_t maxEdges, StringGraph* pGraph,
+	                          const VertexPtrVec* pReadVertices = NULL);
+
+	//Add the binary hits of the read queryIdx to the graph. Thread-safe as long as no vertex is added concurrently.
+	void addHitEdges(StringGraph* pGraph, const VertexPtrVec& readVertices, size_t queryIdx, const OverlapHitVector& hits,
+	                 const unsigned int minOverlap, bool allowContainments, size_t maxEdges);
 
 	StringGraph* loadASQG_Parallel(const StringVector & filenameList, const unsigned int minOverlap, bool allowContainments = false, size_t maxEdges = -1,GraphColor c =GC_WHITE);
 	StringGraph* loadASQG_EDGE_Parallel(const StringVector & filenameList, const unsigned int minOverlap, bool allowContainments = false, size_t maxEdges = -1,GraphColor c =GC_WHITE , StringGraph* pGraph=NULL);
 
 
+	// Load a binary graph snapshot (see BinaryGraphFile.h). The vertices and edges are decoded
+	// in parallel. Edges with an overlap shorter than minOverlap are dropped.
+	StringGraph* loadBinaryGraph(const std::string& filename, const unsigned int minOverlap = 0);
+
+	// Load a binary graph snapshot into the compact graph core, dropping the edges
+	// with an overlap shorter than minOverlap. Use CompactGraph::releaseToBigraph for the string graph.
+	CompactGraph* loadCompactGraph(const std::string& filename, const unsigned int minOverlap = 0);
+
 	// Load a string graph from a fasta file.
 	// Returns a graph where each sequence in the fasta is a vertex but there are no edges in the graph.
-	StringGraph* loadFASTA(const std::string& filename);
+	// If pReadVertices is given it is filled with the vertices in the order of the reads.
+	StringGraph* loadFASTA(const std::string& filename, VertexPtrVec* pReadVertices = NULL);
 
 };
 #endif
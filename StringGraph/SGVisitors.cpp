@@ -1403,8 +1403,8 @@ bool SGIslandCollectVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 				size_t KmerFreq = BWTAlgorithms::countSequenceOccurrences( seed, m_indices.pBWT );
 				if( KmerFreq < m_repeatKmerCutoff )
 				{
-					pVSuffixFwdID.addReadIDAndContigID(seed, m_tslv, pVertex, SenseFwd);
-					pVSuffixRvcID.addReadIDAndContigID(reverseComplement(seed), m_tslv, pVertex, SenseRvc);
+					pVSuffixFwdID.addReadIDAndContigID(seed, m_pReadContigs, pVertex, SenseFwd);
+					pVSuffixRvcID.addReadIDAndContigID(reverseComplement(seed), m_pReadContigs, pVertex, SenseRvc);
 				}
             }
 
@@ -1417,8 +1417,8 @@ bool SGIslandCollectVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 				size_t KmerFreq = BWTAlgorithms::countSequenceOccurrences( seed, m_indices.pBWT );
 				if( KmerFreq < m_repeatKmerCutoff )
 				{
-					pVPrefixFwdID.addReadIDAndContigID(seed, m_tslv, pVertex, AntisenseFwd);
-					pVPrefixRvcID.addReadIDAndContigID(reverseComplement(seed), m_tslv, pVertex, AntisenseRvc);
+					pVPrefixFwdID.addReadIDAndContigID(seed, m_pReadContigs, pVertex, AntisenseFwd);
+					pVPrefixRvcID.addReadIDAndContigID(reverseComplement(seed), m_pReadContigs, pVertex, AntisenseRvc);
 				}
             }
         }
@@ -1434,7 +1434,8 @@ bool SGIslandCollectVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 }
 void SGIslandCollectVisitor::postvisit(StringGraph* /*pGraph*/)
 {
-	std::cout << "IslandCollect: Collect " << m_islandcount << " islands/tips for FM-index walk\n\n ";
+	std::cout << "IslandCollect: Collect " << m_islandcount << " islands/tips for FM-index walk\n";
+	std::cout << "IslandCollect: " << m_pReadContigs->getNumReads() << " reads placed at " << m_pReadContigs->getNumPlacements() << " island/tip ends\n\n ";
 }
 
 void SGJoinIslandVisitor::previsit(StringGraph* /*pGraph*/)
@@ -1462,16 +1463,17 @@ int64_t SGJoinIslandVisitor::getAnotherID(int64_t idx)
 // return a hashmap pWIDs storing pWs with PE support
 void SGJoinIslandVisitor::findNeighborWithPESupport(Vertex* pV, size_t islandDir, SparseHashMap<VertexID, size_t*, StringHasher>& pWIDs)
 {
+	ReadPlacementVector currentList;
 	for(size_t i=0; i<pV->pVReadIDs[islandDir].size(); i++)
 	{
 		//convert the read ID mapped on pV into PEID of the other end
 		int64_t PEID=getAnotherID(pV->pVReadIDs[islandDir][i]);
 		//retrieve the vertices pWs containing PEID into currentList 
-		ThreadSafeList<std::pair<Vertex*, ReadOnContig> >  currentList= m_tslv->at(PEID);
+		m_pReadContigs->get(PEID, currentList);
 		// std::cout << currentList.size() << "\n";
 		
 		//compute the PE mapping frequency for each pW in currentList
-		for(std::list<std::pair<Vertex*, ReadOnContig> >::iterator slit=currentList.begin(); slit!=currentList.end(); slit++)
+		for(ReadPlacementVector::iterator slit=currentList.begin(); slit!=currentList.end(); slit++)
 		{
 			Vertex* pW=slit->first;
 			ReadOnContig roc=slit->second;
@@ -1767,7 +1769,7 @@ void NameSet::addSecondReadIDs(std::string seed)
 	}
 }
 
-void NameSet::addReadIDAndContigID(std::string seed, ThreadSafeListVector* tslv, Vertex* pVertex, ReadOnContig roc)
+void NameSet::addReadIDAndContigID(std::string seed, ReadContigMap* pReadContigs, Vertex* pVertex, ReadOnContig roc)
 {
 	BWTInterval interval = BWTAlgorithms::findInterval(pBWT, seed);
 	
@@ -1781,9 +1783,7 @@ void NameSet::addReadIDAndContigID(std::string seed, ThreadSafeListVector* tslv,
 			m_SAindicesSet1.insert( SAindex);
 			
 			//Also add this pVertex into list of read SAindex
-			tslv->at(SAindex).setLock();
-			tslv->at(SAindex).push_back( std::make_pair(pVertex,roc) );
-			tslv->at(SAindex).releaseLock();
+			pReadContigs->add(SAindex, pVertex, roc);
 		}
 	}
 }
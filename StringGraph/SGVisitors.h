@@ -13,15 +13,12 @@
 
 #include "BWTIndexSet.h"
 #include "BWTAlgorithms.h"
+#include "ReadContigMap.h"
 
 #ifndef SGVISITORS_H
 #define SGVISITORS_H
 
 
-//a hashtable rapper for query and conversion of PE read IDs
-//linked lists of contig IDs mapped by this read
-typedef std::vector<ThreadSafeList<std::pair<Vertex*, ReadOnContig> > > ThreadSafeListVector;
-
 class NameSet
 {
 public:
@@ -34,7 +31,7 @@ public:
 	//Direct SA index implementation by YTH
 	void addFirstReadIDs(std::string seed);
 	void addSecondReadIDs(std::string seed);
-	void addReadIDAndContigID(std::string seed, ThreadSafeListVector* tslv, Vertex* pVertex, ReadOnContig roc);
+	void addReadIDAndContigID(std::string seed, ReadContigMap* pReadContigs, Vertex* pVertex, ReadOnContig roc);
 	std::vector<int64_t> getReadIDs(); 
 	void getAnotherReadIDs(std::vector<int64_t>& anotherIDs);
 	bool exist (int64_t idx);
@@ -411,14 +408,14 @@ struct SGRemoveEdgeByPEVisitor
 //Store PE read IDs into NameSet hashtable
 struct SGIslandCollectVisitor
 {
-    SGIslandCollectVisitor(ThreadSafeListVector* tslv, BWTIndexSet indices, size_t insertSize, size_t kmerSize, size_t islandSize)
-	:m_tslv(tslv), m_indices(indices),m_insertSize(insertSize),m_kmerSize(kmerSize),m_minIslandSize(islandSize){}
+    SGIslandCollectVisitor(ReadContigMap* pReadContigs, BWTIndexSet indices, size_t insertSize, size_t kmerSize, size_t islandSize)
+	:m_pReadContigs(pReadContigs), m_indices(indices),m_insertSize(insertSize),m_kmerSize(kmerSize),m_minIslandSize(islandSize){}
 
 	void previsit(StringGraph* pGraph);
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph* pGraph);
 
-	ThreadSafeListVector* m_tslv;
+	ReadContigMap* m_pReadContigs;
 	BWTIndexSet m_indices;
 
     size_t m_insertSize;
@@ -434,11 +431,11 @@ struct SGIslandCollectVisitor
 //SAI walk is revised to walk through high-error gaps
 struct SGJoinIslandVisitor
 {
-    SGJoinIslandVisitor(size_t SAISearchDepth, size_t SAISearchLeaves, size_t kmer, size_t islandSize, ThreadSafeListVector* tslv, BWTIndexSet indices,
+    SGJoinIslandVisitor(size_t SAISearchDepth, size_t SAISearchLeaves, size_t kmer, size_t islandSize, ReadContigMap* pReadContigs, BWTIndexSet indices,
             size_t minPEcount=5)
 	:m_SAISearchDepth(SAISearchDepth),m_SAISearchLeaves(SAISearchLeaves),
 	m_kmer(kmer),m_minIslandSize(islandSize), 
-	m_tslv(tslv), m_indices(indices),
+	m_pReadContigs(pReadContigs), m_indices(indices),
 	m_minPEcount(minPEcount)
 	{
 		m_numOfIterations=2;
@@ -457,7 +454,7 @@ struct SGJoinIslandVisitor
     size_t m_kmer;	
 	size_t m_minIslandSize;
 
-	ThreadSafeListVector* m_tslv;
+	ReadContigMap* m_pReadContigs;
 	BWTIndexSet m_indices;
 
 	size_t m_islandcount;
@@ -14,6 +14,8 @@
 #include "BWTWriterBinary.h"
 #include "BWTWriterAscii.h"
 #include "SAWriter.h"
+#include "RLBWT.h"
+#include "PackedReadTable.h"
 
 /*** ropebwt2 headers ROPEBWT2_VERSION r187 ***/
 #include <zlib.h>
@@ -172,17 +174,33 @@ void BWTCA::runRopebwt2(const std::string& input_filename, const std::string& bw
 	liftrlimit();
 	if (mr == 0) mr = mr_init(max_nodes, block_len, so);
 	if (thr_min > 0) mr_thr_min(mr, thr_min);
-	fp = gzopen( input_filename.c_str(), "rb");
-	ks = kseq_init(fp);
+
+	// Packed read files are decoded by SeqReader, other files are parsed by kseq
+	SeqReader* pPackedReader = NULL;
+	SeqRecord packedRecord;
+	std::string packedSeq;
+	if (isPackedReads(input_filename)) {
+		pPackedReader = new SeqReader(input_filename, SRF_NO_VALIDATION);
+		fp = 0; ks = 0;
+	} else {
+		fp = gzopen( input_filename.c_str(), "rb");
+		ks = kseq_init(fp);
+	}
 	ct = cputime(); rt = realtime();
 
 	for (;;) {
 		int l;
 		uint8_t *s;
-		if (kseq_read(ks) < 0) break; // read fasta/fastq
-		
-		l = ks->seq.l;
-		s = (uint8_t*)ks->seq.s;
+		if (pPackedReader) {
+			if (!pPackedReader->get(packedRecord)) break;
+			packedSeq = packedRecord.seq.toString();
+			l = packedSeq.size();
+			s = (uint8_t*)&packedSeq[0];
+		} else {
+			if (kseq_read(ks) < 0) break; // read fasta/fastq
+			l = ks->seq.l;
+			s = (uint8_t*)ks->seq.s;
+		}
 
 		// change encoding according to seq_nt6_table
 		for (i = 0; i < l; ++i) 
@@ -195,7 +213,7 @@ void BWTCA::runRopebwt2(const std::string& input_filename, const std::string& bw
 			}
 		
 		//push into buffer, always process the forward strand
-		if (m) kputsn((char*)ks->seq.s, ks->seq.l + 1, &buf);
+		if (m) kputsn((char*)s, l + 1, &buf); // including the terminating null
 		else mr_insert1(mr, s);
 
 		//sort if buffer is full
@@ -219,8 +237,12 @@ void BWTCA::runRopebwt2(const std::string& input_filename, const std::string& bw
     int64_t num_symbols = (long)c[0]+(long)c[1]+(long)c[2]+(long)c[3]+(long)c[4]+(long)c[5];
 
 	free(buf.s);
-	kseq_destroy(ks);
-	gzclose(fp);
+	if (pPackedReader) {
+		delete pPackedReader;
+	} else {
+		kseq_destroy(ks);
+		gzclose(fp);
+	}
 	
 	/*** output BWT char to BWTWriter ***/
     BWTWriterBinary* out_bwt = new BWTWriterBinary(bwt_out_name);
@@ -246,3 +268,68 @@ void BWTCA::runRopebwt2(const std::string& input_filename, const std::string& bw
     delete out_bwt;
 }
 
+RLBWT* BWTCA::runRopebwt2(const PackedReadTable* pRT, int thr_min, bool do_reverse, int sampleRate)
+{
+	int64_t m = (int64_t)(.97 * 10 * 1024 * 1024 * 1024) + 1;
+	int i, flag = FLAG_FOR | FLAG_REV | FLAG_THR;
+	kstring_t buf = { 0, 0, 0 };
+	double ct = cputime(), rt = realtime();
+
+	mrope_t *mr = mr_init(ROPE_DEF_MAX_NODES, ROPE_DEF_BLOCK_LEN, MR_SO_IO);
+	if (thr_min > 0) mr_thr_min(mr, thr_min);
+
+	for (size_t idx = 0; idx < pRT->getCount(); ++idx) {
+		std::string seq = pRT->getSequence(idx);
+		int l = seq.size();
+		uint8_t *s = (uint8_t*)&seq[0];
+
+		// change encoding according to seq_nt6_table, same as the file based version
+		for (i = 0; i < l; ++i)
+			s[i] = s[i] < 128? seq_nt6_table[s[i]] : 5;
+
+		if(!do_reverse)
+			for (i = 0; i < l>>1; ++i) { // reverse
+				int tmp = s[l-1-i];
+				s[l-1-i] = s[i]; s[i] = tmp;
+			}
+
+		// push into buffer including the terminating null, which encodes the sentinel
+		kputsn(seq.c_str(), l + 1, &buf);
+
+		//sort if buffer is full
+		if ((int64_t) buf.l >= m) {
+			mr_insert_multi(mr, buf.l, (uint8_t*)buf.s, flag&FLAG_THR);
+			buf.l = 0;
+		}
+	}
+
+	if (buf.l)
+		mr_insert_multi(mr, buf.l, (uint8_t*)buf.s, flag&FLAG_THR);
+	free(buf.s);
+
+	int64_t c[6];
+	fprintf(stderr, "[%s] constructed FM-index in memory in %.3f sec, %.3f CPU sec\n", __func__, realtime() - rt, cputime() - ct);
+	mr_get_c(mr, c);
+
+	/*** copy the BWT runs into the RLBWT ***/
+	RLBWT* pBWT = new RLBWT(c[0], sampleRate);
+
+	mritr_t itr;
+	const uint8_t *block;
+
+	mr_itr_first(mr, &itr, 1);
+	while ((block = mr_itr_next_block(&itr)) != 0) {
+		const uint8_t *q = block + 2, *end = block + 2 + *rle_nptr(block);
+		while (q < end) {
+			int c = 0;
+			int64_t j, l;
+			rle_dec1(q, c, l);
+			for (j = 0; j < l; ++j)
+				pBWT->append("$ACGTN"[c]);
+		}
+	}
+	mr_destroy(mr);
+
+	pBWT->initializeFMIndex();
+	return pBWT;
+}
@@ -12,6 +12,9 @@
 
 #include <string>
 
+class RLBWT;
+class PackedReadTable;
+
 namespace BWTCA
 {
     void runRopebwt(const std::string& input_filename, const std::string& bwt_out_name,
@@ -20,6 +23,10 @@ namespace BWTCA
 	void runRopebwt2(const std::string& input_filename, const std::string& bwt_out_name,
                     int thr_min, bool do_reverse);
 
+	// Construct the BWT of the reads in pRT in memory using ropebwt2.
+	// The caller is responsible for freeing the returned BWT.
+	RLBWT* runRopebwt2(const PackedReadTable* pRT, int thr_min, bool do_reverse, int sampleRate);
+
 };
 
 #endif
@@ -8,6 +8,7 @@
 //
 #include "RLBWT.h"
 #include "Timer.h"
+#include "NUMA.h"
 #include "BWTReader.h"
 #include "BWTWriter.h"
 #include "BWTReader.h"
@@ -82,6 +83,15 @@ RLBWT::RLBWT(const SuffixArray* pSA, const ReadTable* pRT)
     initializeFMIndex();
 }
 
+// Construct an empty BWT to be filled in by append()
+RLBWT::RLBWT(size_t numStrings, int sampleRate) : m_numStrings(numStrings),
+                                                  m_numSymbols(0),
+                                                  m_largeSampleRate(DEFAULT_SAMPLE_RATE_LARGE),
+                                                  m_smallSampleRate(sampleRate)
+{
+
+}
+
 //
 void RLBWT::append(char b)
 {
@@ -274,6 +284,29 @@ void RLBWT::print() const
     std::cout << "B: " << bwt << "\n";
 }
 
+//
+size_t RLBWT::getMemoryUsage() const
+{
+    return m_smallMarkers.capacity() * sizeof(SmallMarker) +
+           m_largeMarkers.capacity() * sizeof(LargeMarker) +
+           m_rlString.capacity() * sizeof(RLUnit);
+}
+
+//
+void RLBWT::interleaveMemory() const
+{
+    if(!NUMA::interleave(m_rlString) || !NUMA::interleave(m_smallMarkers) || !NUMA::interleave(m_largeMarkers))
+        std::cerr << "Warning: could not interleave the BWT over the NUMA nodes\n";
+}
+
+//
+void RLBWT::printHugePageInfo(const std::string& name) const
+{
+    HugePages::printInfo(name + " runs", m_rlString);
+    HugePages::printInfo(name + " small markers", m_smallMarkers);
+    HugePages::printInfo(name + " large markers", m_largeMarkers);
+}
+
 // Print information about the BWT
 void RLBWT::printInfo() const
 {
@@ -33,6 +33,10 @@ class RLBWT
         RLBWT(const std::string& filename, int sampleRate = DEFAULT_SAMPLE_RATE_SMALL);
         RLBWT(const SuffixArray* pSA, const ReadTable* pRT);
 
+        // Construct an empty BWT for numStrings strings. The symbols are added
+        // with append() and initializeFMIndex() must be called afterwards.
+        RLBWT(size_t numStrings, int sampleRate);
+
         //    
         void initializeFMIndex();
 
@@ -249,6 +253,15 @@ class RLBWT
             return RANK_ALPHABET[ci - 1];
         }
 
+        // Bytes used by the runs and the markers
+        size_t getMemoryUsage() const;
+
+        // Spread the runs and the markers over the nodes of a NUMA machine
+        void interleaveMemory() const;
+
+        // Print how much of the runs and the markers the kernel backed with huge pages
+        void printHugePageInfo(const std::string& name) const;
+
         // Print the size of the BWT
         void printInfo() const;
         void print() const;
@@ -12,6 +12,7 @@
 #include "Util.h"
 #include "STCommon.h"
 #include "Occurrence.h"
+#include "HugePageAllocator.h"
 
 const uint16_t SA_FILE_MAGIC = 0xCACA;
 
@@ -43,7 +44,7 @@ class SAReader
         // Read the file into a vector of unsigned ints storing
         // the read indices. This is a more compact representation
         // than storing the full SAElems but only works up to 2**32 values
-        void readElems(std::vector<uint32_t>& outVector);
+        void readElems(std::vector<uint32_t, HugePageAllocator<uint32_t> >& outVector);
 
         // Read a single element
         SAElem readElem();
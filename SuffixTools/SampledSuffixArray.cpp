@@ -11,6 +11,7 @@
 //
 #include "SampledSuffixArray.h"
 #include "SAReader.h"
+#include "NUMA.h"
 #include "SAWriter.h"
 #include "config.h"
 
@@ -303,6 +304,19 @@ void SampledSuffixArray::readSAI(std::string filename)
 	m_num_strings = num_strings;
 }
 
+//
+void SampledSuffixArray::interleaveMemory() const
+{
+    if(!NUMA::interleave(m_saLexoIndex) || !NUMA::interleave(m_saSamples))
+        std::cerr << "Warning: could not interleave the suffix array over the NUMA nodes\n";
+}
+
+//
+void SampledSuffixArray::printHugePageInfo(const std::string& name) const
+{
+    HugePages::printInfo(name + " lexicographic index", m_saLexoIndex);
+}
+
 // Print memory usage information
 void SampledSuffixArray::printInfo() const
 {
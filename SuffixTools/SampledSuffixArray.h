@@ -17,6 +17,7 @@
 #include "ReadInfoTable.h"
 
 typedef uint32_t SSA_INT_TYPE;
+typedef std::vector<SSA_INT_TYPE, HugePageAllocator<SSA_INT_TYPE> > SSALexoVector;
 
 enum SSAFileType
 {
@@ -47,6 +48,12 @@ class SampledSuffixArray
         void validate(std::string readsFile, const BWT* pBWT);
         void printInfo() const;
 
+        // Spread the arrays over the nodes of a NUMA machine
+        void interleaveMemory() const;
+
+        // Print how much of the lexicographic index the kernel backed with huge pages
+        void printHugePageInfo(const std::string& name) const;
+
         // I/O
         void writeLexicoIndex(const std::string& filename);
         void writeSSA(std::string filename);
@@ -66,7 +73,7 @@ class SampledSuffixArray
         // This limits the SampledSuffixArray to represent at most 2**32 strings.
         // To improve this we could use a polymorphic vector with a runtime-determined
         // size.
-        std::vector<SSA_INT_TYPE> m_saLexoIndex;
+        SSALexoVector m_saLexoIndex;
 
         static const int DEFAULT_SA_SAMPLE_RATE = 64;
         int m_sampleRate;
@@ -31,6 +31,7 @@
 #include <sstream>
 #include <limits>
 #include <stdio.h>
+#include <stdint.h>
 
 OverlapperParams default_params = { 2, -6, -3 };
 OverlapperParams ungapped_params = { 2, -10000, -3 };
@@ -821,3 +822,152 @@ std::string Overlapper::compactCigar(const std::string& ecigar)
     compact_cigar << curr_run << curr_symbol;
     return compact_cigar.str();
 }
+
+// Number of pattern/text pairs searched together by searchEditDistances
+static const size_t EDIT_DISTANCE_LANES = 8;
+static const int EDIT_DISTANCE_WORD_BITS = 64;
+
+// Rank of the bases in the match masks, -1 for any other symbol
+static inline int editDistanceRank(char b)
+{
+    switch(b)
+    {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+    }
+}
+
+// Search the pairs [first, first + numPairs) of the batch, one pair per lane.
+// Myers' algorithm computes the columns of the DP matrix of a pattern against
+// its text as vertical deltas, 64 rows per word. The top row is zero so the
+// alignment can start anywhere in the text and the score is read from the last
+// row of the pattern. The word of block b of lane l is at b * EDIT_DISTANCE_LANES + l,
+// all lanes have as many blocks as the longest pattern and the rows past the end
+// of a shorter pattern never match, so they do not change the rows above them.
+static void searchEditDistanceLanes(const std::vector<std::string>& patterns, const std::vector<std::string>& texts,
+                                    const std::vector<int>& maxDists, size_t first, size_t numPairs,
+                                    std::vector<int>& distances)
+{
+    const size_t L = EDIT_DISTANCE_LANES;
+    assert(numPairs <= L);
+
+    size_t numBlocks = 1;
+    size_t maxTextLength = 0;
+    for(size_t l = 0; l < numPairs; ++l)
+    {
+        numBlocks = std::max(numBlocks, (patterns[first + l].size() + EDIT_DISTANCE_WORD_BITS - 1) / EDIT_DISTANCE_WORD_BITS);
+        maxTextLength = std::max(maxTextLength, texts[first + l].size());
+    }
+
+    // The bits of the pattern positions holding each base, bases other than ACGT never match
+    std::vector<uint64_t> peq[4];
+    for(int i = 0; i < 4; ++i)
+        peq[i].assign(numBlocks * L, 0);
+
+    size_t lastBlock[EDIT_DISTANCE_LANES];
+    int lastShift[EDIT_DISTANCE_LANES];
+    int score[EDIT_DISTANCE_LANES];
+    int best[EDIT_DISTANCE_LANES];
+    bool active[EDIT_DISTANCE_LANES];
+    size_t numActive = 0;
+    for(size_t l = 0; l < L; ++l)
+    {
+        size_t length = l < numPairs ? patterns[first + l].size() : 0;
+        for(size_t i = 0; i < length; ++i)
+        {
+            int rank = editDistanceRank(patterns[first + l][i]);
+            if(rank >= 0)
+                peq[rank][(i / EDIT_DISTANCE_WORD_BITS) * L + l] |= (uint64_t)1 << (i % EDIT_DISTANCE_WORD_BITS);
+        }
+        lastBlock[l] = length > 0 ? (length - 1) / EDIT_DISTANCE_WORD_BITS : 0;
+        lastShift[l] = length > 0 ? (length - 1) % EDIT_DISTANCE_WORD_BITS : 0;
+        score[l] = best[l] = length;
+        active[l] = length > 0;
+        numActive += active[l];
+    }
+
+    std::vector<uint64_t> pv(numBlocks * L, ~(uint64_t)0);
+    std::vector<uint64_t> mv(numBlocks * L, 0);
+    std::vector<uint64_t> eq(numBlocks * L);
+    int carry[EDIT_DISTANCE_LANES];
+    int delta[EDIT_DISTANCE_LANES];
+    for(size_t j = 0; j < maxTextLength && numActive > 0; ++j)
+    {
+        // Gather the match masks of the column of each lane
+        for(size_t l = 0; l < L; ++l)
+        {
+            int rank = active[l] && j < texts[first + l].size() ? editDistanceRank(texts[first + l][j]) : -1;
+            for(size_t b = 0; b < numBlocks; ++b)
+                eq[b * L + l] = rank >= 0 ? peq[rank][b * L + l] : 0;
+            carry[l] = 0;
+            delta[l] = 0;
+        }
+
+        // The horizontal delta carried from one block into the next is in carry,
+        // the delta of the last row of the pattern, its change of score, in delta
+        for(size_t b = 0; b < numBlocks; ++b)
+        {
+            uint64_t* pPV = &pv[b * L];
+            uint64_t* pMV = &mv[b * L];
+            const uint64_t* pEq = &eq[b * L];
+            for(size_t l = 0; l < L; ++l)
+            {
+                uint64_t minusIn = carry[l] < 0;
+                uint64_t plusIn = carry[l] > 0;
+                uint64_t xv = pEq[l] | pMV[l];
+                uint64_t e = pEq[l] | minusIn;
+                uint64_t xh = (((e & pPV[l]) + pPV[l]) ^ pPV[l]) | e;
+                uint64_t ph = pMV[l] | ~(xh | pPV[l]);
+                uint64_t mh = pPV[l] & xh;
+
+                if(b == lastBlock[l])
+                    delta[l] = (int)((ph >> lastShift[l]) & 1) - (int)((mh >> lastShift[l]) & 1);
+                carry[l] = (int)(ph >> (EDIT_DISTANCE_WORD_BITS - 1)) - (int)(mh >> (EDIT_DISTANCE_WORD_BITS - 1));
+
+                ph = (ph << 1) | plusIn;
+                mh = (mh << 1) | minusIn;
+                pPV[l] = mh | ~(xv | ph);
+                pMV[l] = ph & xv;
+            }
+        }
+
+        for(size_t l = 0; l < L; ++l)
+        {
+            if(!active[l])
+                continue;
+            if(j >= texts[first + l].size())
+            {
+                active[l] = false;
+                --numActive;
+                continue;
+            }
+
+            score[l] += delta[l];
+            if(score[l] < best[l])
+            {
+                best[l] = score[l];
+                if(best[l] <= maxDists[first + l])
+                {
+                    active[l] = false;
+                    --numActive;
+                }
+            }
+        }
+    }
+
+    for(size_t l = 0; l < numPairs; ++l)
+        distances[first + l] = best[l];
+}
+
+//
+void Overlapper::searchEditDistances(const std::vector<std::string>& patterns, const std::vector<std::string>& texts,
+                                     const std::vector<int>& maxDists, std::vector<int>& distances)
+{
+    assert(patterns.size() == texts.size() && patterns.size() == maxDists.size());
+    distances.resize(patterns.size());
+    for(size_t first = 0; first < patterns.size(); first += EDIT_DISTANCE_LANES)
+        searchEditDistanceLanes(patterns, texts, maxDists, first, std::min(EDIT_DISTANCE_LANES, patterns.size() - first), distances);
+}
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <ostream>
+#include <vector>
 #include <assert.h>
 
 // A start/end coordinate pair representing
@@ -158,6 +159,15 @@ SequenceOverlap computeOverlapAffine(const std::string& s1, const std::string& s
 // Compact an expanded CIGAR string into a regular cigar string
 std::string compactCigar(const std::string& ecigar);
 
+// Calculate, for each i, the smallest number of edits needed to align the whole of patterns[i]
+// to a substring of texts[i] with Myers' bit-vector algorithm (Hyyro's blocks for patterns
+// longer than 64 bases). The pairs are searched in lanes, several at a time, with the state
+// of the lanes held side by side so each text column updates all of them in one loop.
+// The search of a pair stops as soon as an alignment with at most maxDists[i] edits is
+// found, so distances[i] is only the minimum when it is greater than maxDists[i].
+void searchEditDistances(const std::vector<std::string>& patterns, const std::vector<std::string>& texts,
+                         const std::vector<int>& maxDists, std::vector<int>& distances);
+
 }
 
 #endif
@@ -0,0 +1,148 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// AtomicBitVector - Lock-free vector of bits shared
+// by the worker threads
+//
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "AtomicBitVector.h"
+
+//
+AtomicBitVector::AtomicBitVector() : m_pWords(NULL), m_numWords(0), m_numBits(0), m_mapSize(0)
+{
+
+}
+
+//
+AtomicBitVector::AtomicBitVector(size_t n) : m_pWords(NULL), m_numWords(0), m_numBits(0), m_mapSize(0)
+{
+    allocate(n);
+}
+
+//
+AtomicBitVector::AtomicBitVector(size_t n, const std::string& backingFile) : m_pWords(NULL),
+                                                                             m_numWords(0),
+                                                                             m_numBits(0),
+                                                                             m_mapSize(0),
+                                                                             m_backingFile(backingFile)
+{
+    allocate(n);
+}
+
+//
+AtomicBitVector::~AtomicBitVector()
+{
+    release();
+    if(!m_backingFile.empty())
+        unlink(m_backingFile.c_str());
+}
+
+//
+void AtomicBitVector::resize(size_t n)
+{
+    release();
+    allocate(n);
+}
+
+//
+void AtomicBitVector::allocate(size_t n)
+{
+    m_numBits = n;
+    m_numWords = (n + WORD_BITS - 1) / WORD_BITS;
+    if(m_numWords == 0)
+        return;
+
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    m_mapSize = (getNumBytes() + pageSize - 1) / pageSize * pageSize;
+
+    void* pData = MAP_FAILED;
+    if(m_backingFile.empty())
+    {
+        pData = mmap(NULL, m_mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else
+    {
+        // Start from an empty file so no stale bits are mapped in
+        int fd = open(m_backingFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0 || ftruncate(fd, m_mapSize) != 0)
+        {
+            std::cerr << "Error: could not create the bit vector file " << m_backingFile << "\n";
+            exit(EXIT_FAILURE);
+        }
+        pData = mmap(NULL, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+
+    if(pData == MAP_FAILED)
+    {
+        std::cerr << "Error: could not allocate a bit vector of " << n << " bits\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // New mappings are zero filled
+    m_pWords = (volatile uint64_t*)pData;
+}
+
+//
+void AtomicBitVector::release()
+{
+    if(m_pWords != NULL)
+        munmap((void*)m_pWords, m_mapSize);
+    m_pWords = NULL;
+    m_numWords = 0;
+    m_numBits = 0;
+    m_mapSize = 0;
+}
+
+//
+bool AtomicBitVector::updateCAS(size_t i, bool oldValue, bool newValue)
+{
+    if(oldValue == newValue)
+        return test(i) == oldValue;
+    else if(newValue)
+        return testAndSet(i);
+    else
+        return testAndClear(i);
+}
+
+//
+void AtomicBitVector::clear()
+{
+    if(m_numWords > 0)
+        memset((void*)m_pWords, 0, getNumBytes());
+}
+
+//
+size_t AtomicBitVector::count() const
+{
+    size_t sum = 0;
+    for(size_t i = 0; i < m_numWords; ++i)
+        sum += __builtin_popcountll(m_pWords[i]);
+    return sum;
+}
+
+//
+void AtomicBitVector::write(std::ostream& out) const
+{
+    uint64_t numBits = m_numBits;
+    out.write((const char*)&numBits, sizeof(numBits));
+    if(m_numWords > 0)
+        out.write((const char*)m_pWords, getNumBytes());
+}
+
+//
+void AtomicBitVector::read(std::istream& in)
+{
+    uint64_t numBits = 0;
+    in.read((char*)&numBits, sizeof(numBits));
+    if(numBits != m_numBits)
+        resize(numBits);
+    if(m_numWords > 0)
+        in.read((char*)m_pWords, getNumBytes());
+}
@@ -0,0 +1,115 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// AtomicBitVector - Vector of bits shared by the worker
+// threads to mark reads. The bits are held in 64-bit words
+// that are updated with atomic fetch-or/fetch-and, so any
+// number of threads can mark reads without a lock.
+//
+// The words are mapped directly from the system on a
+// page boundary so the vector never shares a cache line
+// with other data. Optionally the mapping is backed by a
+// scratch file instead of anonymous memory so the pages of
+// a very large vector can be written back under memory
+// pressure rather than swapped.
+//
+#ifndef ATOMICBITVECTOR_H
+#define ATOMICBITVECTOR_H
+
+#include <stdint.h>
+#include <assert.h>
+#include <iostream>
+#include <string>
+
+class AtomicBitVector
+{
+    public:
+
+        AtomicBitVector();
+        AtomicBitVector(size_t n);
+
+        // Back the vector with a scratch file that is removed on destruction
+        AtomicBitVector(size_t n, const std::string& backingFile);
+        ~AtomicBitVector();
+
+        // Reallocate the vector with n bits, all clear
+        void resize(size_t n);
+
+        size_t size() const { return m_numBits; }
+
+        // Returns true if bit i is set
+        inline bool test(size_t i) const
+        {
+            assert(i < m_numBits);
+            return (m_pWords[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+        }
+
+        // Atomically set bit i. Returns true if this call changed the bit,
+        // false if it was already set.
+        inline bool testAndSet(size_t i)
+        {
+            assert(i < m_numBits);
+            uint64_t mask = (uint64_t)1 << (i % WORD_BITS);
+            return (__sync_fetch_and_or(&m_pWords[i / WORD_BITS], mask) & mask) == 0;
+        }
+
+        // Atomically clear bit i. Returns true if this call changed the bit.
+        inline bool testAndClear(size_t i)
+        {
+            assert(i < m_numBits);
+            uint64_t mask = (uint64_t)1 << (i % WORD_BITS);
+            return (__sync_fetch_and_and(&m_pWords[i / WORD_BITS], ~mask) & mask) != 0;
+        }
+
+        // Atomically set bit i to v
+        inline void set(size_t i, bool v)
+        {
+            if(v)
+                testAndSet(i);
+            else
+                testAndClear(i);
+        }
+
+        // Update the bit at position i from oldValue to newValue.
+        // Returns true if the bit had oldValue and now has newValue.
+        bool updateCAS(size_t i, bool oldValue, bool newValue);
+
+        // Clear every bit. Must not be called while other threads update the vector.
+        void clear();
+
+        // Number of set bits
+        size_t count() const;
+
+        // Save or restore the bits in binary form
+        void write(std::ostream& out) const;
+        void read(std::istream& in);
+
+        // Number of bytes written by write()
+        size_t getWriteSize() const { return sizeof(uint64_t) + getNumBytes(); }
+
+    private:
+
+        static const size_t WORD_BITS = 64;
+
+        // Bytes holding the bits, rounded up to whole words
+        size_t getNumBytes() const { return m_numWords * sizeof(uint64_t); }
+
+        void allocate(size_t n);
+        void release();
+
+        // Not copyable
+        AtomicBitVector(const AtomicBitVector&);
+        AtomicBitVector& operator=(const AtomicBitVector&);
+
+        volatile uint64_t* m_pWords;
+        size_t m_numWords;
+        size_t m_numBits;
+
+        // Size of the mapping, a whole number of pages
+        size_t m_mapSize;
+        std::string m_backingFile;
+};
+
+#endif
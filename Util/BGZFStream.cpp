@@ -0,0 +1,707 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// BGZFStream - Multi-threaded gzip streams
+//
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "BGZFStream.h"
+
+// Bytes of data per block. Incompressible data must still fit in BGZF_MAX_BLOCK_SIZE.
+static const size_t BGZF_BLOCK_SIZE = 0xff00;
+static const size_t BGZF_MAX_BLOCK_SIZE = 0x10000;
+static const size_t BGZF_HEADER_SIZE = 18;
+static const size_t BGZF_FOOTER_SIZE = 8;
+
+// gzip member header with the BC extra field that holds the block size
+static const unsigned char BGZF_HEADER[BGZF_HEADER_SIZE] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0 };
+
+// Number of blocks kept in flight per thread
+static const size_t BLOCKS_PER_THREAD = 4;
+
+static int gzipThreads = 2;
+
+//
+void setGzipThreads(int numThreads)
+{
+    gzipThreads = numThreads > 1 ? numThreads : 1;
+}
+
+//
+int getGzipThreads()
+{
+    return gzipThreads;
+}
+
+//
+static inline void packUInt16(unsigned char* p, unsigned v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+//
+static inline void packUInt32(unsigned char* p, uint32_t v)
+{
+    packUInt16(p, v & 0xffff);
+    packUInt16(p + 2, v >> 16);
+}
+
+//
+static inline uint32_t unpackUInt32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Returns true if the bytes are a BGZF member header
+static bool checkHeader(const unsigned char* p)
+{
+    return p[0] == 0x1f && p[1] == 0x8b && p[2] == 8 && (p[3] & 4) &&
+           p[10] == 6 && p[11] == 0 && p[12] == 'B' && p[13] == 'C' && p[14] == 2 && p[15] == 0;
+}
+
+// Compress len bytes into BGZF blocks appended to out. Data that does not
+// compress into a single block is split in half.
+static void deflateBlock(const char* pData, size_t len, std::vector<char>& out)
+{
+    size_t start = out.size();
+    out.resize(start + BGZF_MAX_BLOCK_SIZE);
+    unsigned char* pBlock = (unsigned char*)&out[start];
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    int ret = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    assert(ret == Z_OK);
+
+    zs.next_in = (Bytef*)pData;
+    zs.avail_in = len;
+    zs.next_out = pBlock + BGZF_HEADER_SIZE;
+    zs.avail_out = BGZF_MAX_BLOCK_SIZE - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE;
+    ret = deflate(&zs, Z_FINISH);
+    size_t compressedSize = zs.total_out;
+    deflateEnd(&zs);
+
+    if(ret != Z_STREAM_END)
+    {
+        assert(len > 1);
+        out.resize(start);
+        deflateBlock(pData, len / 2, out);
+        deflateBlock(pData + len / 2, len - len / 2, out);
+        return;
+    }
+
+    size_t blockSize = BGZF_HEADER_SIZE + compressedSize + BGZF_FOOTER_SIZE;
+    memcpy(pBlock, BGZF_HEADER, BGZF_HEADER_SIZE);
+    packUInt16(pBlock + 16, blockSize - 1);
+
+    uint32_t crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)pData, len);
+    packUInt32(pBlock + blockSize - 8, crc);
+    packUInt32(pBlock + blockSize - 4, len);
+    out.resize(start + blockSize);
+}
+
+// Decompress a complete BGZF block. Returns false if the block is corrupt.
+static bool inflateBlock(const std::vector<char>& in, std::vector<char>& out)
+{
+    const unsigned char* pBlock = (const unsigned char*)&in[0];
+    size_t blockSize = in.size();
+    uint32_t crc = unpackUInt32(pBlock + blockSize - 8);
+    uint32_t dataSize = unpackUInt32(pBlock + blockSize - 4);
+    if(dataSize > BGZF_MAX_BLOCK_SIZE)
+        return false;
+
+    out.resize(dataSize);
+    char empty;
+    char* pOut = dataSize > 0 ? &out[0] : &empty;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if(inflateInit2(&zs, -15) != Z_OK)
+        return false;
+
+    zs.next_in = (Bytef*)(pBlock + BGZF_HEADER_SIZE);
+    zs.avail_in = blockSize - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE;
+    zs.next_out = (Bytef*)pOut;
+    zs.avail_out = dataSize;
+    int ret = inflate(&zs, Z_FINISH);
+    size_t inflatedSize = zs.total_out;
+    inflateEnd(&zs);
+
+    return ret == Z_STREAM_END && inflatedSize == dataSize &&
+           crc32(crc32(0L, Z_NULL, 0), (const Bytef*)pOut, dataSize) == crc;
+}
+
+//
+bool isBGZF(const std::string& filename)
+{
+    FILE* pFile = fopen(filename.c_str(), "rb");
+    if(pFile == NULL)
+        return false;
+
+    unsigned char header[BGZF_HEADER_SIZE];
+    bool bgzf = fread(header, 1, BGZF_HEADER_SIZE, pFile) == BGZF_HEADER_SIZE && checkHeader(header);
+    fclose(pFile);
+    return bgzf;
+}
+
+//
+// BGZFBlock - the unit of work of the thread pool
+//
+struct BGZFBlock
+{
+    BGZFBlock(bool c) : compress(c), ok(false) { sem_init(&doneSem, PTHREAD_PROCESS_PRIVATE, 0); }
+    ~BGZFBlock() { sem_destroy(&doneSem); }
+
+    void process()
+    {
+        if(compress)
+        {
+            deflateBlock(input.empty() ? NULL : &input[0], input.size(), output);
+            ok = true;
+        }
+        else
+        {
+            ok = inflateBlock(input, output);
+        }
+    }
+
+    std::vector<char> input;
+    std::vector<char> output;
+    bool compress;
+    bool ok;
+
+    // Posted by the worker once output is filled in
+    sem_t doneSem;
+};
+
+//
+// BGZFThreadPool - threads that process blocks in the order they are submitted
+//
+class BGZFThreadPool
+{
+    public:
+        BGZFThreadPool(int numThreads);
+        ~BGZFThreadPool();
+
+        void submit(BGZFBlock* pBlock);
+
+    private:
+        static void* startThread(void* obj);
+        void run();
+
+        std::vector<pthread_t> m_threads;
+        pthread_mutex_t m_mutex;
+        std::deque<BGZFBlock*> m_queue;
+        sem_t m_queueSem;
+        volatile bool m_stopRequested;
+};
+
+//
+BGZFThreadPool::BGZFThreadPool(int numThreads) : m_stopRequested(false)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+    if(sem_init(&m_queueSem, PTHREAD_PROCESS_PRIVATE, 0) != 0)
+    {
+        std::cerr << "Semaphore initialization failed\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_threads.resize(numThreads);
+    for(int i = 0; i < numThreads; ++i)
+    {
+        int ret = pthread_create(&m_threads[i], 0, &BGZFThreadPool::startThread, this);
+        if(ret != 0)
+        {
+            std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+//
+BGZFThreadPool::~BGZFThreadPool()
+{
+    m_stopRequested = true;
+    for(size_t i = 0; i < m_threads.size(); ++i)
+        sem_post(&m_queueSem);
+    for(size_t i = 0; i < m_threads.size(); ++i)
+        pthread_join(m_threads[i], NULL);
+
+    assert(m_queue.empty());
+    sem_destroy(&m_queueSem);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+//
+void BGZFThreadPool::submit(BGZFBlock* pBlock)
+{
+    pthread_mutex_lock(&m_mutex);
+    m_queue.push_back(pBlock);
+    pthread_mutex_unlock(&m_mutex);
+    sem_post(&m_queueSem);
+}
+
+//
+void* BGZFThreadPool::startThread(void* obj)
+{
+    static_cast<BGZFThreadPool*>(obj)->run();
+    return NULL;
+}
+
+//
+void BGZFThreadPool::run()
+{
+    while(1)
+    {
+        sem_wait(&m_queueSem);
+
+        pthread_mutex_lock(&m_mutex);
+        BGZFBlock* pBlock = NULL;
+        if(!m_queue.empty())
+        {
+            pBlock = m_queue.front();
+            m_queue.pop_front();
+        }
+        pthread_mutex_unlock(&m_mutex);
+
+        // The queue is only empty when the pool is stopping
+        if(pBlock == NULL)
+            break;
+
+        pBlock->process();
+        sem_post(&pBlock->doneSem);
+    }
+}
+
+//
+// BGZFOutputBuffer
+//
+BGZFOutputBuffer::BGZFOutputBuffer() : m_pFile(NULL), m_pPool(NULL), m_pCurrent(NULL), m_maxPending(0), m_bError(false)
+{
+
+}
+
+//
+BGZFOutputBuffer::~BGZFOutputBuffer()
+{
+    close();
+}
+
+//
+bool BGZFOutputBuffer::open(const std::string& filename, std::ios_base::openmode mode)
+{
+    assert(m_pFile == NULL);
+    m_pFile = fopen(filename.c_str(), (mode & std::ios_base::app) ? "ab" : "wb");
+    if(m_pFile == NULL)
+        return false;
+
+    int numThreads = getGzipThreads();
+    m_pPool = new BGZFThreadPool(numThreads);
+    m_maxPending = BLOCKS_PER_THREAD * numThreads;
+    m_bError = false;
+    startBlock();
+    return true;
+}
+
+//
+bool BGZFOutputBuffer::close()
+{
+    if(m_pFile == NULL)
+        return false;
+
+    flushBlocks();
+
+    // The empty block marks the end of the file for BGZF readers
+    std::vector<char> eofBlock;
+    deflateBlock(NULL, 0, eofBlock);
+    if(fwrite(&eofBlock[0], 1, eofBlock.size(), m_pFile) != eofBlock.size())
+        m_bError = true;
+    if(fclose(m_pFile) != 0)
+        m_bError = true;
+    m_pFile = NULL;
+
+    delete m_pPool;
+    m_pPool = NULL;
+    delete m_pCurrent;
+    m_pCurrent = NULL;
+    setp(NULL, NULL);
+    return !m_bError;
+}
+
+//
+int BGZFOutputBuffer::overflow(int c)
+{
+    if(m_pFile == NULL)
+        return EOF;
+
+    submitBlock();
+    startBlock();
+    if(c != EOF)
+    {
+        *pptr() = c;
+        pbump(1);
+    }
+    return m_bError ? EOF : 0;
+}
+
+//
+int BGZFOutputBuffer::sync()
+{
+    return (m_pFile == NULL || m_bError) ? -1 : 0;
+}
+
+//
+bool BGZFOutputBuffer::flushBlocks()
+{
+    if(m_pFile == NULL)
+        return false;
+
+    if(pptr() > pbase())
+    {
+        submitBlock();
+        startBlock();
+    }
+    writeBlocks(0);
+    if(fflush(m_pFile) != 0)
+        m_bError = true;
+    return !m_bError;
+}
+
+//
+void BGZFOutputBuffer::startBlock()
+{
+    m_pCurrent = new BGZFBlock(true);
+    m_pCurrent->input.resize(BGZF_BLOCK_SIZE);
+    setp(&m_pCurrent->input[0], &m_pCurrent->input[0] + BGZF_BLOCK_SIZE);
+}
+
+//
+void BGZFOutputBuffer::submitBlock()
+{
+    m_pCurrent->input.resize(pptr() - pbase());
+    m_pending.push_back(m_pCurrent);
+    m_pPool->submit(m_pCurrent);
+    m_pCurrent = NULL;
+    writeBlocks(m_maxPending);
+}
+
+//
+void BGZFOutputBuffer::writeBlocks(size_t maxPending)
+{
+    while(!m_pending.empty())
+    {
+        BGZFBlock* pBlock = m_pending.front();
+
+        // Blocks that are already compressed are written without waiting
+        if(m_pending.size() > maxPending)
+            sem_wait(&pBlock->doneSem);
+        else if(sem_trywait(&pBlock->doneSem) != 0)
+            break;
+
+        if(fwrite(&pBlock->output[0], 1, pBlock->output.size(), m_pFile) != pBlock->output.size())
+            m_bError = true;
+        m_pending.pop_front();
+        delete pBlock;
+    }
+}
+
+//
+// BGZFInputBuffer
+//
+BGZFInputBuffer::BGZFInputBuffer() : m_pFile(NULL), m_pPool(NULL), m_pCurrent(NULL), m_maxPending(0), m_bFileEOF(false)
+{
+
+}
+
+//
+BGZFInputBuffer::~BGZFInputBuffer()
+{
+    close();
+}
+
+//
+bool BGZFInputBuffer::open(const std::string& filename)
+{
+    assert(m_pFile == NULL);
+    m_pFile = fopen(filename.c_str(), "rb");
+    if(m_pFile == NULL)
+        return false;
+
+    m_filename = filename;
+    int numThreads = getGzipThreads();
+    m_pPool = new BGZFThreadPool(numThreads);
+    m_maxPending = BLOCKS_PER_THREAD * numThreads;
+    m_bFileEOF = false;
+    setg(NULL, NULL, NULL);
+    return true;
+}
+
+//
+void BGZFInputBuffer::close()
+{
+    if(m_pFile == NULL)
+        return;
+
+    // Let the threads finish the blocks that were read ahead
+    while(!m_pending.empty())
+    {
+        sem_wait(&m_pending.front()->doneSem);
+        delete m_pending.front();
+        m_pending.pop_front();
+    }
+
+    delete m_pPool;
+    m_pPool = NULL;
+    delete m_pCurrent;
+    m_pCurrent = NULL;
+    fclose(m_pFile);
+    m_pFile = NULL;
+    setg(NULL, NULL, NULL);
+}
+
+//
+int BGZFInputBuffer::underflow()
+{
+    if(gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    if(m_pFile == NULL)
+        return EOF;
+
+    while(1)
+    {
+        delete m_pCurrent;
+        m_pCurrent = NULL;
+
+        readBlocks();
+        if(m_pending.empty())
+            return EOF;
+
+        m_pCurrent = m_pending.front();
+        m_pending.pop_front();
+        sem_wait(&m_pCurrent->doneSem);
+        if(!m_pCurrent->ok)
+        {
+            std::cerr << "Error: corrupt BGZF block in " << m_filename << "\n";
+            exit(EXIT_FAILURE);
+        }
+
+        // Skip empty blocks such as the end-of-file marker
+        std::vector<char>& data = m_pCurrent->output;
+        if(!data.empty())
+        {
+            setg(&data[0], &data[0], &data[0] + data.size());
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+}
+
+//
+void BGZFInputBuffer::readBlocks()
+{
+    while(!m_bFileEOF && m_pending.size() < m_maxPending)
+    {
+        BGZFBlock* pBlock = readRawBlock();
+        if(pBlock == NULL)
+        {
+            m_bFileEOF = true;
+            break;
+        }
+        m_pending.push_back(pBlock);
+        m_pPool->submit(pBlock);
+    }
+}
+
+//
+BGZFBlock* BGZFInputBuffer::readRawBlock()
+{
+    unsigned char header[BGZF_HEADER_SIZE];
+    size_t n = fread(header, 1, BGZF_HEADER_SIZE, m_pFile);
+    if(n == 0)
+        return NULL;
+
+    if(n != BGZF_HEADER_SIZE || !checkHeader(header))
+    {
+        std::cerr << "Error: " << m_filename << " is not a valid BGZF file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    size_t blockSize = (header[16] | (header[17] << 8)) + 1;
+    if(blockSize < BGZF_HEADER_SIZE + BGZF_FOOTER_SIZE)
+    {
+        std::cerr << "Error: corrupt BGZF block in " << m_filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    BGZFBlock* pBlock = new BGZFBlock(false);
+    pBlock->input.resize(blockSize);
+    memcpy(&pBlock->input[0], header, BGZF_HEADER_SIZE);
+    size_t remaining = blockSize - BGZF_HEADER_SIZE;
+    if(fread(&pBlock->input[BGZF_HEADER_SIZE], 1, remaining, m_pFile) != remaining)
+    {
+        std::cerr << "Error: " << m_filename << " is truncated\n";
+        exit(EXIT_FAILURE);
+    }
+    return pBlock;
+}
+
+//
+// GZReadAheadBuffer
+//
+GZReadAheadBuffer::GZReadAheadBuffer() : m_file(NULL), m_readIdx(0), m_bHolding(false), m_bEOF(false), m_stopRequested(false)
+{
+
+}
+
+//
+GZReadAheadBuffer::~GZReadAheadBuffer()
+{
+    close();
+}
+
+//
+bool GZReadAheadBuffer::open(const std::string& filename)
+{
+    assert(m_file == NULL);
+    m_file = gzopen(filename.c_str(), "rb");
+    if(m_file == NULL)
+        return false;
+
+    m_filename = filename;
+    for(int i = 0; i < NUM_BUFFERS; ++i)
+        m_buffers[i].resize(BUFFER_SIZE);
+
+    sem_init(&m_freeSem, PTHREAD_PROCESS_PRIVATE, NUM_BUFFERS);
+    sem_init(&m_filledSem, PTHREAD_PROCESS_PRIVATE, 0);
+    m_readIdx = 0;
+    m_bHolding = false;
+    m_bEOF = false;
+    m_stopRequested = false;
+    setg(NULL, NULL, NULL);
+
+    int ret = pthread_create(&m_thread, 0, &GZReadAheadBuffer::startThread, this);
+    if(ret != 0)
+    {
+        std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+//
+void GZReadAheadBuffer::close()
+{
+    if(m_file == NULL)
+        return;
+
+    // Wake the thread if it is waiting for a free buffer
+    m_stopRequested = true;
+    sem_post(&m_freeSem);
+    pthread_join(m_thread, NULL);
+
+    sem_destroy(&m_freeSem);
+    sem_destroy(&m_filledSem);
+    gzclose(m_file);
+    m_file = NULL;
+    setg(NULL, NULL, NULL);
+}
+
+//
+int GZReadAheadBuffer::underflow()
+{
+    if(gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    if(m_file == NULL || m_bEOF)
+        return EOF;
+
+    // Hand the consumed buffer back to the thread
+    if(m_bHolding)
+    {
+        sem_post(&m_freeSem);
+        m_bHolding = false;
+    }
+
+    sem_wait(&m_filledSem);
+    int length = m_lengths[m_readIdx];
+    if(length <= 0)
+    {
+        if(length < 0)
+        {
+            std::cerr << "Error: could not decompress " << m_filename << "\n";
+            exit(EXIT_FAILURE);
+        }
+        m_bEOF = true;
+        return EOF;
+    }
+
+    char* pBuffer = &m_buffers[m_readIdx][0];
+    setg(pBuffer, pBuffer, pBuffer + length);
+    m_bHolding = true;
+    m_readIdx = (m_readIdx + 1) % NUM_BUFFERS;
+    return traits_type::to_int_type(*gptr());
+}
+
+//
+void* GZReadAheadBuffer::startThread(void* obj)
+{
+    static_cast<GZReadAheadBuffer*>(obj)->run();
+    return NULL;
+}
+
+//
+void GZReadAheadBuffer::run()
+{
+    int idx = 0;
+    while(1)
+    {
+        sem_wait(&m_freeSem);
+        if(m_stopRequested)
+            break;
+
+        int length = gzread(m_file, &m_buffers[idx][0], BUFFER_SIZE);
+        m_lengths[idx] = length;
+        idx = (idx + 1) % NUM_BUFFERS;
+        sem_post(&m_filledSem);
+
+        // The caller stops at the first empty or failed read
+        if(length <= 0)
+            break;
+    }
+}
+
+//
+// Streams
+//
+BGZFOutputStream::BGZFOutputStream(const std::string& filename, std::ios_base::openmode mode) : std::ostream(NULL)
+{
+    rdbuf(&m_buf);
+    if(!m_buf.open(filename, mode))
+        setstate(std::ios_base::failbit);
+}
+
+//
+void BGZFOutputStream::close()
+{
+    if(!m_buf.close())
+        setstate(std::ios_base::failbit);
+}
+
+//
+BGZFInputStream::BGZFInputStream(const std::string& filename) : std::istream(NULL)
+{
+    rdbuf(&m_buf);
+    if(!m_buf.open(filename))
+        setstate(std::ios_base::failbit);
+}
+
+//
+GZReadAheadStream::GZReadAheadStream(const std::string& filename) : std::istream(NULL)
+{
+    rdbuf(&m_buf);
+    if(!m_buf.open(filename))
+        setstate(std::ios_base::failbit);
+}
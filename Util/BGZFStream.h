@@ -0,0 +1,178 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// BGZFStream - Multi-threaded gzip streams. Output is
+// written in the BGZF layout: a series of independent gzip
+// members holding at most 64KB of data each, which gzip and
+// zcat read as a normal gzip file. The members are compressed
+// by a pool of threads and written in order.
+//
+// BGZF input is decompressed a block per thread in the same
+// way. Any other gzip file is inflated by a read-ahead thread
+// so decompression overlaps with the caller's parsing.
+//
+#ifndef BGZFSTREAM_H
+#define BGZFSTREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <pthread.h>
+#include <semaphore.h>
+#include <zlib.h>
+
+// Number of threads used to compress or decompress each BGZF stream
+void setGzipThreads(int numThreads);
+int getGzipThreads();
+
+// Returns true if the file starts with a BGZF block
+bool isBGZF(const std::string& filename);
+
+struct BGZFBlock;
+class BGZFThreadPool;
+
+// Stream buffer that cuts the output into BGZF blocks
+class BGZFOutputBuffer : public std::streambuf
+{
+    public:
+        BGZFOutputBuffer();
+        ~BGZFOutputBuffer();
+
+        // Opens the file for writing. With std::ios_base::app the blocks are appended.
+        bool open(const std::string& filename, std::ios_base::openmode mode);
+
+        // Write the remaining data and the BGZF end-of-file block
+        bool close();
+        bool is_open() const { return m_pFile != NULL; }
+
+        // Compress and write all buffered data so the file ends on a complete block.
+        // A plain flush() keeps the data buffered, as with ogzstream, so writers
+        // that flush every line do not produce tiny blocks.
+        bool flushBlocks();
+
+    protected:
+        virtual int overflow(int c);
+        virtual int sync();
+
+    private:
+        void startBlock();
+        void submitBlock();
+
+        // Write the compressed blocks at the head of the queue until
+        // at most maxPending blocks are left in flight
+        void writeBlocks(size_t maxPending);
+
+        FILE* m_pFile;
+        BGZFThreadPool* m_pPool;
+        BGZFBlock* m_pCurrent;
+        std::deque<BGZFBlock*> m_pending;
+        size_t m_maxPending;
+        bool m_bError;
+};
+
+// Stream buffer that decompresses BGZF blocks in parallel
+class BGZFInputBuffer : public std::streambuf
+{
+    public:
+        BGZFInputBuffer();
+        ~BGZFInputBuffer();
+
+        bool open(const std::string& filename);
+        void close();
+        bool is_open() const { return m_pFile != NULL; }
+
+    protected:
+        virtual int underflow();
+
+    private:
+        // Read compressed blocks from the file and queue them until maxPending are in flight
+        void readBlocks();
+        BGZFBlock* readRawBlock();
+
+        std::string m_filename;
+        FILE* m_pFile;
+        BGZFThreadPool* m_pPool;
+        BGZFBlock* m_pCurrent;
+        std::deque<BGZFBlock*> m_pending;
+        size_t m_maxPending;
+        bool m_bFileEOF;
+};
+
+// Stream buffer that inflates a gzip file on a background thread
+class GZReadAheadBuffer : public std::streambuf
+{
+    public:
+        GZReadAheadBuffer();
+        ~GZReadAheadBuffer();
+
+        bool open(const std::string& filename);
+        void close();
+        bool is_open() const { return m_file != NULL; }
+
+    protected:
+        virtual int underflow();
+
+    private:
+        static const int NUM_BUFFERS = 4;
+        static const int BUFFER_SIZE = 1 << 20;
+
+        static void* startThread(void* obj);
+        void run();
+
+        std::string m_filename;
+        gzFile m_file;
+        pthread_t m_thread;
+
+        // The thread fills the buffers in turn and the caller consumes them in the same order
+        std::vector<char> m_buffers[NUM_BUFFERS];
+        int m_lengths[NUM_BUFFERS];
+        sem_t m_freeSem;
+        sem_t m_filledSem;
+
+        int m_readIdx;
+        bool m_bHolding;
+        bool m_bEOF;
+        volatile bool m_stopRequested;
+};
+
+//
+class BGZFOutputStream : public std::ostream
+{
+    public:
+        BGZFOutputStream(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out);
+        ~BGZFOutputStream() { m_buf.close(); }
+        void close();
+        bool flushBlocks() { return m_buf.flushBlocks(); }
+
+    private:
+        BGZFOutputBuffer m_buf;
+};
+
+//
+class BGZFInputStream : public std::istream
+{
+    public:
+        BGZFInputStream(const std::string& filename);
+        ~BGZFInputStream() { m_buf.close(); }
+
+    private:
+        BGZFInputBuffer m_buf;
+};
+
+//
+class GZReadAheadStream : public std::istream
+{
+    public:
+        GZReadAheadStream(const std::string& filename);
+        ~GZReadAheadStream() { m_buf.close(); }
+
+    private:
+        GZReadAheadBuffer m_buf;
+};
+
+#endif
@@ -90,3 +90,22 @@ bool BitVector::test(size_t i) const
     return m_data[byte].test(offset);
 }
 
+
+//
+void BitVector::write(std::ostream& out) const
+{
+    size_t num_bytes = m_data.size();
+    out.write((const char*)&num_bytes, sizeof(num_bytes));
+    if(num_bytes > 0)
+        out.write((const char*)&m_data[0], num_bytes * sizeof(BitChar));
+}
+
+//
+void BitVector::read(std::istream& in)
+{
+    size_t num_bytes = 0;
+    in.read((char*)&num_bytes, sizeof(num_bytes));
+    m_data.resize(num_bytes);
+    if(num_bytes > 0)
+        in.read((char*)&m_data[0], num_bytes * sizeof(BitChar));
+}
@@ -38,6 +38,10 @@ class BitVector
 
         size_t capacity() const { return m_data.size() * 8; }
 
+        // Save or restore the bits in binary form
+        void write(std::ostream& out) const;
+        void read(std::istream& in);
+
     private:
 
         void initializeMutex();
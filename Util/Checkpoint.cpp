@@ -0,0 +1,268 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// Checkpoint - Periodically record how far a run of the
+// SequenceProcessFramework has progressed so that an
+// interrupted job can be resumed.
+//
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "Checkpoint.h"
+#include "AtomicBitVector.h"
+#include "BGZFStream.h"
+#include "PackedReadFile.h"
+
+// The checkpoint is a text header with one record per line followed
+// by the raw contents of each bit vector:
+//   checkpoint 2
+//   completed <num work items>
+//   output <size> <filename>
+//   counter <name> <value>
+//   bitvector <name> <num bytes>\n<bytes>\n
+//   end
+// The bytes of a bit vector are written by AtomicBitVector::write: the
+// number of bits as a uint64_t, then the 64-bit words with bit i in
+// bit i % 64 of word i / 64. <num bytes> counts both. Version 1 stored
+// the words of the old BitVector, which have a different layout.
+static const char* CHECKPOINT_MAGIC = "checkpoint";
+static const int CHECKPOINT_VERSION = 2;
+
+//
+Checkpoint::Checkpoint(const std::string& filename, bool resume, int intervalSecs) : m_filename(filename),
+                                                                                   m_intervalSecs(intervalSecs),
+                                                                                   m_timer("Checkpoint", true),
+                                                                                   m_bResuming(false),
+                                                                                   m_numCompleted(0)
+{
+    if(!resume)
+        return;
+
+    std::ifstream test(m_filename.c_str());
+    if(!test.good())
+    {
+        printf("[checkpoint] no checkpoint found at %s, starting from the beginning\n", m_filename.c_str());
+        return;
+    }
+    test.close();
+
+    load();
+    m_bResuming = true;
+    printf("[checkpoint] resuming after %zu completed work items\n", m_numCompleted);
+}
+
+//
+std::ostream* Checkpoint::openOutput(const std::string& filename)
+{
+    std::ostream* pWriter;
+    if(m_bResuming)
+    {
+        SizeMap::iterator iter = m_loadedOutputs.find(filename);
+        if(iter == m_loadedOutputs.end())
+        {
+            std::cerr << "Error: " << filename << " is not an output of the checkpointed run in " << m_filename << "\n";
+            std::cerr << "Resume with the same options as the interrupted run\n";
+            exit(EXIT_FAILURE);
+        }
+
+        // A packed read file is only written when it is closed
+        if(isPackedReads(filename))
+        {
+            std::cerr << "Error: cannot resume writing the packed read file " << filename << "\n";
+            exit(EXIT_FAILURE);
+        }
+
+        // Discard the output that was written after the checkpoint
+        std::streamoff size = getFilesize(filename);
+        if(size < 0 || (size_t)size < iter->second || truncate(filename.c_str(), iter->second) != 0)
+        {
+            std::cerr << "Error: could not truncate " << filename << " to its checkpointed size of " << iter->second << " bytes\n";
+            exit(EXIT_FAILURE);
+        }
+        m_loadedOutputs.erase(iter);
+        pWriter = createWriter(filename, std::ios_base::out | std::ios_base::app);
+    }
+    else
+    {
+        pWriter = createWriter(filename);
+    }
+
+    OutputFile output;
+    output.filename = filename;
+    output.pWriter = pWriter;
+    m_outputs.push_back(output);
+    return pWriter;
+}
+
+//
+void Checkpoint::addCounter(const std::string& name, size_t* pCounter)
+{
+    m_counters[name] = pCounter;
+
+    SizeMap::iterator iter = m_loadedCounters.find(name);
+    if(iter != m_loadedCounters.end())
+    {
+        *pCounter = iter->second;
+        m_loadedCounters.erase(iter);
+    }
+}
+
+//
+void Checkpoint::addBitVector(const std::string& name, AtomicBitVector* pBitVector)
+{
+    m_bitVectors[name] = pBitVector;
+
+    DataMap::iterator iter = m_loadedBitVectors.find(name);
+    if(iter != m_loadedBitVectors.end())
+    {
+        std::istringstream in(iter->second);
+        pBitVector->read(in);
+        m_loadedBitVectors.erase(iter);
+    }
+}
+
+//
+void Checkpoint::validate() const
+{
+    if(!m_loadedOutputs.empty() || !m_loadedCounters.empty() || !m_loadedBitVectors.empty())
+    {
+        std::cerr << "Error: the checkpoint " << m_filename << " does not match this run\n";
+        for(SizeMap::const_iterator iter = m_loadedOutputs.begin(); iter != m_loadedOutputs.end(); ++iter)
+            std::cerr << "  output " << iter->first << " was not reopened\n";
+        std::cerr << "Resume with the same options as the interrupted run\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+void Checkpoint::write(size_t numCompleted)
+{
+    // Make every output consistent on disk. A gzip stream writes out its
+    // buffered blocks so the file ends on a complete gzip member.
+    for(OutputVector::iterator iter = m_outputs.begin(); iter != m_outputs.end(); ++iter)
+    {
+        BGZFOutputStream* pGZ = dynamic_cast<BGZFOutputStream*>(iter->pWriter);
+        if(pGZ != NULL)
+        {
+            if(!pGZ->flushBlocks())
+            {
+                std::cerr << "Error: could not write " << iter->filename << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else
+        {
+            iter->pWriter->flush();
+        }
+    }
+
+    // Write the checkpoint to a temporary file and move it over the
+    // previous one so an interruption here leaves a usable checkpoint
+    std::string tmpFilename = m_filename + ".tmp";
+    std::ofstream out(tmpFilename.c_str(), std::ios_base::out | std::ios_base::binary);
+    assertFileOpen(out, tmpFilename);
+
+    out << CHECKPOINT_MAGIC << " " << CHECKPOINT_VERSION << "\n";
+    out << "completed " << numCompleted << "\n";
+    for(OutputVector::iterator iter = m_outputs.begin(); iter != m_outputs.end(); ++iter)
+        out << "output " << (size_t)getFilesize(iter->filename) << " " << iter->filename << "\n";
+
+    for(CounterMap::iterator iter = m_counters.begin(); iter != m_counters.end(); ++iter)
+        out << "counter " << iter->first << " " << *iter->second << "\n";
+
+    for(BitVectorMap::iterator iter = m_bitVectors.begin(); iter != m_bitVectors.end(); ++iter)
+    {
+        // Stream the bits straight from the vector rather than through a copy
+        out << "bitvector " << iter->first << " " << iter->second->getWriteSize() << "\n";
+        iter->second->write(out);
+        out << "\n";
+    }
+    out << "end\n";
+    out.close();
+
+    if(!out || rename(tmpFilename.c_str(), m_filename.c_str()) != 0)
+    {
+        std::cerr << "Error: could not write the checkpoint " << m_filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    printf("[checkpoint] %zu work items completed\n", numCompleted);
+    m_timer.reset();
+}
+
+//
+void Checkpoint::remove()
+{
+    unlink(m_filename.c_str());
+}
+
+//
+void Checkpoint::load()
+{
+    std::ifstream in(m_filename.c_str(), std::ios_base::in | std::ios_base::binary);
+    assertFileOpen(in, m_filename);
+
+    std::string magic;
+    int version = 0;
+    in >> magic >> version;
+    if(magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION)
+    {
+        std::cerr << "Error: " << m_filename << " is not a valid checkpoint\n";
+        exit(EXIT_FAILURE);
+    }
+
+    bool done = false;
+    std::string tag;
+    while(!done && in >> tag)
+    {
+        if(tag == "completed")
+        {
+            in >> m_numCompleted;
+        }
+        else if(tag == "output")
+        {
+            // The filename is the rest of the line
+            size_t size;
+            std::string filename;
+            in >> size;
+            in.get();
+            getline(in, filename);
+            m_loadedOutputs[filename] = size;
+        }
+        else if(tag == "counter")
+        {
+            std::string name;
+            size_t value;
+            in >> name >> value;
+            m_loadedCounters[name] = value;
+        }
+        else if(tag == "bitvector")
+        {
+            std::string name;
+            size_t numBytes;
+            in >> name >> numBytes;
+            in.get();
+
+            std::string data(numBytes, '\0');
+            if(numBytes > 0)
+                in.read(&data[0], numBytes);
+            m_loadedBitVectors[name] = data;
+        }
+        else if(tag == "end")
+        {
+            done = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(!done || !in)
+    {
+        std::cerr << "Error: the checkpoint " << m_filename << " is truncated or corrupt\n";
+        exit(EXIT_FAILURE);
+    }
+}
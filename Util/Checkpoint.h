@@ -0,0 +1,101 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// Checkpoint - Periodically record how far a run of the
+// SequenceProcessFramework has progressed so that an
+// interrupted job can be resumed. A checkpoint stores the
+// number of completed work items, the size of every output
+// file at that point and the state the post processors
+// need to continue (counters and shared bit vectors).
+//
+// On resume the outputs are truncated back to the recorded
+// sizes and reopened for appending, the registered state is
+// restored and the framework skips the completed work items.
+//
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <map>
+#include "Util.h"
+#include "Timer.h"
+
+class AtomicBitVector;
+
+class Checkpoint
+{
+    public:
+
+        // Seconds between two checkpoints
+        static const int DEFAULT_INTERVAL = 600;
+
+        // If resume is set the state is loaded from filename when it exists
+        Checkpoint(const std::string& filename, bool resume, int intervalSecs = DEFAULT_INTERVAL);
+
+        // Open an output file of the run. When resuming, the file is truncated to
+        // the size recorded in the checkpoint and opened for appending.
+        // The returned writer is owned by the caller.
+        std::ostream* openOutput(const std::string& filename);
+
+        // Register state that is saved with each checkpoint and restored
+        // from the loaded checkpoint on registration
+        void addCounter(const std::string& name, size_t* pCounter);
+        void addBitVector(const std::string& name, AtomicBitVector* pBitVector);
+
+        // Check that everything recorded in the loaded checkpoint has been registered again
+        void validate() const;
+
+        // Returns true if a previous checkpoint was loaded
+        bool isResuming() const { return m_bResuming; }
+
+        // Number of work items that were completed when the checkpoint was loaded
+        size_t getNumCompleted() const { return m_numCompleted; }
+
+        // Returns true if the interval has elapsed since the last checkpoint was written
+        bool isDue() const { return m_intervalSecs > 0 && m_timer.getElapsedWallTime() >= m_intervalSecs; }
+
+        // Record that numCompleted work items are finished. All registered
+        // outputs must be consistent with this number, which the framework
+        // guarantees by only calling this when no work is in flight.
+        void write(size_t numCompleted);
+
+        // Remove the checkpoint once the whole run has finished
+        void remove();
+
+    private:
+
+        struct OutputFile
+        {
+            std::string filename;
+            std::ostream* pWriter;
+        };
+        typedef std::vector<OutputFile> OutputVector;
+
+        typedef std::map<std::string, size_t*> CounterMap;
+        typedef std::map<std::string, AtomicBitVector*> BitVectorMap;
+
+        typedef std::map<std::string, size_t> SizeMap;
+        typedef std::map<std::string, std::string> DataMap;
+
+        void load();
+
+        std::string m_filename;
+        int m_intervalSecs;
+        Timer m_timer;
+
+        bool m_bResuming;
+        size_t m_numCompleted;
+
+        // Registered state
+        OutputVector m_outputs;
+        CounterMap m_counters;
+        BitVectorMap m_bitVectors;
+
+        // State read from the checkpoint file, removed as it is registered again
+        SizeMap m_loadedOutputs;
+        SizeMap m_loadedCounters;
+        DataMap m_loadedBitVectors;
+};
+
+#endif
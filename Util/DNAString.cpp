@@ -10,7 +10,7 @@
 #include "DNAString.h"
 #include "Util.h"
 
-DNAString::DNAString() : m_len(0), m_data(0) {}
+DNAString::DNAString() : m_len(0), m_capacity(0), m_data(0) {}
 
 //
 DNAString::DNAString(std::string seq)
@@ -31,16 +31,14 @@ DNAString& DNAString::operator=(const DNAString& dna)
     if(&dna == this)
         return *this; // self-assign
 
-    _dealloc();
-    _alloc(dna.m_data, dna.m_len);
+    _assign(dna.m_data, dna.m_len);
     return *this;
 }
 
 //
 DNAString& DNAString::operator=(const std::string& str)
 {
-    _dealloc();
-    _alloc(str.c_str(), str.length());
+    _assign(str.c_str(), str.length());
     return *this;
 }
 
@@ -56,12 +54,31 @@ bool DNAString::operator==(const DNAString& other)
 void DNAString::_alloc(const char* pData, size_t l)
 {
     m_len = l;
+    m_capacity = l;
     size_t alloc_len = m_len + 1;
     m_data = new char[alloc_len];
     strncpy(m_data, pData, m_len);
     m_data[m_len] = '\0';
 }
 
+// Copy the data into the current buffer if it is large enough so
+// that strings which are refilled with reads of similar length,
+// like the reads of a work item, do not allocate on every assignment.
+// The buffer keeps its capacity when a shorter string is assigned.
+void DNAString::_assign(const char* pData, size_t l)
+{
+    if(m_data == NULL || l > m_capacity)
+    {
+        _dealloc();
+        _alloc(pData, l);
+        return;
+    }
+
+    memcpy(m_data, pData, l);
+    m_data[l] = '\0';
+    m_len = l;
+}
+
 //
 void DNAString::_dealloc()
 {
@@ -69,6 +86,7 @@ void DNAString::_dealloc()
         delete [] m_data;
     m_data = 0;
     m_len = 0;
+    m_capacity = 0;
 }
 
 //
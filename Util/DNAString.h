@@ -92,10 +92,12 @@ class DNAString
 
         // functions
         void _alloc(const char* pData, size_t l);
+        void _assign(const char* pData, size_t l);
         void _dealloc();
 
         // data
         size_t m_len;
+        size_t m_capacity; // length of the longest string m_data can hold
         char* m_data;
 };
 
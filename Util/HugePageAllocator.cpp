@@ -0,0 +1,132 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// HugePageAllocator - STL allocator for the large,
+// randomly accessed arrays of the FM-index
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <fstream>
+#include <sstream>
+#include "HugePageAllocator.h"
+
+// Allocations are rounded up to whole huge pages
+static size_t roundToHugePages(size_t numBytes)
+{
+    return (numBytes + HugePages::HUGE_PAGE_SIZE - 1) & ~(HugePages::HUGE_PAGE_SIZE - 1);
+}
+
+//
+void* HugePages::allocate(size_t numBytes)
+{
+    if(numBytes < HUGE_PAGE_SIZE)
+    {
+        void* p = malloc(numBytes > 0 ? numBytes : 1);
+        if(p == NULL)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    size_t mapSize = roundToHugePages(numBytes);
+
+#ifdef MAP_HUGETLB
+    // Use the reserved hugetlbfs pages if the administrator has set some aside
+    void* pHuge = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(pHuge != MAP_FAILED)
+        return pHuge;
+#endif
+
+    // Map an extra huge page so the range can be aligned to a huge page boundary,
+    // then return the unused head and tail to the system
+    size_t paddedSize = mapSize + HUGE_PAGE_SIZE;
+    char* pBase = (char*)mmap(NULL, paddedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(pBase == MAP_FAILED)
+        throw std::bad_alloc();
+
+    uintptr_t aligned = ((uintptr_t)pBase + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    char* pData = (char*)aligned;
+    size_t head = pData - pBase;
+    size_t tail = paddedSize - head - mapSize;
+    if(head > 0)
+        munmap(pBase, head);
+    if(tail > 0)
+        munmap(pData + mapSize, tail);
+
+#ifdef MADV_HUGEPAGE
+    madvise(pData, mapSize, MADV_HUGEPAGE);
+#endif
+    return pData;
+}
+
+//
+void HugePages::deallocate(void* p, size_t numBytes)
+{
+    if(p == NULL)
+        return;
+
+    if(numBytes < HUGE_PAGE_SIZE)
+        free(p);
+    else
+        munmap(p, roundToHugePages(numBytes));
+}
+
+//
+size_t HugePages::getHugePageBytes(const void* p, size_t numBytes)
+{
+    if(p == NULL || numBytes < HUGE_PAGE_SIZE)
+        return 0;
+
+    // Find the mapping that contains p in the memory map of the process
+    std::ifstream smaps("/proc/self/smaps");
+    uintptr_t addr = (uintptr_t)p;
+    bool inMapping = false;
+    size_t mappingSize = 0;
+    size_t hugeBytes = 0;
+
+    std::string line;
+    while(getline(smaps, line))
+    {
+        std::stringstream parser(line);
+        std::string field;
+        parser >> field;
+
+        // Mapping headers start with the address range, the fields end in a colon
+        if(!field.empty() && field[field.size() - 1] != ':')
+        {
+            if(inMapping)
+                break;
+
+            uintptr_t start = 0;
+            uintptr_t end = 0;
+            char dash;
+            std::stringstream rangeParser(field);
+            rangeParser >> std::hex >> start >> dash >> end;
+            inMapping = addr >= start && addr < end;
+            continue;
+        }
+
+        if(!inMapping)
+            continue;
+
+        size_t kb = 0;
+        parser >> kb;
+        if(field == "Size:")
+            mappingSize = kb * 1024;
+        else if(field == "AnonHugePages:")
+            hugeBytes += kb * 1024;
+        else if(field == "KernelPageSize:" && kb * 1024 >= HUGE_PAGE_SIZE)
+            hugeBytes = mappingSize; // hugetlbfs mapping
+    }
+    return hugeBytes < numBytes ? hugeBytes : numBytes;
+}
+
+//
+void HugePages::printInfo(const std::string& name, const void* p, size_t numBytes)
+{
+    double mb = 1024.0 * 1024.0;
+    printf("[hugepages] %s: %.1lf of %.1lf MB in huge pages\n", name.c_str(), getHugePageBytes(p, numBytes) / mb, numBytes / mb);
+}
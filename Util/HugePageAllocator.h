@@ -0,0 +1,94 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// HugePageAllocator - STL allocator for the large,
+// randomly accessed arrays of the FM-index. Allocations
+// of at least one huge page are mapped with mmap, from
+// the hugetlbfs pool if the system has one reserved and
+// otherwise as normal pages marked with MADV_HUGEPAGE so
+// the kernel backs them with transparent huge pages.
+// Smaller allocations use malloc.
+//
+#ifndef HUGEPAGEALLOCATOR_H
+#define HUGEPAGEALLOCATOR_H
+
+#include <stddef.h>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace HugePages
+{
+
+// Size of a huge page on x86-64
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+void* allocate(size_t numBytes);
+void deallocate(void* p, size_t numBytes);
+
+// Returns the number of bytes of the range that are backed by huge pages
+size_t getHugePageBytes(const void* p, size_t numBytes);
+
+// Print how much of the range is backed by huge pages
+void printInfo(const std::string& name, const void* p, size_t numBytes);
+
+// Convenience wrapper for the storage of a vector
+template<class T, class Alloc>
+inline void printInfo(const std::string& name, const std::vector<T, Alloc>& v)
+{
+    printInfo(name, v.empty() ? NULL : &v[0], v.capacity() * sizeof(T));
+}
+
+};
+
+template<class T>
+class HugePageAllocator
+{
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        template<class U>
+        struct rebind
+        {
+            typedef HugePageAllocator<U> other;
+        };
+
+        HugePageAllocator() throw() {}
+        HugePageAllocator(const HugePageAllocator&) throw() {}
+        template<class U> HugePageAllocator(const HugePageAllocator<U>&) throw() {}
+
+        pointer address(reference x) const { return &x; }
+        const_pointer address(const_reference x) const { return &x; }
+
+        pointer allocate(size_type n, const void* = 0)
+        {
+            return static_cast<pointer>(HugePages::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(pointer p, size_type n)
+        {
+            HugePages::deallocate(p, n * sizeof(T));
+        }
+
+        size_type max_size() const throw() { return size_t(-1) / sizeof(T); }
+
+        void construct(pointer p, const T& val) { new((void*)p) T(val); }
+        void destroy(pointer p) { p->~T(); }
+};
+
+// All instances share the same pool so memory from one can be freed by another
+template<class T, class U>
+inline bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+
+template<class T, class U>
+inline bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+#endif
@@ -0,0 +1,163 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// NUMA - Placement of threads and memory on the nodes
+// of a NUMA machine
+//
+#include <sched.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include "NUMA.h"
+
+// Memory policy values from linux/mempolicy.h
+static const int NUMA_MPOL_INTERLEAVE = 3;
+static const unsigned NUMA_MPOL_MF_MOVE = 1 << 1;
+
+static bool numaEnabled = false;
+
+// The kernel ID and CPUs of every node that can run threads
+static std::vector<int> nodeIDs;
+static std::vector<cpu_set_t> nodeCPUs;
+
+// The affinity of the process before any thread was bound
+static cpu_set_t initialCPUs;
+
+// Parse a sysfs list like "0-3,8-11" into its members
+static std::vector<int> parseList(const std::string& list)
+{
+    std::vector<int> out;
+    std::stringstream parser(list);
+    std::string range;
+    while(getline(parser, range, ','))
+    {
+        int first = 0;
+        int last = 0;
+        char dash = 0;
+        std::stringstream rangeParser(range);
+        rangeParser >> first;
+        last = first;
+        if(rangeParser >> dash && dash == '-')
+            rangeParser >> last;
+        for(int i = first; i <= last; ++i)
+            out.push_back(i);
+    }
+    return out;
+}
+
+// Read the first line of a sysfs file, empty if it does not exist
+static std::string readSysfs(const std::string& filename)
+{
+    std::ifstream in(filename.c_str());
+    std::string line;
+    getline(in, line);
+    return line;
+}
+
+//
+int NUMA::enable()
+{
+    if(numaEnabled)
+        return getNumNodes();
+
+    sched_getaffinity(0, sizeof(initialCPUs), &initialCPUs);
+
+    std::vector<int> nodes = parseList(readSysfs("/sys/devices/system/node/online"));
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        std::stringstream filename;
+        filename << "/sys/devices/system/node/node" << nodes[i] << "/cpulist";
+        std::vector<int> cpus = parseList(readSysfs(filename.str()));
+
+        // Only nodes with CPUs this process may use can run workers
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(size_t j = 0; j < cpus.size(); ++j)
+        {
+            if(cpus[j] < CPU_SETSIZE && CPU_ISSET(cpus[j], &initialCPUs))
+                CPU_SET(cpus[j], &set);
+        }
+        if(CPU_COUNT(&set) > 0)
+        {
+            nodeIDs.push_back(nodes[i]);
+            nodeCPUs.push_back(set);
+        }
+    }
+
+    // Without sysfs the machine is treated as a single node
+    if(nodeCPUs.empty())
+    {
+        nodeIDs.push_back(0);
+        nodeCPUs.push_back(initialCPUs);
+    }
+
+    numaEnabled = true;
+    return getNumNodes();
+}
+
+//
+bool NUMA::isEnabled()
+{
+    return numaEnabled;
+}
+
+//
+int NUMA::getNumNodes()
+{
+    return nodeCPUs.empty() ? 1 : (int)nodeCPUs.size();
+}
+
+//
+bool NUMA::bindThreadToNode(int node)
+{
+    if(!numaEnabled || node < 0 || node >= getNumNodes())
+        return false;
+    return sched_setaffinity(0, sizeof(cpu_set_t), &nodeCPUs[node]) == 0;
+}
+
+//
+void NUMA::unbindThread()
+{
+    if(numaEnabled)
+        sched_setaffinity(0, sizeof(cpu_set_t), &initialCPUs);
+}
+
+//
+bool NUMA::interleave(const void* pData, size_t numBytes)
+{
+    if(!numaEnabled || getNumNodes() < 2 || numBytes == 0)
+        return true;
+
+#ifdef SYS_mbind
+    // mbind works on whole pages
+    uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)pData & ~(pageSize - 1);
+    uintptr_t end = ((uintptr_t)pData + numBytes + pageSize - 1) & ~(pageSize - 1);
+
+    unsigned long mask = 0;
+    for(size_t i = 0; i < nodeIDs.size(); ++i)
+    {
+        if(nodeIDs[i] < (int)(8 * sizeof(mask)))
+            mask |= 1UL << nodeIDs[i];
+    }
+
+    return syscall(SYS_mbind, start, end - start, NUMA_MPOL_INTERLEAVE, &mask, 8 * sizeof(mask), NUMA_MPOL_MF_MOVE) == 0;
+#else
+    return false;
+#endif
+}
+
+//
+size_t NUMA::getAvailableMemory()
+{
+    long pages = sysconf(_SC_AVPHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if(pages < 0 || pageSize < 0)
+        return 0;
+    return (size_t)pages * pageSize;
+}
@@ -0,0 +1,54 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// NUMA - Placement of threads and memory on the nodes
+// of a NUMA machine. The topology is read from sysfs and
+// the placement is done with sched_setaffinity and the
+// mbind system call, so libnuma is not required.
+//
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace NUMA
+{
+
+// Detect the nodes of the machine and turn on NUMA placement.
+// Returns the number of nodes, 1 if the machine is not NUMA.
+int enable();
+
+// Returns true if enable() was called
+bool isEnabled();
+
+int getNumNodes();
+
+// Worker threads are spread over the nodes in turn
+inline int getNodeForThread(size_t threadIdx) { return threadIdx % getNumNodes(); }
+
+// Restrict the calling thread to the CPUs of node. Returns false on failure.
+bool bindThreadToNode(int node);
+
+// Allow the calling thread to run on every CPU it could use at startup
+void unbindThread();
+
+// Spread the pages of the memory range over all nodes, moving pages that
+// are already placed. Returns false if the kernel refused the request.
+bool interleave(const void* pData, size_t numBytes);
+
+// Convenience wrapper for the storage of a vector
+template<class T, class Alloc>
+inline bool interleave(const std::vector<T, Alloc>& v)
+{
+    return v.empty() || interleave(&v[0], v.size() * sizeof(T));
+}
+
+// Amount of free memory in bytes, used to decide whether an index can be replicated
+size_t getAvailableMemory();
+
+};
+
+#endif
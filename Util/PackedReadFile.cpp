@@ -0,0 +1,529 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedReadFile - Binary file of reads with the bases
+// packed into 2 bits each
+//
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <sstream>
+#include "PackedReadFile.h"
+#include "Quality.h"
+
+// The four bases held by each byte of the packed codes, lowest bits first
+struct PackedBaseTable
+{
+    PackedBaseTable()
+    {
+        for(int i = 0; i < 256; ++i)
+        {
+            for(int j = 0; j < 4; ++j)
+                bases[i][j] = "ACGT"[(i >> (2 * j)) & 3];
+        }
+    }
+
+    char bases[256][4];
+};
+
+static const PackedBaseTable s_baseTable;
+
+// Number of 8 byte words needed to hold n bytes
+static inline size_t toWords(size_t n)
+{
+    return (n + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+}
+
+//
+bool isPackedReads(const std::string& filename)
+{
+    size_t suffixLength = sizeof(PACKED_READS_EXT) - 1;
+    return filename.length() >= suffixLength && suffix(filename, suffixLength) == PACKED_READS_EXT;
+}
+
+//
+PackedReadFile::PackedReadFile(const std::string& filename) : m_filename(filename), m_pData(NULL), m_size(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error: could not open " << filename << " for read\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_size = st.st_size;
+    if(m_size >= sizeof(PackedReadsHeader))
+        m_pData = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(m_pData == NULL || m_pData == MAP_FAILED)
+    {
+        std::cerr << "Error: could not map " << filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_pHeader = (const PackedReadsHeader*)m_pData;
+    if(m_pHeader->magic != PACKED_READS_MAGIC || m_pHeader->version != PACKED_READS_VERSION)
+    {
+        std::cerr << "Error: " << filename << " is not a packed read file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // Find the start of each section
+    const uint64_t* pWord = (const uint64_t*)(m_pHeader + 1);
+    size_t numOffsets = m_pHeader->numReads + 1;
+
+    m_pBases = pWord;
+    pWord += (m_pHeader->numBases + 31) / 32;
+
+    m_pAmbiguous = pWord;
+    pWord += m_pHeader->numAmbiguous;
+
+    m_pSeqOffsets = NULL;
+    if(!(m_pHeader->flags & PRF_FIXED_LENGTH))
+    {
+        m_pSeqOffsets = pWord;
+        pWord += numOffsets;
+    }
+
+    m_pIDOffsets = pWord;
+    pWord += numOffsets;
+
+    m_pIDPool = (const char*)pWord;
+    pWord += toWords(m_pHeader->idPoolSize);
+
+    m_pQualities = NULL;
+    size_t expectedSize = (const char*)pWord - (const char*)m_pData;
+    if(m_pHeader->flags & PRF_QUALITY)
+    {
+        m_pQualities = (const char*)pWord;
+        expectedSize += m_pHeader->numBases;
+    }
+
+    if(m_size < expectedSize)
+    {
+        std::cerr << "Error: " << filename << " is truncated (" << m_size << " of " << expectedSize << " bytes)\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+PackedReadFile::~PackedReadFile()
+{
+    munmap(m_pData, m_size);
+}
+
+//
+void PackedReadFile::getRead(size_t idx, SeqRecord& record) const
+{
+    getID(idx, record.id);
+
+    std::string seq;
+    getSequence(idx, seq);
+    record.seq = seq;
+
+    if(hasQuality())
+        getQuality(idx, record.qual);
+    else
+        record.qual.clear();
+}
+
+//
+void PackedReadFile::getID(size_t idx, std::string& out) const
+{
+    assert(idx < getCount());
+    out.assign(m_pIDPool + m_pIDOffsets[idx], m_pIDOffsets[idx + 1] - m_pIDOffsets[idx]);
+}
+
+//
+void PackedReadFile::getSequence(size_t idx, std::string& out) const
+{
+    assert(idx < getCount());
+    uint64_t start = getStart(idx);
+    uint64_t end = getStart(idx + 1);
+    out.resize(end - start);
+
+    // Decode single bases up to a byte boundary then four bases per byte
+    const uint8_t* pBytes = (const uint8_t*)m_pBases;
+    uint64_t pos = start;
+    size_t outPos = 0;
+    for(; pos < end && pos % 4 != 0; ++pos)
+        out[outPos++] = "ACGT"[(pBytes[pos / 4] >> (2 * (pos % 4))) & 3];
+
+    for(; pos + 4 <= end; pos += 4, outPos += 4)
+        memcpy(&out[outPos], s_baseTable.bases[pBytes[pos / 4]], 4);
+
+    for(; pos < end; ++pos)
+        out[outPos++] = "ACGT"[(pBytes[pos / 4] >> (2 * (pos % 4))) & 3];
+
+    // Restore the ambiguous bases of this read
+    const uint64_t* pAmbiguousEnd = m_pAmbiguous + m_pHeader->numAmbiguous;
+    const uint64_t* pIter = std::lower_bound(m_pAmbiguous, pAmbiguousEnd, start);
+    for(; pIter != pAmbiguousEnd && *pIter < end; ++pIter)
+        out[*pIter - start] = 'N';
+}
+
+//
+void PackedReadFile::getQuality(size_t idx, std::string& out) const
+{
+    assert(idx < getCount());
+    if(!hasQuality())
+    {
+        out.clear();
+        return;
+    }
+
+    uint64_t start = getStart(idx);
+    out.assign(m_pQualities + start, getStart(idx + 1) - start);
+}
+
+//
+void PackedReadFile::adviseSequential() const
+{
+    madvise(m_pData, m_size, MADV_SEQUENTIAL);
+}
+
+// Write an 8 byte word, the errors are checked when the file is closed
+static inline void writeWord(FILE* pFile, uint64_t word)
+{
+    fwrite(&word, sizeof(word), 1, pFile);
+}
+
+//
+PackedReadWriter::PackedReadWriter() : m_pFile(NULL), m_currWord(0)
+{
+    for(int i = 0; i < NUM_SECTIONS; ++i)
+        m_pSpillFiles[i] = NULL;
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+//
+PackedReadWriter::~PackedReadWriter()
+{
+    close();
+}
+
+//
+bool PackedReadWriter::open(const std::string& filename)
+{
+    m_pFile = fopen(filename.c_str(), "wb");
+    if(m_pFile == NULL)
+        return false;
+
+    // The spill files are unlinked as soon as they are created so they
+    // do not outlive the run, their space is freed when they are closed
+    for(int i = 0; i < NUM_SECTIONS; ++i)
+    {
+        std::stringstream spillName;
+        spillName << filename << ".section" << i << ".tmp";
+        m_pSpillFiles[i] = fopen(spillName.str().c_str(), "w+b");
+        if(m_pSpillFiles[i] == NULL)
+        {
+            close();
+            return false;
+        }
+        unlink(spillName.str().c_str());
+    }
+
+    m_filename = filename;
+    memset(&m_header, 0, sizeof(m_header));
+    m_header.magic = PACKED_READS_MAGIC;
+    m_header.version = PACKED_READS_VERSION;
+    m_header.flags = PRF_FIXED_LENGTH;
+    m_currWord = 0;
+
+    // Reserve the header, it is written once the counts are known
+    fwrite(&m_header, sizeof(m_header), 1, m_pFile);
+
+    // Each offset section starts with the sentinel for the first read
+    writeWord(m_pSpillFiles[SEC_SEQ_OFFSETS], 0);
+    writeWord(m_pSpillFiles[SEC_ID_OFFSETS], 0);
+    return true;
+}
+
+//
+void PackedReadWriter::addRead(const std::string& id, const std::string& seq, const std::string& qual)
+{
+    assert(m_pFile != NULL);
+    uint64_t pos = m_header.numBases;
+
+    // Keep one quality value per base. The reads added before the first
+    // read with qualities get the default value.
+    const char defaultQual = Quality::phred2char(DEFAULT_QUAL_SCORE);
+    FILE* pQualFile = m_pSpillFiles[SEC_QUALITY];
+    if(!qual.empty() && !(m_header.flags & PRF_QUALITY))
+    {
+        m_header.flags |= PRF_QUALITY;
+        for(uint64_t i = 0; i < pos; ++i)
+            putc(defaultQual, pQualFile);
+    }
+
+    if(m_header.flags & PRF_QUALITY)
+    {
+        size_t numQual = std::min(qual.size(), seq.size());
+        fwrite(qual.data(), 1, numQual, pQualFile);
+        for(size_t i = numQual; i < seq.size(); ++i)
+            putc(defaultQual, pQualFile);
+    }
+
+    // Pack the bases, writing each word of the file once it is full
+    for(size_t i = 0; i < seq.size(); ++i, ++pos)
+    {
+        uint64_t code;
+        switch(seq[i])
+        {
+            case 'A': case 'a': code = 0; break;
+            case 'C': case 'c': code = 1; break;
+            case 'G': case 'g': code = 2; break;
+            case 'T': case 't': code = 3; break;
+            default:
+                code = 0;
+                writeWord(m_pSpillFiles[SEC_AMBIGUOUS], pos);
+                ++m_header.numAmbiguous;
+                break;
+        }
+        m_currWord |= code << (2 * (pos % 32));
+        if(pos % 32 == 31)
+        {
+            writeWord(m_pFile, m_currWord);
+            m_currWord = 0;
+        }
+    }
+
+    // The offsets are omitted if every read has the same length
+    if(m_header.numReads == 0)
+        m_header.readLength = seq.size();
+    else if(seq.size() != m_header.readLength)
+        m_header.flags &= ~PRF_FIXED_LENGTH;
+
+    ++m_header.numReads;
+    m_header.numBases = pos;
+    writeWord(m_pSpillFiles[SEC_SEQ_OFFSETS], pos);
+
+    fwrite(id.data(), 1, id.size(), m_pSpillFiles[SEC_ID_POOL]);
+    m_header.idPoolSize += id.size();
+    writeWord(m_pSpillFiles[SEC_ID_OFFSETS], m_header.idPoolSize);
+}
+
+//
+bool PackedReadWriter::close()
+{
+    if(m_pFile == NULL)
+        return true;
+
+    // The spill files are missing if the open failed
+    bool bOpened = m_pSpillFiles[NUM_SECTIONS - 1] != NULL;
+    if(bOpened)
+    {
+        if(m_header.numBases % 32 != 0)
+            writeWord(m_pFile, m_currWord);
+
+        if(m_header.numReads == 0)
+            m_header.flags &= ~PRF_FIXED_LENGTH;
+        if(!(m_header.flags & PRF_FIXED_LENGTH))
+            m_header.readLength = 0;
+
+        appendSection(SEC_AMBIGUOUS);
+        if(!(m_header.flags & PRF_FIXED_LENGTH))
+            appendSection(SEC_SEQ_OFFSETS);
+        appendSection(SEC_ID_OFFSETS);
+        appendSection(SEC_ID_POOL);
+
+        const char zeros[sizeof(uint64_t)] = { 0 };
+        fwrite(zeros, 1, (sizeof(uint64_t) - m_header.idPoolSize % sizeof(uint64_t)) % sizeof(uint64_t), m_pFile);
+
+        if(m_header.flags & PRF_QUALITY)
+            appendSection(SEC_QUALITY);
+
+        fseek(m_pFile, 0, SEEK_SET);
+        fwrite(&m_header, sizeof(m_header), 1, m_pFile);
+    }
+
+    bool bError = ferror(m_pFile) != 0;
+    bError = fclose(m_pFile) != 0 || bError;
+    m_pFile = NULL;
+    for(int i = 0; i < NUM_SECTIONS; ++i)
+    {
+        if(m_pSpillFiles[i] == NULL)
+            continue;
+        bError = ferror(m_pSpillFiles[i]) != 0 || bError;
+        fclose(m_pSpillFiles[i]);
+        m_pSpillFiles[i] = NULL;
+    }
+
+    if(bOpened && bError)
+    {
+        std::cerr << "Error: could not write " << m_filename << "\n";
+        return false;
+    }
+    return true;
+}
+
+//
+void PackedReadWriter::appendSection(Section section)
+{
+    FILE* pSpill = m_pSpillFiles[section];
+    fflush(pSpill);
+    rewind(pSpill);
+
+    std::vector<char> buffer(1 << 20);
+    size_t numRead;
+    while((numRead = fread(&buffer[0], 1, buffer.size(), pSpill)) > 0)
+        fwrite(&buffer[0], 1, numRead, m_pFile);
+}
+
+//
+PackedReadOutputBuffer::PackedReadOutputBuffer() : m_buffer(BUFFER_SIZE), m_state(PS_NONE)
+{
+    setp(&m_buffer[0], &m_buffer[0] + m_buffer.size());
+}
+
+//
+PackedReadOutputBuffer::~PackedReadOutputBuffer()
+{
+    close();
+}
+
+//
+bool PackedReadOutputBuffer::open(const std::string& filename)
+{
+    return m_writer.open(filename);
+}
+
+//
+bool PackedReadOutputBuffer::close()
+{
+    if(!m_writer.is_open())
+        return true;
+
+    parseBuffer();
+    if(!m_partialLine.empty())
+    {
+        parseLine(m_partialLine.data(), m_partialLine.size());
+        m_partialLine.clear();
+    }
+
+    if(m_state == PS_FASTA)
+        addRecord();
+
+    // The sections of the file are only complete once the writer is closed,
+    // so a failure here loses the whole output of the stage
+    if(!m_writer.close())
+        exit(EXIT_FAILURE);
+    return true;
+}
+
+//
+int PackedReadOutputBuffer::overflow(int c)
+{
+    if(!m_writer.is_open())
+        return EOF;
+
+    parseBuffer();
+    if(c != EOF)
+    {
+        *pptr() = c;
+        pbump(1);
+    }
+    return 0;
+}
+
+//
+void PackedReadOutputBuffer::parseBuffer()
+{
+    const char* pCurr = pbase();
+    const char* pEnd = pptr();
+    while(pCurr < pEnd)
+    {
+        const char* pNewline = (const char*)memchr(pCurr, '\n', pEnd - pCurr);
+        if(pNewline == NULL)
+        {
+            m_partialLine.append(pCurr, pEnd - pCurr);
+            break;
+        }
+
+        if(m_partialLine.empty())
+        {
+            parseLine(pCurr, pNewline - pCurr);
+        }
+        else
+        {
+            m_partialLine.append(pCurr, pNewline - pCurr);
+            parseLine(m_partialLine.data(), m_partialLine.size());
+            m_partialLine.clear();
+        }
+        pCurr = pNewline + 1;
+    }
+    setp(&m_buffer[0], &m_buffer[0] + m_buffer.size());
+}
+
+// Records are parsed the same way as SeqReader: the id is the first word
+// of the header and the other header fields are dropped
+void PackedReadOutputBuffer::parseLine(const char* pLine, size_t len)
+{
+    switch(m_state)
+    {
+        case PS_FASTQ_SEQ:
+            m_seq.assign(pLine, len);
+            m_state = PS_FASTQ_SEPARATOR;
+            return;
+        case PS_FASTQ_SEPARATOR:
+            m_state = PS_FASTQ_QUAL;
+            return;
+        case PS_FASTQ_QUAL:
+            m_qual.assign(pLine, len);
+            addRecord();
+            return;
+        case PS_FASTA:
+            if(len == 0 || (pLine[0] != '>' && pLine[0] != '@'))
+            {
+                m_seq.append(pLine, len);
+                return;
+            }
+            addRecord();
+            break;
+        case PS_NONE:
+            break;
+    }
+
+    if(len == 0 || (pLine[0] != '>' && pLine[0] != '@'))
+        return;
+
+    size_t idEnd = 1;
+    while(idEnd < len && pLine[idEnd] != ' ' && pLine[idEnd] != '\t')
+        ++idEnd;
+    m_id.assign(pLine + 1, idEnd - 1);
+    m_seq.clear();
+    m_qual.clear();
+    m_state = pLine[0] == '>' ? PS_FASTA : PS_FASTQ_SEQ;
+}
+
+//
+void PackedReadOutputBuffer::addRecord()
+{
+    // Like SeqReader, FASTA records without sequence are skipped
+    if(m_state != PS_FASTA || !m_seq.empty())
+        m_writer.addRead(m_id, m_seq, m_qual);
+    m_state = PS_NONE;
+}
+
+//
+PackedReadOutputStream::PackedReadOutputStream(const std::string& filename) : std::ostream(NULL)
+{
+    rdbuf(&m_buf);
+    if(!m_buf.open(filename))
+        setstate(std::ios_base::failbit);
+}
+
+//
+void PackedReadOutputStream::close()
+{
+    if(!m_buf.close())
+        setstate(std::ios_base::failbit);
+}
@@ -0,0 +1,210 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedReadFile - Binary file of reads with the bases
+// packed into 2 bits each, used to pass reads between
+// the stages of the assembler. It is mapped into memory
+// and the reads accessed by index without parsing.
+//
+// File layout, all values are little endian uint64_t
+// and every section starts on an 8 byte boundary:
+//   header         PackedReadsHeader
+//   bases          (numBases + 31) / 32 words of 2-bit codes
+//   ambiguous      numAmbiguous sorted positions of the bases read as 'N'
+//   offsets        numReads + 1 start positions of the reads in
+//                  the bases, omitted if every read has readLength bases
+//   id offsets     numReads + 1 start positions of the ids in the id pool
+//   id pool        idPoolSize characters
+//   qualities      numBases characters, if PRF_QUALITY is set
+//
+// The stages write this format when an output file has the
+// PACKED_READS_EXT extension (see createWriter) and SeqReader
+// reads it transparently.
+//
+#ifndef PACKEDREADFILE_H
+#define PACKEDREADFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Util.h"
+
+#define PACKED_READS_EXT ".prd"
+
+// "FMOCPRD1"
+const uint64_t PACKED_READS_MAGIC = 0x31445250434F4D46ULL;
+const uint64_t PACKED_READS_VERSION = 2;
+
+// Header flags
+const uint64_t PRF_QUALITY = 1;
+const uint64_t PRF_FIXED_LENGTH = 2;
+
+struct PackedReadsHeader
+{
+    uint64_t magic;
+    uint64_t version;
+    uint64_t numReads;
+    uint64_t numBases;
+    uint64_t numAmbiguous;
+    uint64_t idPoolSize;
+    uint64_t flags;
+    uint64_t readLength;
+};
+
+// Returns true if the filename has the packed read extension
+bool isPackedReads(const std::string& filename);
+
+// Read-only view of a packed read file mapped into memory
+class PackedReadFile
+{
+    public:
+        PackedReadFile(const std::string& filename);
+        ~PackedReadFile();
+
+        inline size_t getCount() const { return m_pHeader->numReads; }
+        inline size_t countSumLengths() const { return m_pHeader->numBases; }
+        inline bool hasQuality() const { return m_pQualities != NULL; }
+
+        inline size_t getReadLength(size_t idx) const
+        {
+            assert(idx < getCount());
+            return getStart(idx + 1) - getStart(idx);
+        }
+
+        // Fill in record with the read at idx
+        void getRead(size_t idx, SeqRecord& record) const;
+
+        // Decode the parts of the read at idx into the output strings, reusing their buffers
+        void getID(size_t idx, std::string& out) const;
+        void getSequence(size_t idx, std::string& out) const;
+        void getQuality(size_t idx, std::string& out) const;
+
+        // Tell the kernel the reads will be read in order
+        void adviseSequential() const;
+
+    private:
+
+        inline uint64_t getStart(size_t idx) const
+        {
+            return m_pSeqOffsets != NULL ? m_pSeqOffsets[idx] : idx * m_pHeader->readLength;
+        }
+
+        std::string m_filename;
+        void* m_pData;
+        size_t m_size;
+
+        const PackedReadsHeader* m_pHeader;
+        const uint64_t* m_pSeqOffsets;
+        const uint64_t* m_pBases;
+        const uint64_t* m_pAmbiguous;
+        const uint64_t* m_pIDOffsets;
+        const char* m_pIDPool;
+        const char* m_pQualities;
+};
+
+// Writer of a packed read file. The bases are written to the file as
+// the reads are added. The other sections are spilled to unlinked
+// files next to the output and appended when the writer is closed,
+// so only a few buffers are held in memory.
+class PackedReadWriter
+{
+    public:
+        PackedReadWriter();
+        ~PackedReadWriter();
+
+        bool open(const std::string& filename);
+        void addRead(const std::string& id, const std::string& seq, const std::string& qual);
+
+        // Append the spilled sections and the header.
+        // Returns false if the file could not be written.
+        bool close();
+        bool is_open() const { return m_pFile != NULL; }
+
+    private:
+
+        enum Section
+        {
+            SEC_AMBIGUOUS,
+            SEC_SEQ_OFFSETS,
+            SEC_ID_OFFSETS,
+            SEC_ID_POOL,
+            SEC_QUALITY,
+            NUM_SECTIONS
+        };
+
+        // Copy a spilled section to the end of the file
+        void appendSection(Section section);
+
+        std::string m_filename;
+        FILE* m_pFile;
+        FILE* m_pSpillFiles[NUM_SECTIONS];
+
+        PackedReadsHeader m_header;
+
+        // Bases of the last, partially filled word
+        uint64_t m_currWord;
+};
+
+// Stream buffer that parses the FASTA or FASTQ records written to it
+// and stores them in a packed read file with a PackedReadWriter.
+// The program exits with an error if the file cannot be written.
+class PackedReadOutputBuffer : public std::streambuf
+{
+    public:
+        PackedReadOutputBuffer();
+        ~PackedReadOutputBuffer();
+
+        bool open(const std::string& filename);
+
+        // Parse the last record and write the file, exiting if it cannot be written
+        bool close();
+        bool is_open() const { return m_writer.is_open(); }
+
+    protected:
+        virtual int overflow(int c);
+
+    private:
+
+        enum ParseState
+        {
+            PS_NONE,
+            PS_FASTA,
+            PS_FASTQ_SEQ,
+            PS_FASTQ_SEPARATOR,
+            PS_FASTQ_QUAL
+        };
+
+        static const size_t BUFFER_SIZE = 1 << 16;
+
+        // Split the buffered text into lines, keeping an incomplete last line for later
+        void parseBuffer();
+        void parseLine(const char* pLine, size_t len);
+        void addRecord();
+
+        PackedReadWriter m_writer;
+        std::vector<char> m_buffer;
+        std::string m_partialLine;
+
+        ParseState m_state;
+        std::string m_id;
+        std::string m_seq;
+        std::string m_qual;
+};
+
+//
+class PackedReadOutputStream : public std::ostream
+{
+    public:
+        PackedReadOutputStream(const std::string& filename);
+        ~PackedReadOutputStream() { m_buf.close(); }
+        void close();
+
+    private:
+        PackedReadOutputBuffer m_buf;
+};
+
+#endif
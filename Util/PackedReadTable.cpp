@@ -0,0 +1,128 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedReadTable - A 0-indexed table of reads with
+// the bases packed into 2 bits each
+//
+#include <algorithm>
+#include "PackedReadTable.h"
+#include "Quality.h"
+
+//
+PackedReadTable::PackedReadTable()
+{
+    clear();
+}
+
+//
+void PackedReadTable::addRead(const SeqRecord& r)
+{
+    addRead(r.id, r.seq.toString(), r.qual);
+}
+
+//
+void PackedReadTable::addRead(const std::string& id, const std::string& seq, const std::string& qual)
+{
+    uint64_t pos = m_seqOffsets.back();
+
+    // Keep one quality value per base. The reads added before the first
+    // read with qualities get the default value.
+    if(!qual.empty() || hasQuality())
+    {
+        const char defaultQual = Quality::phred2char(DEFAULT_QUAL_SCORE);
+        if(!hasQuality())
+            m_qualPool.assign(pos, defaultQual);
+        m_qualPool.append(qual, 0, std::min(qual.size(), seq.size()));
+        if(qual.size() < seq.size())
+            m_qualPool.append(seq.size() - qual.size(), defaultQual);
+    }
+
+    m_packedBases.resize((pos + seq.size() + BASES_PER_WORD - 1) / BASES_PER_WORD, 0);
+
+    for(size_t i = 0; i < seq.size(); ++i, ++pos)
+    {
+        uint64_t code;
+        switch(seq[i])
+        {
+            case 'A': case 'a': code = 0; break;
+            case 'C': case 'c': code = 1; break;
+            case 'G': case 'g': code = 2; break;
+            case 'T': case 't': code = 3; break;
+            default:
+                code = 0;
+                m_nPositions.push_back(pos);
+                break;
+        }
+        m_packedBases[pos / BASES_PER_WORD] |= code << (2 * (pos % BASES_PER_WORD));
+    }
+    m_seqOffsets.push_back(pos);
+
+    m_idPool.append(id);
+    m_idOffsets.push_back(m_idPool.size());
+
+}
+
+//
+void PackedReadTable::getRead(size_t idx, SeqRecord& record) const
+{
+    record.id = getID(idx);
+    record.seq = getSequence(idx);
+    record.qual = getQuality(idx);
+}
+
+//
+std::string PackedReadTable::getID(size_t idx) const
+{
+    assert(idx < getCount());
+    return m_idPool.substr(m_idOffsets[idx], m_idOffsets[idx + 1] - m_idOffsets[idx]);
+}
+
+//
+std::string PackedReadTable::getSequence(size_t idx) const
+{
+    assert(idx < getCount());
+    uint64_t start = m_seqOffsets[idx];
+    uint64_t end = m_seqOffsets[idx + 1];
+
+    std::string seq(end - start, 'A');
+    for(uint64_t pos = start; pos < end; ++pos)
+        seq[pos - start] = "ACGT"[getCode(pos)];
+
+    // Restore the ambiguous bases of this read
+    std::vector<uint64_t>::const_iterator iter = std::lower_bound(m_nPositions.begin(), m_nPositions.end(), start);
+    for(; iter != m_nPositions.end() && *iter < end; ++iter)
+        seq[*iter - start] = 'N';
+    return seq;
+}
+
+//
+std::string PackedReadTable::getQuality(size_t idx) const
+{
+    assert(idx < getCount());
+    if(!hasQuality())
+        return "";
+    return m_qualPool.substr(m_seqOffsets[idx], getReadLength(idx));
+}
+
+//
+size_t PackedReadTable::getMemoryUsage() const
+{
+    return sizeof(uint64_t) * (m_packedBases.size() + m_seqOffsets.size() + m_nPositions.size() +
+                               m_idOffsets.size()) +
+           m_idPool.size() + m_qualPool.size();
+}
+
+//
+void PackedReadTable::clear()
+{
+    std::vector<uint64_t>().swap(m_packedBases);
+    std::vector<uint64_t>().swap(m_nPositions);
+    std::string().swap(m_idPool);
+    std::string().swap(m_qualPool);
+
+    // Each offset vector starts with the sentinel for the first read
+    m_seqOffsets.assign(1, 0);
+    m_idOffsets.assign(1, 0);
+}
@@ -0,0 +1,78 @@
+//----------------------------------------------
+// Copyright 2014 National Chung Cheng University
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedReadTable - A 0-indexed table of reads with
+// the bases packed into 2 bits each. Non-ACGT bases are
+// recorded in a separate sorted list of positions and
+// read back as 'N'. Read ids and quality strings are
+// kept in contiguous string pools. Once a read has
+// qualities every read has one quality value per base,
+// so the qualities are addressed by the base offsets.
+// Missing values are filled with DEFAULT_QUAL_SCORE and
+// extra ones are dropped.
+//
+#ifndef PACKEDREADTABLE_H
+#define PACKEDREADTABLE_H
+
+#include "Util.h"
+
+class PackedReadTable
+{
+    public:
+        PackedReadTable();
+
+        //
+        void addRead(const SeqRecord& r);
+        void addRead(const std::string& id, const std::string& seq, const std::string& qual = "");
+
+        // Fill in record with the read at idx
+        void getRead(size_t idx, SeqRecord& record) const;
+
+        std::string getID(size_t idx) const;
+        std::string getSequence(size_t idx) const;
+        std::string getQuality(size_t idx) const;
+
+        inline size_t getReadLength(size_t idx) const
+        {
+            assert(idx < getCount());
+            return m_seqOffsets[idx + 1] - m_seqOffsets[idx];
+        }
+
+        inline size_t getCount() const { return m_seqOffsets.size() - 1; }
+        inline size_t countSumLengths() const { return m_seqOffsets.back(); }
+        inline bool hasQuality() const { return !m_qualPool.empty(); }
+
+        // Return the number of bytes used by the table
+        size_t getMemoryUsage() const;
+
+        void clear();
+
+    private:
+
+        // 2-bit codes in lexicographic order
+        static const size_t BASES_PER_WORD = 32;
+
+        inline uint8_t getCode(size_t pos) const
+        {
+            return (m_packedBases[pos / BASES_PER_WORD] >> (2 * (pos % BASES_PER_WORD))) & 3;
+        }
+
+        std::vector<uint64_t> m_packedBases;
+
+        // Start of each read in the packed bases, with a sentinel at the end
+        std::vector<uint64_t> m_seqOffsets;
+
+        // Sorted positions of the non-ACGT bases
+        std::vector<uint64_t> m_nPositions;
+
+        // Id pool, with the start offset of each read
+        std::string m_idPool;
+        std::vector<uint64_t> m_idOffsets;
+
+        // Quality values of the bases, empty if no read has qualities
+        std::string m_qualPool;
+};
+
+#endif
@@ -28,10 +28,12 @@ ReadInfoTable::ReadInfoTable(std::string filename,
     {
         m_lengths.reserve(num_expected);
         if(!m_numericIDs)
-            m_ids.reserve(num_expected);
-			
+            m_idOffsets.reserve(num_expected + 1);
     }
 
+    if(!m_numericIDs)
+        m_idOffsets.push_back(0);
+
     //SeqReader reader(filename);
 	SeqReader reader(filename,3);	//skip all validations for speed, by YT
     SeqRecord sr;
@@ -42,9 +44,15 @@ ReadInfoTable::ReadInfoTable(std::string filename,
         m_lengths.push_back(sr.seq.length());
         if(!m_numericIDs)
         {
-            m_ids.push_back(sr.id);
-        }		
+            m_idPool.append(sr.id);
+            m_idOffsets.push_back(m_idPool.size());
+        }
     }
+
+    // Release the slack left by growing the vectors
+    std::vector<uint32_t>(m_lengths).swap(m_lengths);
+    std::vector<uint64_t>(m_idOffsets).swap(m_idOffsets);
+    std::string(m_idPool).swap(m_idPool);
 }
 
 // 
@@ -65,8 +73,8 @@ std::string ReadInfoTable::getReadID(size_t idx) const
 {
     if(!m_numericIDs)
     {
-        assert(idx < m_ids.size());
-        return m_ids[idx];
+        assert(idx + 1 < m_idOffsets.size());
+        return m_idPool.substr(m_idOffsets[idx], m_idOffsets[idx + 1] - m_idOffsets[idx]);
     }
     else
     {
@@ -103,5 +111,6 @@ size_t ReadInfoTable::countSumLengths() const
 void ReadInfoTable::clear()
 {
     m_lengths.clear();
-    m_ids.clear();
+    m_idPool.clear();
+    m_idOffsets.clear();
 }
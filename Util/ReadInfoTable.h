@@ -7,12 +7,16 @@
 // ReadInfoTable - A 0-indexed table of ID, length pairs
 // Used to convert suffix array hits to overlaps
 //
+// The ids are concatenated into a single pool indexed by
+// offsets and the lengths are held as 32-bit integers, so
+// the table costs about 12 bytes plus the id characters
+// per read instead of a std::string for every id.
+//
 #ifndef READINFOTABLE_H
 #define READINFOTABLE_H
 #include "Util.h"
 #include "SeqReader.h"
 #include <map>
-#include "Bigraph.h"
 
 
 enum ReadInfoOption
@@ -49,16 +53,15 @@ class ReadInfoTable
         size_t getCount() const;
         size_t countSumLengths() const;
         void clear();
-		
-		//Contig ID methods
-		void addVertex(size_t idx, Vertex* pVertex, ReadOnContig roc) ;
-		ThreadSafeList<std::pair<Vertex*, ReadOnContig> > getList(size_t idx) ;
 
     private:
 
-        std::vector<int> m_lengths;
-        std::vector<std::string> m_ids;
-		
+        std::vector<uint32_t> m_lengths;
+
+        // The id of read i is m_idPool[m_idOffsets[i], m_idOffsets[i+1])
+        std::string m_idPool;
+        std::vector<uint64_t> m_idOffsets;
+
         bool m_numericIDs;
 };
 
@@ -8,39 +8,128 @@
 //
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
 #include "SeqReader.h"
 #include "Util.h"
 
-SeqReader::SeqReader(std::string filename, uint32_t flags) : m_flags(flags)
+SeqReader::SeqReader(std::string filename, uint32_t flags) : m_pHandle(NULL),
+                                                             m_flags(flags),
+                                                             m_pPacked(NULL),
+                                                             m_packedIdx(0),
+                                                             m_pBuffer(NULL),
+                                                             m_bufferSize(BLOCK_SIZE),
+                                                             m_bufferPos(0),
+                                                             m_bufferEnd(0),
+                                                             m_bEOF(false)
 {
+    if(isPackedReads(filename))
+    {
+        m_pPacked = new PackedReadFile(filename);
+        m_pPacked->adviseSequential();
+        return;
+    }
+
     m_pHandle = createReader(filename);
+    m_pBuffer = (char*)malloc(m_bufferSize);
+    assert(m_pBuffer != NULL);
 }
     
 SeqReader::~SeqReader()
 {
+    free(m_pBuffer);
     delete m_pHandle;
+    delete m_pPacked;
+}
+
+//
+void SeqReader::fillBuffer()
+{
+    size_t remaining = m_bufferEnd - m_bufferPos;
+    if(m_bufferPos > 0 && remaining > 0)
+        memmove(m_pBuffer, m_pBuffer + m_bufferPos, remaining);
+    m_bufferPos = 0;
+    m_bufferEnd = remaining;
+
+    // A line longer than the buffer, make room for the next block
+    if(m_bufferEnd == m_bufferSize)
+    {
+        m_bufferSize *= 2;
+        m_pBuffer = (char*)realloc(m_pBuffer, m_bufferSize);
+        assert(m_pBuffer != NULL);
+    }
+
+    m_pHandle->read(m_pBuffer + m_bufferEnd, m_bufferSize - m_bufferEnd);
+    m_bufferEnd += m_pHandle->gcount();
+    if(!m_pHandle->good())
+        m_bEOF = true;
+}
+
+//
+bool SeqReader::readLine(const char*& pLine, size_t& len)
+{
+    while(1)
+    {
+        char* pStart = m_pBuffer + m_bufferPos;
+        size_t avail = m_bufferEnd - m_bufferPos;
+        const char* pNewline = (const char*)memchr(pStart, '\n', avail);
+        if(pNewline != NULL)
+        {
+            pLine = pStart;
+            len = pNewline - pStart;
+            m_bufferPos += len + 1;
+            return true;
+        }
+
+        if(m_bEOF)
+        {
+            // The last line of a file may lack the newline
+            if(avail == 0)
+                return false;
+            pLine = pStart;
+            len = avail;
+            m_bufferPos = m_bufferEnd;
+            return true;
+        }
+        fillBuffer();
+    }
+}
+
+//
+int SeqReader::peekChar()
+{
+    while(m_bufferPos == m_bufferEnd)
+    {
+        if(m_bEOF)
+            return EOF;
+        fillBuffer();
+    }
+    return m_pBuffer[m_bufferPos];
 }
 
 // Extract an element from the file
 // Return true if successful
 bool SeqReader::get(SeqRecord& sr)
 {
+    if(m_pPacked != NULL)
+        return getPacked(sr);
+
     static int warn_count = 0;
     const int MAX_WARN = 10;
     RecordType rt = RT_UNKNOWN;
-    std::string header;
-    while(m_pHandle->good())
+
+    const char* pLine;
+    size_t len;
+    while(readLine(pLine, len))
     {
-        getline(*m_pHandle, header);
-        if(header.empty())
+        if(len == 0)
             continue;
 
-        if(header[0] == '>')
+        if(pLine[0] == '>')
         {
             rt = RT_FASTA;
             break;
         }
-        else if(header[0] == '@')
+        else if(pLine[0] == '@')
         {
             rt = RT_FASTQ;
             break;
@@ -52,72 +141,75 @@ bool SeqReader::get(SeqRecord& sr)
         // No valid start found
         return false;
     }
+    m_header.assign(pLine, len);
     
     // Parse the rest of the record
     bool validRecord = false;
-    std::string seq;
-    std::string qual;
+    m_seq.clear();
+    m_qual.clear();
 
     if(rt == RT_FASTA)
     {
-        std::string temp;
-        while(m_pHandle->good() && m_pHandle->peek() != '>' && m_pHandle->peek() != '@')
+        // Append the sequence lines up to the start of the next record
+        int c;
+        while((c = peekChar()) != EOF && c != '>' && c != '@')
         {
-            getline(*m_pHandle, temp);
-            if(m_pHandle->good() && temp.size() > 0)
-                seq.append(temp);
+            readLine(pLine, len);
+            m_seq.append(pLine, len);
         }
 
         // The record is valid if we extracted at least 1 bp for the sequence
-        // at this point the eof may have been hit but we still want the data
-        validRecord = seq.size() > 0; 
+        validRecord = m_seq.size() > 0; 
     }
     else if(rt == RT_FASTQ)
     {
-        std::string temp;
-        getline(*m_pHandle, seq);
-        getline(*m_pHandle, temp); //discard
-        getline(*m_pHandle, qual);
+        // FASTQ is required to have 4 fields, the separator line is discarded
+        validRecord = readLine(pLine, len);
+        if(validRecord)
+        {
+            m_seq.assign(pLine, len);
+            validRecord = readLine(pLine, len) && readLine(pLine, len);
+            if(validRecord)
+                m_qual.assign(pLine, len);
+        }
 
-        // FASTQ is required to have 4 fields, we must not have hit the EOF by this point
-        if(seq.size() != qual.size() && warn_count++ < MAX_WARN)
+        if(m_seq.size() != m_qual.size() && warn_count++ < MAX_WARN)
         {
-            std::cerr << "Warning, FASTQ quality string is not the same length as the sequence string for read " << header << "\n";
+            std::cerr << "Warning, FASTQ quality string is not the same length as the sequence string for read " << m_header << "\n";
         }
         
         // Fix [Issue GH-3]: Handle FASTQ records that have no sequence or quality value. We only
         // emit a warning here as long as the record is properly formed.
-        if(seq.empty() || qual.empty())
+        if(m_seq.empty() || m_qual.empty())
         {
-            std::cerr << "Warning, read " << header << " has no sequence or quality values\n";
+            std::cerr << "Warning, read " << m_header << " has no sequence or quality values\n";
         }
-        validRecord = !m_pHandle->eof();
     }
 
     if(validRecord)
     {
         // Parse the id
-        size_t endPos = std::min(header.find_first_of(' '), header.find_first_of('\t'));
+        size_t endPos = std::min(m_header.find_first_of(' '), m_header.find_first_of('\t'));
         if(endPos != std::string::npos)
         {
             assert(endPos > 0);
-            sr.id = header.substr(1, endPos - 1);
+            sr.id.assign(m_header, 1, endPos - 1);
         }
         else
         {
-            sr.id = header.substr(1);
+            sr.id.assign(m_header, 1, std::string::npos);
         }
 
 		if( !(m_flags &SRF_SKIP_ALL_CHECK))
 		{
 			// Convert the sequence string to upper case
 			if( !(m_flags & SRF_KEEP_CASE) )
-				std::transform(seq.begin(), seq.end(), seq.begin(), ::toupper);
+				std::transform(m_seq.begin(), m_seq.end(), m_seq.begin(), ::toupper);
 
 			// If the validation flag is set, ensure that there aren't any non-ACGT bases
 			if( !(m_flags & SRF_NO_VALIDATION) )
 			{
-				if(seq.find_first_not_of("ACGT") != std::string::npos)
+				if(m_seq.find_first_not_of("ACGT") != std::string::npos)
 				{
 					std::cerr << "Error: read " << sr.id << " contains non-ACGT characters.\n";
 					std::cerr << "Please run sga preprocess on the data first.\n";
@@ -126,10 +218,33 @@ bool SeqReader::get(SeqRecord& sr)
 			}
 		}
 
-        sr.seq = seq;
-        sr.qual = qual;
+        sr.seq = m_seq;
+        sr.qual = m_qual;
 
     }
 
     return validRecord;
 }
+
+// The packed bases are upper case ACGT or N so only the validation applies
+bool SeqReader::getPacked(SeqRecord& sr)
+{
+    if(m_packedIdx == m_pPacked->getCount())
+        return false;
+
+    m_pPacked->getID(m_packedIdx, sr.id);
+    m_pPacked->getSequence(m_packedIdx, m_seq);
+    m_pPacked->getQuality(m_packedIdx, m_qual);
+    ++m_packedIdx;
+
+    if(!(m_flags & SRF_SKIP_ALL_CHECK) && !(m_flags & SRF_NO_VALIDATION) && m_seq.find('N') != std::string::npos)
+    {
+        std::cerr << "Error: read " << sr.id << " contains non-ACGT characters.\n";
+        std::cerr << "Please run sga preprocess on the data first.\n";
+        exit(EXIT_FAILURE);
+    }
+
+    sr.seq = m_seq;
+    sr.qual = m_qual;
+    return true;
+}
@@ -4,13 +4,18 @@
 // Released under the GPL license
 //-----------------------------------------------
 //
-// SeqReader - Reads fasta or fastq sequence files
+// SeqReader - Reads fasta or fastq sequence files.
+// The input is read in large blocks and split into lines
+// with memchr, the records are filled in from the block
+// without going through std::getline. Packed read files
+// are mapped into memory and decoded in order.
 //
 #ifndef SEQREADER_H
 #define SEQREADER_H
 
 #include <fstream>
 #include "Util.h"
+#include "PackedReadFile.h"
 
 enum RecordType
 {
@@ -32,8 +37,41 @@ class SeqReader
         bool get(SeqRecord& sr);
 
     private:
+
+        // Size of the blocks read from the file. The buffer grows
+        // when a single line does not fit.
+        static const size_t BLOCK_SIZE = 1 << 20;
+
+        // Set pLine and len to the next line without its newline. The pointer is
+        // valid until the next call. Returns false once the input is exhausted.
+        bool readLine(const char*& pLine, size_t& len);
+
+        // Return the next character without consuming it, or EOF
+        int peekChar();
+
+        // Move the unread data to the front of the buffer and read the next block
+        void fillBuffer();
+
+        // Fill in the next read of a packed read file
+        bool getPacked(SeqRecord& sr);
+
         std::istream* m_pHandle;
         uint32_t m_flags;
+
+        // Set instead of m_pHandle for packed read files
+        PackedReadFile* m_pPacked;
+        size_t m_packedIdx;
+
+        char* m_pBuffer;
+        size_t m_bufferSize;
+        size_t m_bufferPos;
+        size_t m_bufferEnd;
+        bool m_bEOF;
+
+        // Scratch strings reused between records
+        std::string m_header;
+        std::string m_seq;
+        std::string m_qual;
 };
 
 #endif
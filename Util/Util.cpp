@@ -10,6 +10,8 @@
 #include <math.h>
 #include <map>
 #include "Util.h"
+#include "BGZFStream.h"
+#include "PackedReadFile.h"
 
 //
 // Sequence operations
@@ -270,8 +272,18 @@ std::istream* createReader(const std::string& filename, std::ios_base::openmode
 {
     if(isGzip(filename))
     {
-        igzstream* pGZ = new igzstream(filename.c_str(), mode);
-        assertGZOpen(*pGZ, filename);
+        // BGZF blocks are decompressed in parallel, other gzip files on a read-ahead thread
+        std::istream* pGZ;
+        if(isBGZF(filename))
+            pGZ = new BGZFInputStream(filename);
+        else
+            pGZ = new GZReadAheadStream(filename);
+
+        if(!pGZ->good())
+        {
+            std::cerr << "Error: could not open " << filename << " for read\n";
+            exit(EXIT_FAILURE);
+        }
         return pGZ;
     }
     else
@@ -287,10 +299,32 @@ std::istream* createReader(const std::string& filename, std::ios_base::openmode
 std::ostream* createWriter(const std::string& filename,
                            std::ios_base::openmode mode)
 {
-    if(isGzip(filename))
+    if(isPackedReads(filename))
+    {
+        // The records are packed as they are written
+        if(mode & std::ios_base::app)
+        {
+            std::cerr << "Error: cannot append to the packed read file " << filename << "\n";
+            exit(EXIT_FAILURE);
+        }
+
+        PackedReadOutputStream* pPacked = new PackedReadOutputStream(filename);
+        if(!pPacked->good())
+        {
+            std::cerr << "Error: could not open " << filename << " for write\n";
+            exit(EXIT_FAILURE);
+        }
+        return pPacked;
+    }
+    else if(isGzip(filename))
     {
-        ogzstream* pGZ = new ogzstream(filename.c_str(), mode);
-        assertGZOpen(*pGZ, filename);
+        // Written as BGZF blocks compressed on a thread pool
+        BGZFOutputStream* pGZ = new BGZFOutputStream(filename, mode);
+        if(!pGZ->good())
+        {
+            std::cerr << "Error: could not open " << filename << " for write\n";
+            exit(EXIT_FAILURE);
+        }
         return pGZ;
     }
     else
@@ -129,32 +129,7 @@ struct SeqRecord
 };
 typedef std::vector<SeqRecord> SeqRecordVector;
 
-//Data structures used for PE mapping
-template<typename T>
-class ThreadSafeList: public std::list<T> {
-	public:
-		ThreadSafeList()
-		{
-			omp_init_lock (&m_lock);
-		}
-		
-		~ThreadSafeList(){
-			omp_destroy_lock(&m_lock);
-		}
-    
-		void setLock()
-		{ 
-			omp_set_lock (&m_lock);
-		}
-		void releaseLock()
-		{
-			omp_unset_lock (&m_lock);
-		}
-	
-	private:
-		omp_lock_t m_lock;
-};
-
+//Position of a PE read mapped to a contig end, see ReadContigMap
 enum ReadOnContig
 {
     AntisenseFwd,